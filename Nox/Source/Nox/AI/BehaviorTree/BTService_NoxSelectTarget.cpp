@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTService_NoxSelectTarget.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Bool.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Vector.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/AI/NoxAIController.h"
+#include "Nox/Diagnostics/NoxReplaySubsystem.h"
+
+UBTService_NoxSelectTarget::UBTService_NoxSelectTarget()
+{
+	NodeName = "Nox Select Target";
+
+	Interval = 0.5f;
+	RandomDeviation = 0.2f;
+
+	bNotifyBecomeRelevant = true;
+
+	TargetActorKey.SelectedKeyName = FName("TargetActor");
+	TargetActorKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTService_NoxSelectTarget, TargetActorKey), AActor::StaticClass());
+
+	CanSeeEnemyKey.SelectedKeyName = FName("CanSeeEnemy");
+	CanSeeEnemyKey.AddBoolFilter(this, GET_MEMBER_NAME_CHECKED(UBTService_NoxSelectTarget, CanSeeEnemyKey));
+
+	IsInAttackRangeKey.SelectedKeyName = FName("IsInAttackRange");
+	IsInAttackRangeKey.AddBoolFilter(this, GET_MEMBER_NAME_CHECKED(UBTService_NoxSelectTarget, IsInAttackRangeKey));
+
+	TargetLocationKey.AddVectorFilter(this, GET_MEMBER_NAME_CHECKED(UBTService_NoxSelectTarget, TargetLocationKey));
+	TargetLocationKey.AllowNoneAsValue(true);
+
+	AttackRange = 150.f;
+}
+
+void UBTService_NoxSelectTarget::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	// Key ids are resolved once, so runtime access does not search keys by name
+	if (UBlackboardData* BlackboardAsset = GetBlackboardAsset())
+	{
+		TargetActorKey.ResolveSelectedKey(*BlackboardAsset);
+		CanSeeEnemyKey.ResolveSelectedKey(*BlackboardAsset);
+		IsInAttackRangeKey.ResolveSelectedKey(*BlackboardAsset);
+		TargetLocationKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+FString UBTService_NoxSelectTarget::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("%s\nAttack range: %.0f"), *Super::GetStaticDescription(), AttackRange);
+}
+
+void UBTService_NoxSelectTarget::OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	Super::OnBecomeRelevant(OwnerComp, NodeMemory);
+
+	// Spread first updates of many NPCs over the interval
+	SetNextTickTime(NodeMemory, FMath::FRandRange(0.f, Interval));
+}
+
+void UBTService_NoxSelectTarget::TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	Super::TickNode(OwnerComp, NodeMemory, DeltaSeconds);
+
+	ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner());
+	APawn* Pawn = AIController != NULL ? AIController->GetPawn() : NULL;
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+
+	if (Pawn == NULL || BlackboardComp == NULL)
+	{
+		return;
+	}
+
+	const FVector PawnLocation = Pawn->GetActorLocation();
+
+	AActor* Target = NULL;
+	float TargetDistanceSquared = MAX_FLT;
+
+	for (const TWeakObjectPtr<AActor>& SeenActor : AIController->GetSeenActorPtrs())
+	{
+		const ANoxCharacter* SeenCharacter = Cast<ANoxCharacter>(SeenActor.Get());
+
+		if (SeenCharacter == NULL || !SeenCharacter->IsAlive() || AIController->GetTeamAttitudeTowards(*SeenCharacter) != ETeamAttitude::Hostile)
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(PawnLocation, SeenCharacter->GetActorLocation());
+		if (DistanceSquared < TargetDistanceSquared)
+		{
+			Target = SeenActor.Get();
+			TargetDistanceSquared = DistanceSquared;
+		}
+	}
+
+	if (BlackboardComp->GetValue<UBlackboardKeyType_Object>(TargetActorKey.GetSelectedKeyID()) != Target)
+	{
+		UNoxReplaySubsystem::RecordEvent(ENoxReplayEvent::RE_AITarget, Pawn, Target);
+	}
+
+	BlackboardComp->SetValue<UBlackboardKeyType_Object>(TargetActorKey.GetSelectedKeyID(), Target);
+	BlackboardComp->SetValue<UBlackboardKeyType_Bool>(CanSeeEnemyKey.GetSelectedKeyID(), Target != NULL);
+	BlackboardComp->SetValue<UBlackboardKeyType_Bool>(IsInAttackRangeKey.GetSelectedKeyID(), Target != NULL && TargetDistanceSquared <= FMath::Square(AttackRange));
+
+	if (Target != NULL && TargetLocationKey.IsSet())
+	{
+		BlackboardComp->SetValue<UBlackboardKeyType_Vector>(TargetLocationKey.GetSelectedKeyID(), Target->GetActorLocation());
+	}
+}
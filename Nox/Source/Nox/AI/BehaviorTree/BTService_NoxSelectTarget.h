@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTService.h"
+#include "BTService_NoxSelectTarget.generated.h"
+
+/**
+ * Pick the closest hostile, alive character seen by ANoxAIController and write it to blackboard.
+ * First update of every NPC is delayed by random part of the interval, so services of NPCs spawned together do not run in the same frame.
+ */
+UCLASS()
+class NOX_API UBTService_NoxSelectTarget : public UBTService
+{
+	GENERATED_BODY()
+
+public:
+	UBTService_NoxSelectTarget();
+
+	// Selected target (object)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector TargetActorKey;
+
+	// Is there any target (bool)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector CanSeeEnemyKey;
+
+	// Is target closer than AttackRange (bool)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector IsInAttackRangeKey;
+
+	// Optional, location of the target (vector)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector TargetLocationKey;
+
+	UPROPERTY(EditAnywhere, Category = "Target", Meta = (ClampMin = "0"))
+		float AttackRange;
+
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	virtual void OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+};
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTTask_NoxAdvancePatrolIndex.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Bool.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Int.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/AI/NoxPatrolPath.h"
+
+UBTTask_NoxAdvancePatrolIndex::UBTTask_NoxAdvancePatrolIndex()
+{
+	NodeName = "Nox Advance Patrol Index";
+
+	PatrolIndexKey.SelectedKeyName = FName("PatrolPathIndex");
+	PatrolIndexKey.AddIntFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxAdvancePatrolIndex, PatrolIndexKey));
+
+	DirectionForwardKey.SelectedKeyName = FName("IsPatrolDirectionForward");
+	DirectionForwardKey.AddBoolFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxAdvancePatrolIndex, DirectionForwardKey));
+}
+
+void UBTTask_NoxAdvancePatrolIndex::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	// Key ids are resolved once, so runtime access does not search keys by name
+	if (UBlackboardData* BlackboardAsset = GetBlackboardAsset())
+	{
+		PatrolIndexKey.ResolveSelectedKey(*BlackboardAsset);
+		DirectionForwardKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+EBTNodeResult::Type UBTTask_NoxAdvancePatrolIndex::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	ANoxCharacter* NoxCharacter = AIController != NULL ? AIController->GetPawn<ANoxCharacter>() : NULL;
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+
+	if (NoxCharacter == NULL || NoxCharacter->NativePatrolPath == NULL || BlackboardComp == NULL)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	const int32 NumPoints = NoxCharacter->NativePatrolPath->GetNumPoints();
+	if (NumPoints < 2)
+	{
+		return EBTNodeResult::Succeeded;
+	}
+
+	int32 PatrolIndex = BlackboardComp->GetValue<UBlackboardKeyType_Int>(PatrolIndexKey.GetSelectedKeyID());
+
+	if (NoxCharacter->NativePatrolPath->bIsLooping)
+	{
+		PatrolIndex = (PatrolIndex + 1) % NumPoints;
+	}
+	else
+	{
+		bool bIsDirectionForward = BlackboardComp->GetValue<UBlackboardKeyType_Bool>(DirectionForwardKey.GetSelectedKeyID());
+
+		// Turn back on both ends of the path
+		if (bIsDirectionForward && PatrolIndex >= NumPoints - 1)
+		{
+			bIsDirectionForward = false;
+		}
+		else if (!bIsDirectionForward && PatrolIndex <= 0)
+		{
+			bIsDirectionForward = true;
+		}
+
+		PatrolIndex = FMath::Clamp(PatrolIndex + (bIsDirectionForward ? 1 : -1), 0, NumPoints - 1);
+
+		BlackboardComp->SetValue<UBlackboardKeyType_Bool>(DirectionForwardKey.GetSelectedKeyID(), bIsDirectionForward);
+	}
+
+	BlackboardComp->SetValue<UBlackboardKeyType_Int>(PatrolIndexKey.GetSelectedKeyID(), PatrolIndex);
+
+	return EBTNodeResult::Succeeded;
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTTask_NoxAdvancePatrolIndex.generated.h"
+
+/**
+ * Move patrol index to the next point of ANoxCharacter::NativePatrolPath. Looping paths start again from the first point, other paths are walked back.
+ */
+UCLASS()
+class NOX_API UBTTask_NoxAdvancePatrolIndex : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UBTTask_NoxAdvancePatrolIndex();
+
+	// Index of current point (int)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector PatrolIndexKey;
+
+	// Direction of walking along not looping path (bool)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector DirectionForwardKey;
+
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTTask_NoxAttack.h"
+#include "AIController.h"
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Nox/NoxCharacter.h"
+
+UBTTask_NoxAttack::UBTTask_NoxAttack()
+{
+	NodeName = "Nox Attack";
+	bNotifyTick = true;
+
+	bWaitForAttackEnd = true;
+}
+
+EBTNodeResult::Type UBTTask_NoxAttack::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	ANoxCharacter* NoxCharacter = AIController != NULL ? AIController->GetPawn<ANoxCharacter>() : NULL;
+
+	if (NoxCharacter == NULL || !NoxCharacter->IsAlive() || !NoxCharacter->CanAttack())
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	NoxCharacter->Attack();
+
+	return bWaitForAttackEnd ? EBTNodeResult::InProgress : EBTNodeResult::Succeeded;
+}
+
+void UBTTask_NoxAttack::TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	ANoxCharacter* NoxCharacter = AIController != NULL ? AIController->GetPawn<ANoxCharacter>() : NULL;
+
+	if (NoxCharacter == NULL)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+		return;
+	}
+
+	UAnimInstance* AnimInstance = NoxCharacter->GetMesh()->GetAnimInstance();
+	if (AnimInstance == NULL || !AnimInstance->IsAnyMontagePlaying())
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Succeeded);
+	}
+}
+
+FString UBTTask_NoxAttack::GetStaticDescription() const
+{
+	return bWaitForAttackEnd ? TEXT("Attack and wait for attack end") : TEXT("Attack");
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTTask_NoxAttack.generated.h"
+
+/**
+ * Calls ANoxCharacter::Attack() on controlled pawn.
+ */
+UCLASS()
+class NOX_API UBTTask_NoxAttack : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UBTTask_NoxAttack();
+
+	// Task finishes when attack montage ends. Otherwise it finishes right after attack starts.
+	UPROPERTY(EditAnywhere, Category = "Attack")
+		bool bWaitForAttackEnd;
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	// Ticks only while task is waiting for attack end
+	virtual void TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTTask_NoxFindPatrolPoint.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Int.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Vector.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/AI/NoxPatrolPath.h"
+
+UBTTask_NoxFindPatrolPoint::UBTTask_NoxFindPatrolPoint()
+{
+	NodeName = "Nox Find Patrol Point";
+
+	PatrolIndexKey.SelectedKeyName = FName("PatrolPathIndex");
+	PatrolIndexKey.AddIntFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxFindPatrolPoint, PatrolIndexKey));
+
+	TargetLocationKey.SelectedKeyName = FName("TargetLocation");
+	TargetLocationKey.AddVectorFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxFindPatrolPoint, TargetLocationKey));
+}
+
+void UBTTask_NoxFindPatrolPoint::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	// Key ids are resolved once, so runtime access does not search keys by name
+	if (UBlackboardData* BlackboardAsset = GetBlackboardAsset())
+	{
+		PatrolIndexKey.ResolveSelectedKey(*BlackboardAsset);
+		TargetLocationKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+EBTNodeResult::Type UBTTask_NoxFindPatrolPoint::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	ANoxCharacter* NoxCharacter = AIController != NULL ? AIController->GetPawn<ANoxCharacter>() : NULL;
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+
+	if (NoxCharacter == NULL || NoxCharacter->NativePatrolPath == NULL || NoxCharacter->NativePatrolPath->GetNumPoints() == 0 || BlackboardComp == NULL)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	const int32 PatrolIndex = BlackboardComp->GetValue<UBlackboardKeyType_Int>(PatrolIndexKey.GetSelectedKeyID());
+	const int32 PointIndex = FMath::Clamp(PatrolIndex, 0, NoxCharacter->NativePatrolPath->GetNumPoints() - 1);
+
+	BlackboardComp->SetValue<UBlackboardKeyType_Vector>(TargetLocationKey.GetSelectedKeyID(), NoxCharacter->NativePatrolPath->GetWorldPoint(PointIndex));
+
+	return EBTNodeResult::Succeeded;
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTTask_NoxFindPatrolPoint.generated.h"
+
+/**
+ * Write location of current point of ANoxCharacter::NativePatrolPath to blackboard.
+ */
+UCLASS()
+class NOX_API UBTTask_NoxFindPatrolPoint : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UBTTask_NoxFindPatrolPoint();
+
+	// Index of current point (int)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector PatrolIndexKey;
+
+	// Location of current point (vector)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector TargetLocationKey;
+
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+};
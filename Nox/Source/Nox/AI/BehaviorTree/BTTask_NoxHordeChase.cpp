@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTTask_NoxHordeChase.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "Nox/AI/NoxAIController.h"
+
+UBTTask_NoxHordeChase::UBTTask_NoxHordeChase()
+{
+	NodeName = "Nox Horde Chase";
+	bNotifyTick = true;
+	bNotifyTaskFinished = true;
+
+	TargetActorKey.SelectedKeyName = FName("TargetActor");
+	TargetActorKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxHordeChase, TargetActorKey), AActor::StaticClass());
+
+	AcceptanceRadius = 150.f;
+}
+
+void UBTTask_NoxHordeChase::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	if (UBlackboardData* BlackboardAsset = GetBlackboardAsset())
+	{
+		TargetActorKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+EBTNodeResult::Type UBTTask_NoxHordeChase::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner());
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+
+	if (AIController == NULL || AIController->GetPawn() == NULL || BlackboardComp == NULL)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	AActor* TargetActor = Cast<AActor>(BlackboardComp->GetValue<UBlackboardKeyType_Object>(TargetActorKey.GetSelectedKeyID()));
+	if (TargetActor == NULL)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	if (AIController->GetPawn()->GetDistanceTo(TargetActor) <= AcceptanceRadius)
+	{
+		return EBTNodeResult::Succeeded;
+	}
+
+	AIController->StartHordeChase(TargetActor, AcceptanceRadius);
+
+	return EBTNodeResult::InProgress;
+}
+
+void UBTTask_NoxHordeChase::TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner());
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+	AActor* TargetActor = BlackboardComp != NULL ? Cast<AActor>(BlackboardComp->GetValue<UBlackboardKeyType_Object>(TargetActorKey.GetSelectedKeyID())) : NULL;
+
+	// Target was lost or changed by service, let tree decide again
+	if (AIController == NULL || AIController->GetPawn() == NULL || TargetActor == NULL || TargetActor != AIController->GetHordeGoal())
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+		return;
+	}
+
+	if (AIController->GetPawn()->GetDistanceTo(TargetActor) <= AcceptanceRadius)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Succeeded);
+	}
+}
+
+EBTNodeResult::Type UBTTask_NoxHordeChase::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	return EBTNodeResult::Aborted;
+}
+
+void UBTTask_NoxHordeChase::OnTaskFinished(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTNodeResult::Type TaskResult)
+{
+	if (ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner()))
+	{
+		AIController->StopHordeChase();
+	}
+
+	Super::OnTaskFinished(OwnerComp, NodeMemory, TaskResult);
+}
+
+FString UBTTask_NoxHordeChase::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Chase %s with horde flow field"), *TargetActorKey.SelectedKeyName.ToString());
+}
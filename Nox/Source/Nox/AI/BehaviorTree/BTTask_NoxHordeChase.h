@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTTask_NoxHordeChase.generated.h"
+
+/**
+ * Chase target with UNoxFlowFieldSubsystem. All NPCs chasing the same target share one flow field instead of finding their own paths.
+ * Finishes when target is within acceptance radius, fails when target is lost.
+ */
+UCLASS()
+class NOX_API UBTTask_NoxHordeChase : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UBTTask_NoxHordeChase();
+
+	// Actor to chase (object)
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector TargetActorKey;
+
+	UPROPERTY(EditAnywhere, Category = "Horde", Meta = (ClampMin = "0"))
+		float AcceptanceRadius;
+
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	virtual void TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+
+	virtual void OnTaskFinished(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTNodeResult::Type TaskResult) override;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTTask_NoxMoveTo.h"
+#include "AISystem.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Vector.h"
+#include "Nox/AI/NoxAIController.h"
+
+UBTTask_NoxMoveTo::UBTTask_NoxMoveTo()
+{
+	NodeName = "Nox Move To";
+	bNotifyTick = true;
+
+	GoalKey.SelectedKeyName = FName("TargetLocation");
+	GoalKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxMoveTo, GoalKey), AActor::StaticClass());
+	GoalKey.AddVectorFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_NoxMoveTo, GoalKey));
+
+	AcceptanceRadius = 50.f;
+}
+
+void UBTTask_NoxMoveTo::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	if (UBlackboardData* BlackboardAsset = GetBlackboardAsset())
+	{
+		GoalKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+EBTNodeResult::Type UBTTask_NoxMoveTo::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner());
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+
+	if (AIController == NULL || BlackboardComp == NULL)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	bool bIsRequested = false;
+
+	if (GoalKey.SelectedKeyType == UBlackboardKeyType_Object::StaticClass())
+	{
+		AActor* GoalActor = Cast<AActor>(BlackboardComp->GetValue<UBlackboardKeyType_Object>(GoalKey.GetSelectedKeyID()));
+		bIsRequested = AIController->MoveToActorAsync(GoalActor, AcceptanceRadius);
+	}
+	else
+	{
+		const FVector GoalLocation = BlackboardComp->GetValue<UBlackboardKeyType_Vector>(GoalKey.GetSelectedKeyID());
+		bIsRequested = FAISystem::IsValidLocation(GoalLocation) && AIController->MoveToLocationAsync(GoalLocation, AcceptanceRadius);
+	}
+
+	return bIsRequested ? EBTNodeResult::InProgress : EBTNodeResult::Failed;
+}
+
+void UBTTask_NoxMoveTo::TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner());
+
+	if (AIController == NULL)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+		return;
+	}
+
+	if (!AIController->IsAsyncMoveActive())
+	{
+		FinishLatentTask(OwnerComp, AIController->DidLastAsyncMoveSucceed() ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+	}
+}
+
+EBTNodeResult::Type UBTTask_NoxMoveTo::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	if (ANoxAIController* AIController = Cast<ANoxAIController>(OwnerComp.GetAIOwner()))
+	{
+		AIController->CancelAsyncMove();
+	}
+
+	return EBTNodeResult::Aborted;
+}
+
+FString UBTTask_NoxMoveTo::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Move to %s (async, shared path)"), *GoalKey.SelectedKeyName.ToString());
+}
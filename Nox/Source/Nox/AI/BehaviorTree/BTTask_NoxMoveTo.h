@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTTask_NoxMoveTo.generated.h"
+
+/**
+ * Move to actor or location with ANoxAIController::MoveToActorAsync(). Unlike Move To, path is never found on game thread
+ * and is shared with other NPCs moving between the same navmesh polygons.
+ */
+UCLASS()
+class NOX_API UBTTask_NoxMoveTo : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UBTTask_NoxMoveTo();
+
+	// Actor (object) or location (vector) to move to
+	UPROPERTY(EditAnywhere, Category = "Blackboard")
+		FBlackboardKeySelector GoalKey;
+
+	UPROPERTY(EditAnywhere, Category = "Move", Meta = (ClampMin = "0"))
+		float AcceptanceRadius;
+
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	virtual void TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+};
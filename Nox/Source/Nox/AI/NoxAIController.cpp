@@ -4,31 +4,53 @@
 #include "NoxAIController.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Perception/AISenseConfig_Sight.h"
+#include "Perception/AISense_Sight.h"
 #include "Nox/NoxCharacter.h"
-
-#include "Engine/Engine.h"
+#include "Nox/Combat/NoxTeamAttitude.h"
+#include "Nox/AI/NoxSightSubsystem.h"
+#include "Nox/AI/NoxAIScheduler.h"
+#include "Nox/AI/NoxFlowFieldSubsystem.h"
+#include "Nox/AI/NoxPathSubsystem.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "Nox/Significance/NoxSignificance.h"
 
 
 ANoxAIController::ANoxAIController()
 {
-	// Create AI perception and sight sense
+	// Create AI perception, sight is shared by all controllers in UNoxSightSubsystem
 	AIPerception = CreateDefaultSubobject<UAIPerceptionComponent>("AIPerception");
-	SightConfig = CreateDefaultSubobject<UAISenseConfig_Sight>(TEXT("Sight Config"));		
 
-	// Set default for sight sense	
+	// Configured only for blueprints that still use perception sight, see PostInitializeComponents()
+	SightConfig = CreateDefaultSubobject<UAISenseConfig_Sight>(TEXT("Sight Config"));
 	SightConfig->SightRadius = 300.0f;
 	SightConfig->LoseSightRadius = 350.0f;
 	SightConfig->PeripheralVisionAngleDegrees = 360.0f;
-
 	SightConfig->DetectionByAffiliation.bDetectEnemies = true;
 	SightConfig->DetectionByAffiliation.bDetectNeutrals = true;
 	SightConfig->DetectionByAffiliation.bDetectFriendlies = true;
 
-	AIPerception->ConfigureSense(*SightConfig);	
-	
+	// Set default for sight
+	SightRadius = 300.0f;
+	LoseSightRadius = 350.0f;
+	bIsSightEnabled = true;
+	bUsePerceptionSight = false;
+
+	AsyncPathRequestSerial = 0;
+	bIsAsyncMovePending = false;
+	bLastAsyncMoveSucceeded = false;
+}
 
-	TeamId = FGenericTeamId(255);
+void ANoxAIController::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
 
+	// Blueprint events are bound by now. Controllers that react to OnTargetPerceptionUpdated (NoxAIController_BP) keep perception sight until they move to OnSightUpdated.
+	bUsePerceptionSight = AIPerception->OnTargetPerceptionUpdated.IsBound();
+	if (bUsePerceptionSight)
+	{
+		AIPerception->ConfigureSense(*SightConfig);
+		AIPerception->OnTargetPerceptionUpdated.AddDynamic(this, &ANoxAIController::OnPerceptionUpdated);
+	}
 }
 
 void ANoxAIController::BeginPlay()
@@ -37,78 +59,327 @@ void ANoxAIController::BeginPlay()
 	
 }
 
+void ANoxAIController::SetGenericTeamId(const FGenericTeamId& NewTeamId)
+{
+	Super::SetGenericTeamId(NewTeamId);
+
+	if (ANoxCharacter* NoxCharacter = GetControlledNoxCharacter())
+	{
+		NoxCharacter->SetGenericTeamId(NewTeamId);
+	}
+}
+
 ETeamAttitude::Type ANoxAIController::GetTeamAttitudeTowards(const AActor& Other) const
 {
-	return ETeamAttitude::Type();
+	return FNoxTeamAttitude::GetAttitudeTowards(GetGenericTeamId(), Other);
+}
 
-	// Check if Actor is a pawn
-	auto OtherPawn = Cast<APawn>(&Other);
-	if (OtherPawn == nullptr)
+ANoxCharacter* ANoxAIController::GetControlledNoxCharacter() const
+{
+	return GetPawn<ANoxCharacter>();
+}
+
+void ANoxAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	// Pawn caches team of its controller
+	if (ANoxCharacter* NoxCharacter = Cast<ANoxCharacter>(InPawn))
 	{
-		return ETeamAttitude::Neutral;
+		NoxCharacter->SetGenericTeamId(GetGenericTeamId());
 	}
 
-	// Check if Actori (Bot or Player) implements IGenericTeamAgentInterface.
-	auto igtaiActorBot = Cast<IGenericTeamAgentInterface>(OtherPawn->GetController()); // ActorBot
-	auto igtaiActorPlayer = Cast<IGenericTeamAgentInterface>(&Other); // ActorPlayer
-	if (igtaiActorBot == nullptr && igtaiActorPlayer == nullptr)
+	UNoxSightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UNoxSightSubsystem>();
+	if (SightSubsystem != NULL && !bUsePerceptionSight)
 	{
-		return ETeamAttitude::Neutral;
+		SightSubsystem->RegisterListener(this);
 	}
 
-	if (igtaiActorBot != nullptr) // Print ActorBot TeamID
+	// Behavior tree is updated by scheduler, not by its own tick
+	if (UNoxAISchedulerSubsystem* AIScheduler = GetWorld()->GetSubsystem<UNoxAISchedulerSubsystem>())
+	{
+		AIScheduler->RegisterController(this);
+	}
+}
+
+void ANoxAIController::OnUnPossess()
+{
+	StopHordeChase();
+	CancelAsyncMove();
+
+	if (UNoxSightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UNoxSightSubsystem>())
 	{
-		FGenericTeamId fgtiActorBotTeamId = igtaiActorBot->GetGenericTeamId();
-		int iActorBotTeamId = (int)fgtiActorBotTeamId;
-		FString fstrActorBotTeamId = FString::FromInt(iActorBotTeamId);
-		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Green, fstrActorBotTeamId);
+		SightSubsystem->UnregisterListener(this);
 	}
+	SeenActors.Empty();
 
-	if (igtaiActorPlayer != nullptr) // Print ActorPlayer TeamID
+	if (UNoxAISchedulerSubsystem* AIScheduler = GetWorld()->GetSubsystem<UNoxAISchedulerSubsystem>())
 	{
-		FGenericTeamId fgtiActorPlayerTeamId = igtaiActorPlayer->GetGenericTeamId();
-		int iActorPlayerTeamId = (int)fgtiActorPlayerTeamId;
-		FString fstrActorPlayerTeamId = FString::FromInt(iActorPlayerTeamId);
-		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Green, fstrActorPlayerTeamId);
+		AIScheduler->UnregisterController(this);
 	}
 
-	// Get the TeamId of the Actor (Bot or Player)
-	FGenericTeamId fgtiOtherActorTeamId = NULL;
-	if (igtaiActorBot != nullptr)
+	Super::OnUnPossess();
+}
+
+void ANoxAIController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopHordeChase();
+
+	if (UNoxSightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UNoxSightSubsystem>())
 	{
-		fgtiOtherActorTeamId = igtaiActorBot->GetGenericTeamId();
+		SightSubsystem->UnregisterListener(this);
 	}
-	else if (igtaiActorPlayer != nullptr)
+
+	if (UNoxAISchedulerSubsystem* AIScheduler = GetWorld()->GetSubsystem<UNoxAISchedulerSubsystem>())
 	{
-		fgtiOtherActorTeamId = igtaiActorPlayer->GetGenericTeamId();
+		AIScheduler->UnregisterController(this);
 	}
 
-	// Determines ThisBot attitude towards OtherActor (Bot or Player) as either Neutral, Friendly, or Hostile.
+	Super::EndPlay(EndPlayReason);
+}
 
-	FGenericTeamId fgtiThisBotTeamId = this->GetGenericTeamId();
-	if (fgtiOtherActorTeamId == 255) // The are not on the team
-	{			
-		return ETeamAttitude::Neutral;	
+void ANoxAIController::OnSightChanged(AActor* Actor, const bool bIsSeen)
+{
+	if (bIsSeen)
+	{
+		SeenActors.AddUnique(Actor);
 	}
-	else if (fgtiThisBotTeamId == fgtiOtherActorTeamId)	 // They are on the same team
+	else
 	{
-		return ETeamAttitude::Friendly;
+		SeenActors.Remove(Actor);
 	}
-	else // they are on different teams
+
+	// Leave nav walking before fight starts, go back to it when fight is over
+	if (ANoxCharacter* NoxCharacter = GetControlledNoxCharacter())
+	{
+		FNoxSignificance::UpdateMovementMode(NoxCharacter);
+	}
+
+	// Blueprint bridge
+	if (OnSightUpdated.IsBound())
 	{
-		return ETeamAttitude::Hostile;
+		OnSightUpdated.Broadcast(Actor, bIsSeen);
 	}
 }
 
-ANoxCharacter* ANoxAIController::GetControlledNoxCharacter() const
+void ANoxAIController::SetSightEnabled(const bool bEnabled)
 {
-	return GetPawn<ANoxCharacter>();
+	bIsSightEnabled = bEnabled;
+
+	if (bUsePerceptionSight)
+	{
+		AIPerception->SetSenseEnabled(UAISense_Sight::StaticClass(), bEnabled);
+	}
 }
 
-void ANoxAIController::OnPossess(APawn* InPawn)
+void ANoxAIController::OnPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus)
 {
-	Super::OnPossess(InPawn);
+	// Same bookkeeping as sight of UNoxSightSubsystem, so native code does not care where sight came from
+	if (Actor != NULL && Stimulus.Type == UAISense::GetSenseID<UAISense_Sight>())
+	{
+		OnSightChanged(Actor, Stimulus.WasSuccessfullySensed());
+	}
+}
 
-	
+bool ANoxAIController::IsEngaged() const
+{
+	const ANoxCharacter* NoxCharacter = GetControlledNoxCharacter();
+	if (NoxCharacter != NULL && NoxCharacter->IsAttacking())
+	{
+		return true;
+	}
+
+	for (const TWeakObjectPtr<AActor>& SeenActor : SeenActors)
+	{
+		if (SeenActor.IsValid() && GetTeamAttitudeTowards(*SeenActor) == ETeamAttitude::Hostile)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ANoxAIController::GetSeenActors(TArray<AActor*>& OutActors) const
+{
+	OutActors.Reset(SeenActors.Num());
+
+	for (const TWeakObjectPtr<AActor>& SeenActor : SeenActors)
+	{
+		if (SeenActor.IsValid())
+		{
+			OutActors.Add(SeenActor.Get());
+		}
+	}
+}
+
+
+void ANoxAIController::StartHordeChase(AActor* Goal, float AcceptanceRadius)
+{
+	UNoxFlowFieldSubsystem* FlowFieldSubsystem = GetWorld()->GetSubsystem<UNoxFlowFieldSubsystem>();
+	if (FlowFieldSubsystem == NULL || GetPawn() == NULL || Goal == NULL)
+	{
+		return;
+	}
+
+	// Path following would fight with flow field movement
+	StopMovement();
+
+	HordeGoal = Goal;
+	FlowFieldSubsystem->AddAgent(GetPawn(), Goal, AcceptanceRadius);
+}
+
+void ANoxAIController::StopHordeChase()
+{
+	if (HordeGoal.IsExplicitlyNull())
+	{
+		return;
+	}
+
+	HordeGoal.Reset();
+
+	if (UNoxFlowFieldSubsystem* FlowFieldSubsystem = GetWorld()->GetSubsystem<UNoxFlowFieldSubsystem>())
+	{
+		FlowFieldSubsystem->RemoveAgent(GetPawn());
+	}
+}
+
+void ANoxAIController::OnHordeGoalLost()
+{
+	HordeGoal.Reset();
+}
+
+bool ANoxAIController::MoveToActorAsync(AActor* Goal, float AcceptanceRadius)
+{
+	return Goal != NULL && RequestAsyncMove(Goal, Goal->GetActorLocation(), AcceptanceRadius);
+}
+
+bool ANoxAIController::MoveToLocationAsync(const FVector& Goal, float AcceptanceRadius)
+{
+	return RequestAsyncMove(NULL, Goal, AcceptanceRadius);
 }
 
+bool ANoxAIController::RequestAsyncMove(AActor* GoalActor, const FVector& GoalLocation, const float AcceptanceRadius)
+{
+	UNoxPathSubsystem* PathSubsystem = GetWorld()->GetSubsystem<UNoxPathSubsystem>();
+	if (PathSubsystem == NULL)
+	{
+		return false;
+	}
+
+	// Results of older requests are ignored
+	AsyncPathRequestSerial++;
+
+	// Same check as AAIController::MoveTo(), path following would finish the move before its id is known
+	UPathFollowingComponent* PathFollowing = GetPathFollowingComponent();
+	if (PathFollowing != NULL && GetPawn() != NULL)
+	{
+		const bool bIsAtGoal = GoalActor != NULL
+			? PathFollowing->HasReached(*GoalActor, EPathFollowingReachMode::OverlapAgentAndGoal, AcceptanceRadius)
+			: PathFollowing->HasReached(GoalLocation, EPathFollowingReachMode::OverlapAgentAndGoal, AcceptanceRadius);
+
+		if (bIsAtGoal)
+		{
+			// Previous async move is not needed anymore
+			if (AsyncMoveRequestId.IsValid() && GetCurrentMoveRequestID() == AsyncMoveRequestId)
+			{
+				StopMovement();
+			}
+			AsyncMoveRequestId = FAIRequestID::InvalidRequest;
+
+			bIsAsyncMovePending = false;
+			bLastAsyncMoveSucceeded = true;
+			return true;
+		}
+	}
+
+	bIsAsyncMovePending = true;
+	bLastAsyncMoveSucceeded = false;
+
+	// Cached path starts move before this returns, so pending flag is set first
+	if (!PathSubsystem->RequestMove(this, GoalActor, GoalLocation, AcceptanceRadius, AsyncPathRequestSerial))
+	{
+		bIsAsyncMovePending = false;
+		return false;
+	}
+
+	return true;
+}
+
+void ANoxAIController::CancelAsyncMove()
+{
+	AsyncPathRequestSerial++;
+	bIsAsyncMovePending = false;
+
+	if (AsyncMoveRequestId.IsValid() && GetCurrentMoveRequestID() == AsyncMoveRequestId)
+	{
+		StopMovement();
+	}
+
+	AsyncMoveRequestId = FAIRequestID::InvalidRequest;
+}
+
+bool ANoxAIController::IsAsyncMoveActive() const
+{
+	if (bIsAsyncMovePending)
+	{
+		return true;
+	}
+
+	return AsyncMoveRequestId.IsValid() && GetMoveStatus() != EPathFollowingStatus::Idle && GetCurrentMoveRequestID() == AsyncMoveRequestId;
+}
+
+void ANoxAIController::OnAsyncPathFound(FNavPathSharedPtr Path, AActor* GoalActor, const FVector& GoalLocation, const float AcceptanceRadius, const bool bIsUpdate)
+{
+	// Chased actor moved, keep the move running with new path
+	if (bIsUpdate)
+	{
+		if (IsAsyncMoveActive() && GetPathFollowingComponent() != NULL)
+		{
+			GetPathFollowingComponent()->UpdateMove(Path.ToSharedRef(), AsyncMoveRequestId);
+		}
+		return;
+	}
+
+	bIsAsyncMovePending = false;
+
+	FAIMoveRequest MoveRequest;
+	if (GoalActor != NULL)
+	{
+		MoveRequest.SetGoalActor(GoalActor);
+	}
+	else
+	{
+		MoveRequest.SetGoalLocation(GoalLocation);
+	}
+	MoveRequest.SetAcceptanceRadius(AcceptanceRadius);
+
+	AsyncMoveRequestId = RequestMove(MoveRequest, Path);
+
+	if (!AsyncMoveRequestId.IsValid())
+	{
+		bLastAsyncMoveSucceeded = false;
+	}
+	else if (GetMoveStatus() == EPathFollowingStatus::Idle)
+	{
+		// Goal was reached while path was being found. Move finished inside RequestMove(), before OnMoveCompleted() knew its id.
+		bLastAsyncMoveSucceeded = true;
+	}
+}
+
+void ANoxAIController::OnAsyncPathFailed()
+{
+	bIsAsyncMovePending = false;
+	bLastAsyncMoveSucceeded = false;
+	AsyncMoveRequestId = FAIRequestID::InvalidRequest;
+}
+
+void ANoxAIController::OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result)
+{
+	if (RequestID == AsyncMoveRequestId)
+	{
+		bLastAsyncMoveSucceeded = Result.IsSuccess();
+	}
+
+	Super::OnMoveCompleted(RequestID, Result);
+}
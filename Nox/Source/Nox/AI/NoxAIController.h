@@ -4,8 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "AIController.h"
+#include "Perception/AIPerceptionTypes.h"
 #include "NoxAIController.generated.h"
 
+/** Called when controller starts or stops seeing an actor **/
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FNoxSightChangedDelegate, AActor*, Actor, bool, bIsSeen);
+
 /**
  * 
  */
@@ -14,11 +18,11 @@ class NOX_API ANoxAIController : public AAIController
 {
 	GENERATED_BODY()
 
-	/** Perception for AI **/
+	/** Perception for AI. Sight is done by UNoxSightSubsystem, other senses can be configured here. **/
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI Perception", meta = (AllowPrivateAccess = "true"))
 	class UAIPerceptionComponent* AIPerception;
 
-	/** Sight config for AI **/
+	/** Sight config for controllers that still use perception sight, see UsesPerceptionSight() **/
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI Perception Senses", meta = (AllowPrivateAccess = "true"))
 		class UAISenseConfig_Sight* SightConfig;
 
@@ -26,13 +30,15 @@ public:
 	ANoxAIController();	
 
 protected:
+	virtual void PostInitializeComponents() override;
+
 	virtual void BeginPlay() override;	
 
-private:
-	FGenericTeamId TeamId;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
-	virtual FGenericTeamId GetGenericTeamId() const override { return TeamId; }
+	// Team is stored by AAIController and cached on the controlled ANoxCharacter too
+	virtual void SetGenericTeamId(const FGenericTeamId& NewTeamId) override;
 	virtual ETeamAttitude::Type GetTeamAttitudeTowards(const AActor& Other) const override;
 
 public:
@@ -41,7 +47,108 @@ public:
 
 protected:	
 	virtual void OnPossess(APawn* InPawn) override;	
-	
+
+	virtual void OnUnPossess() override;
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Sight")
+		float SightRadius;
+
+	// Actor that is already seen is lost when it is farther than this
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Sight")
+		float LoseSightRadius;
+
+	UPROPERTY(BlueprintAssignable, Category = "AI Sight")
+		FNoxSightChangedDelegate OnSightUpdated;
+
+	// Called by UNoxSightSubsystem when controller starts or stops seeing an actor
+	virtual void OnSightChanged(AActor* Actor, const bool bIsSeen);
+
+	// Turned off by significance for far away characters
+	void SetSightEnabled(const bool bEnabled);
+
+	FORCEINLINE bool IsSightEnabled() const { return bIsSightEnabled; }
+
+	// Blueprint handles AIPerception OnTargetPerceptionUpdated, so sight comes from perception sight sense (SightConfig) instead of UNoxSightSubsystem
+	FORCEINLINE bool UsesPerceptionSight() const { return bUsePerceptionSight; }
+
+	// Controlled character attacks or sees a hostile character
+	bool IsEngaged() const;
+
+	// Actors seen right now, some can be already destroyed
+	FORCEINLINE const TArray<TWeakObjectPtr<AActor>>& GetSeenActorPtrs() const { return SeenActors; }
+
+	UFUNCTION(BlueprintCallable, Category = "AI Sight")
+		void GetSeenActors(TArray<AActor*>& OutActors) const;
+
+private:
+	bool bIsSightEnabled;
+
+	bool bUsePerceptionSight;
+
+	UFUNCTION()
+		void OnPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus);
+
+	TArray<TWeakObjectPtr<AActor>> SeenActors;
+
+public:
+	// Move controlled pawn toward goal with flow field shared by all NPCs chasing the same goal
+	UFUNCTION(BlueprintCallable, Category = "AI Horde")
+		void StartHordeChase(AActor* Goal, float AcceptanceRadius);
+
+	UFUNCTION(BlueprintCallable, Category = "AI Horde")
+		void StopHordeChase();
+
+	FORCEINLINE AActor* GetHordeGoal() const { return HordeGoal.Get(); }
+
+	// Called by UNoxFlowFieldSubsystem when goal was destroyed, pawn is already removed from its field. Horde chase task fails, so tree picks a new target.
+	void OnHordeGoalLost();
+
+private:
+	TWeakObjectPtr<AActor> HordeGoal;
+
+public:
+	/** Move with path found by UNoxPathSubsystem. Path is found asynchronously or taken from cache, path of moving goal is updated.
+	*@return - False when start or goal is not on navmesh
+	*/
+	UFUNCTION(BlueprintCallable, Category = "AI Navigation")
+		bool MoveToActorAsync(AActor* Goal, float AcceptanceRadius);
+
+	UFUNCTION(BlueprintCallable, Category = "AI Navigation")
+		bool MoveToLocationAsync(const FVector& Goal, float AcceptanceRadius);
+
+	// Forget path that was not found yet and stop current async move
+	UFUNCTION(BlueprintCallable, Category = "AI Navigation")
+		void CancelAsyncMove();
+
+	// Path is still being found
+	FORCEINLINE bool IsAsyncMovePending() const { return bIsAsyncMovePending; }
+
+	// Path is being found or followed
+	bool IsAsyncMoveActive() const;
+
+	FORCEINLINE bool DidLastAsyncMoveSucceed() const { return bLastAsyncMoveSucceeded; }
+
+	// Increased by every async move request, older results are ignored
+	FORCEINLINE uint32 GetAsyncPathRequestSerial() const { return AsyncPathRequestSerial; }
+
+	// Called by UNoxPathSubsystem
+	void OnAsyncPathFound(FNavPathSharedPtr Path, AActor* GoalActor, const FVector& GoalLocation, const float AcceptanceRadius, const bool bIsUpdate);
+	void OnAsyncPathFailed();
+
+	virtual void OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result) override;
+
+private:
+	uint32 AsyncPathRequestSerial;
+
+	bool bIsAsyncMovePending;
+
+	bool bLastAsyncMoveSucceeded;
+
+	FAIRequestID AsyncMoveRequestId;
+
+	bool RequestAsyncMove(AActor* GoalActor, const FVector& GoalLocation, const float AcceptanceRadius);
+
 public:
 	/** Returns AIPerception subobject **/
 	FORCEINLINE class UAIPerceptionComponent* GetAIPerception() const { return AIPerception; }
@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxAIScheduler.h"
+#include "Nox/Nox.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/Diagnostics/NoxReplaySubsystem.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/AI/NoxAIController.h"
+#include "BrainComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Scheduler"), STAT_NoxAIScheduler, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Updated High"), STAT_NoxAIUpdatedHigh, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Updated Medium"), STAT_NoxAIUpdatedMedium, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Updated Low"), STAT_NoxAIUpdatedLow, STATGROUP_Nox);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Max Wait High (ms)"), STAT_NoxAIWaitHigh, STATGROUP_Nox);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Max Wait Medium (ms)"), STAT_NoxAIWaitMedium, STATGROUP_Nox);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Max Wait Low (ms)"), STAT_NoxAIWaitLow, STATGROUP_Nox);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Cost High (ms)"), STAT_NoxAICostHigh, STATGROUP_Nox);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Cost Medium (ms)"), STAT_NoxAICostMedium, STATGROUP_Nox);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Cost Low (ms)"), STAT_NoxAICostLow, STATGROUP_Nox);
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxAISchedulerSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxAISchedulerSettings::UNoxAISchedulerSettings()
+{
+	TimeBudgetUs = 2000.f;
+
+	BucketUpdateIntervals.Add(0.f);
+	BucketUpdateIntervals.Add(0.1f);
+	BucketUpdateIntervals.Add(0.3f);
+}
+
+float UNoxAISchedulerSettings::GetBucketUpdateInterval(ENoxAIPriority Priority) const
+{
+	if (BucketUpdateIntervals.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	// Missing buckets use interval of the last one specified
+	return BucketUpdateIntervals[FMath::Min((int32)Priority, BucketUpdateIntervals.Num() - 1)];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxAISchedulerSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxAISchedulerSubsystem::Deinitialize()
+{
+	Controllers.Empty();
+
+	for (FBucket& Bucket : Buckets)
+	{
+		Bucket.Members.Empty();
+	}
+
+	Super::Deinitialize();
+}
+
+bool UNoxAISchedulerSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && Controllers.Num() > 0;
+}
+
+TStatId UNoxAISchedulerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxAISchedulerSubsystem, STATGROUP_Nox);
+}
+
+void UNoxAISchedulerSubsystem::RegisterController(ANoxAIController* Controller)
+{
+	if (Controller == NULL)
+	{
+		return;
+	}
+
+	for (const FScheduledController& ScheduledController : Controllers)
+	{
+		if (ScheduledController.Controller == Controller)
+		{
+			return;
+		}
+	}
+
+	FScheduledController& ScheduledController = Controllers.AddDefaulted_GetRef();
+	ScheduledController.Controller = Controller;
+	ScheduledController.LastUpdateTime = GetWorld()->GetTimeSeconds();
+
+	SetBrainTickEnabled(Controller, false);
+}
+
+void UNoxAISchedulerSubsystem::UnregisterController(ANoxAIController* Controller)
+{
+	for (FScheduledController& ScheduledController : Controllers)
+	{
+		if (ScheduledController.Controller == Controller)
+		{
+			// Can be called from inside of a brain update, so entry is only cleared and removed in FillBuckets()
+			ScheduledController.Controller.Reset();
+			break;
+		}
+	}
+
+	if (Controller != NULL)
+	{
+		SetBrainTickEnabled(Controller, true);
+	}
+}
+
+void UNoxAISchedulerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxAIScheduler);
+	NOX_HITCH_SCOPE(HS_AIScheduler);
+
+	FillBuckets();
+
+	const UNoxAISchedulerSettings* Settings = GetDefault<UNoxAISchedulerSettings>();
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const double FrameStartTime = FPlatformTime::Seconds();
+	const double TimeBudget = Settings->TimeBudgetUs * 0.000001;
+
+	float MaxWaitTime[(int32)ENoxAIPriority::AP_MAX] = {};
+	double Cost[(int32)ENoxAIPriority::AP_MAX] = {};
+	int32 NumUpdated[(int32)ENoxAIPriority::AP_MAX] = {};
+
+	int32 TotalUpdated = 0;
+	int32 TotalChecked = 0;
+	bool bIsBudgetUsed = false;
+
+	// Replay checks the same controllers as the recorded frame, wall clock would pick different ones
+	const int32 ReplayedCount = UNoxReplaySubsystem::GetReplayedBudgetCount(ENoxReplayBudget::RB_AIScheduler);
+
+	for (int32 BucketIndex = 0; BucketIndex < (int32)ENoxAIPriority::AP_MAX && !bIsBudgetUsed; BucketIndex++)
+	{
+		FBucket& Bucket = Buckets[BucketIndex];
+		const int32 NumMembers = Bucket.Members.Num();
+		const float UpdateInterval = Settings->GetBucketUpdateInterval((ENoxAIPriority)BucketIndex);
+
+		int32 NumChecked = 0;
+		for (; NumChecked < NumMembers; NumChecked++)
+		{
+			// At least one controller is updated every frame, so none of them waits forever
+			const bool bIsOverBudget = ReplayedCount != INDEX_NONE ? TotalChecked >= ReplayedCount : FPlatformTime::Seconds() - FrameStartTime > TimeBudget && TotalUpdated > 0;
+			if (bIsOverBudget)
+			{
+				bIsBudgetUsed = true;
+				break;
+			}
+			TotalChecked++;
+
+			// Brain update can register new controllers, so entry is accessed by index
+			const int32 ControllerIndex = Bucket.Members[(Bucket.NextMember + NumChecked) % NumMembers];
+			ANoxAIController* Controller = Controllers[ControllerIndex].Controller.Get();
+			const float ElapsedTime = CurrentTime - Controllers[ControllerIndex].LastUpdateTime;
+
+			if (Controller == NULL || ElapsedTime < UpdateInterval)
+			{
+				continue;
+			}
+
+			const double UpdateStartTime = FPlatformTime::Seconds();
+
+			UpdateBrain(Controller, ElapsedTime);
+			Controllers[ControllerIndex].LastUpdateTime = CurrentTime;
+
+			Cost[BucketIndex] += FPlatformTime::Seconds() - UpdateStartTime;
+			MaxWaitTime[BucketIndex] = FMath::Max(MaxWaitTime[BucketIndex], ElapsedTime);
+			NumUpdated[BucketIndex]++;
+			TotalUpdated++;
+		}
+
+		// Next frame starts from the first controller that was not checked
+		Bucket.NextMember = NumMembers > 0 ? (Bucket.NextMember + NumChecked) % NumMembers : 0;
+	}
+
+	UNoxReplaySubsystem::RecordBudgetCount(ENoxReplayBudget::RB_AIScheduler, TotalChecked);
+
+	SET_DWORD_STAT(STAT_NoxAIUpdatedHigh, NumUpdated[(int32)ENoxAIPriority::AP_High]);
+	SET_DWORD_STAT(STAT_NoxAIUpdatedMedium, NumUpdated[(int32)ENoxAIPriority::AP_Medium]);
+	SET_DWORD_STAT(STAT_NoxAIUpdatedLow, NumUpdated[(int32)ENoxAIPriority::AP_Low]);
+	SET_FLOAT_STAT(STAT_NoxAIWaitHigh, MaxWaitTime[(int32)ENoxAIPriority::AP_High] * 1000.f);
+	SET_FLOAT_STAT(STAT_NoxAIWaitMedium, MaxWaitTime[(int32)ENoxAIPriority::AP_Medium] * 1000.f);
+	SET_FLOAT_STAT(STAT_NoxAIWaitLow, MaxWaitTime[(int32)ENoxAIPriority::AP_Low] * 1000.f);
+	SET_FLOAT_STAT(STAT_NoxAICostHigh, Cost[(int32)ENoxAIPriority::AP_High] * 1000.0);
+	SET_FLOAT_STAT(STAT_NoxAICostMedium, Cost[(int32)ENoxAIPriority::AP_Medium] * 1000.0);
+	SET_FLOAT_STAT(STAT_NoxAICostLow, Cost[(int32)ENoxAIPriority::AP_Low] * 1000.0);
+}
+
+void UNoxAISchedulerSubsystem::FillBuckets()
+{
+	for (FBucket& Bucket : Buckets)
+	{
+		Bucket.Members.Reset();
+	}
+
+	for (int32 Index = Controllers.Num() - 1; Index >= 0; Index--)
+	{
+		if (!Controllers[Index].Controller.IsValid())
+		{
+			Controllers.RemoveAtSwap(Index);
+		}
+	}
+
+	// Priority can change every frame (e.g. NPC sees enemy), so controllers are sorted into buckets again
+	for (int32 Index = 0; Index < Controllers.Num(); Index++)
+	{
+		Buckets[(int32)GetPriority(Controllers[Index].Controller.Get())].Members.Add(Index);
+	}
+}
+
+ENoxAIPriority UNoxAISchedulerSubsystem::GetPriority(const ANoxAIController* Controller)
+{
+	const ANoxCharacter* NoxCharacter = Controller->GetControlledNoxCharacter();
+	if (NoxCharacter == NULL)
+	{
+		return ENoxAIPriority::AP_Low;
+	}
+
+	if (Controller->IsEngaged() || NoxCharacter->GetSignificanceTier() == ENoxSignificanceTier::ST_High)
+	{
+		return ENoxAIPriority::AP_High;
+	}
+
+	return NoxCharacter->GetSignificanceTier() == ENoxSignificanceTier::ST_Medium ? ENoxAIPriority::AP_Medium : ENoxAIPriority::AP_Low;
+}
+
+void UNoxAISchedulerSubsystem::UpdateBrain(ANoxAIController* Controller, const float DeltaTime)
+{
+	UBrainComponent* BrainComponent = Controller->GetBrainComponent();
+	if (BrainComponent == NULL || !BrainComponent->IsRegistered())
+	{
+		return;
+	}
+
+	// Behavior tree is usually started after possession, so its tick is turned off when it is found
+	if (BrainComponent->IsComponentTickEnabled())
+	{
+		BrainComponent->SetComponentTickEnabled(false);
+	}
+
+	BrainComponent->TickComponent(DeltaTime, LEVELTICK_All, &BrainComponent->PrimaryComponentTick);
+}
+
+void UNoxAISchedulerSubsystem::SetBrainTickEnabled(ANoxAIController* Controller, const bool bEnabled)
+{
+	if (UBrainComponent* BrainComponent = Controller->GetBrainComponent())
+	{
+		BrainComponent->SetComponentTickEnabled(bEnabled);
+	}
+}
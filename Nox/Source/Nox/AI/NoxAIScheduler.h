@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/DeveloperSettings.h"
+#include "NoxAIScheduler.generated.h"
+
+UENUM(BlueprintType)
+enum class ENoxAIPriority : uint8
+{
+	// Engaged in combat or close to the camera
+	AP_High		UMETA(DisplayName = "High"),
+	AP_Medium	UMETA(DisplayName = "Medium"),
+	AP_Low		UMETA(DisplayName = "Low"),
+	AP_MAX		UMETA(Hidden)
+};
+
+/**
+ * Settings of AI update scheduler. Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox AI Scheduler"))
+class NOX_API UNoxAISchedulerSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxAISchedulerSettings();
+
+	// Time in microseconds that controller updates can use every frame
+	UPROPERTY(config, EditAnywhere, Category = "Scheduler")
+		float TimeBudgetUs;
+
+	// Minimal time in seconds between updates of one controller, for every ENoxAIPriority from High to Low
+	UPROPERTY(config, EditAnywhere, Category = "Scheduler")
+		TArray<float> BucketUpdateIntervals;
+
+	float GetBucketUpdateInterval(ENoxAIPriority Priority) const;
+};
+
+/**
+ * Updates brains (behavior trees) of all ANoxAIController instead of letting them tick in the same frame.
+ * Controllers are put into priority buckets every frame. Buckets are served from High to Low, round-robin inside a bucket,
+ * until time budget of the frame is used. Every updated brain gets real time elapsed since its previous update.
+ */
+UCLASS()
+class NOX_API UNoxAISchedulerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	// Brain of the controller stops ticking by itself and is updated by scheduler
+	void RegisterController(class ANoxAIController* Controller);
+
+	// Brain of the controller ticks by itself again
+	void UnregisterController(class ANoxAIController* Controller);
+
+private:
+	struct FScheduledController
+	{
+		TWeakObjectPtr<class ANoxAIController> Controller;
+		float LastUpdateTime;
+	};
+
+	struct FBucket
+	{
+		// Indices of Controllers, rebuilt every frame
+		TArray<int32> Members;
+
+		// Member that is checked first in next frame
+		int32 NextMember = 0;
+	};
+
+	TArray<FScheduledController> Controllers;
+
+	FBucket Buckets[(int32)ENoxAIPriority::AP_MAX];
+
+	void FillBuckets();
+
+	static ENoxAIPriority GetPriority(const class ANoxAIController* Controller);
+
+	static void UpdateBrain(class ANoxAIController* Controller, const float DeltaTime);
+
+	static void SetBrainTickEnabled(class ANoxAIController* Controller, const bool bEnabled);
+};
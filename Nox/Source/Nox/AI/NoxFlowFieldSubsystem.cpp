@@ -0,0 +1,481 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxFlowFieldSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/AI/NoxAIController.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "NavigationSystem.h"
+#include "AI/NavigationSystemBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flow Field Tick"), STAT_NoxFlowFieldTick, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Flow Field Rebuild"), STAT_NoxFlowFieldRebuild, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Agents"), STAT_NoxFlowFieldAgents, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Rebuilds"), STAT_NoxFlowFieldRebuilds, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Navmesh Projections"), STAT_NoxFlowFieldProjections, STATGROUP_Nox);
+
+namespace NoxFlowField
+{
+	// Cell can not be reached from the goal
+	static const uint8 Unreachable = 0xFF;
+
+	// Cell of the goal itself, agent moves straight to the goal
+	static const uint8 GoalCell = 0xFE;
+
+	// Opposite directions are stored next to each other, so index ^ 1 is the opposite direction
+	static const FIntPoint NeighbourOffsets[8] =
+	{
+		FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1),
+		FIntPoint(1, 1), FIntPoint(-1, -1), FIntPoint(1, -1), FIntPoint(-1, 1)
+	};
+
+	static const float NeighbourCosts[8] = { 1.f, 1.f, 1.f, 1.f, 1.4142136f, 1.4142136f, 1.4142136f, 1.4142136f };
+
+	static const FVector NeighbourDirections[8] =
+	{
+		FVector(1.f, 0.f, 0.f), FVector(-1.f, 0.f, 0.f), FVector(0.f, 1.f, 0.f), FVector(0.f, -1.f, 0.f),
+		FVector(0.7071068f, 0.7071068f, 0.f), FVector(-0.7071068f, -0.7071068f, 0.f),
+		FVector(0.7071068f, -0.7071068f, 0.f), FVector(-0.7071068f, 0.7071068f, 0.f)
+	};
+
+	struct FOpenCell
+	{
+		int32 Index;
+		float Cost;
+
+		bool operator<(const FOpenCell& Other) const { return Cost < Other.Cost; }
+	};
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxFlowFieldSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxFlowFieldSettings::UNoxFlowFieldSettings()
+{
+	CellSize = 100.f;
+	HalfExtentInCells = 40;
+	ProjectionHeight = 250.f;
+	MaxCachedCells = 32768;
+	SeparationRadius = 80.f;
+	SeparationWeight = 1.f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxFlowFieldSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxFlowFieldSubsystem::Deinitialize()
+{
+	if (bIsBoundToNavigation)
+	{
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->OnNavigationGenerationFinishedDelegate.RemoveAll(this);
+		}
+		bIsBoundToNavigation = false;
+	}
+
+	Fields.Empty();
+	Agents.Empty();
+	WalkableCells.Empty();
+	SeparationGrid.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UNoxFlowFieldSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && Agents.Num() > 0;
+}
+
+TStatId UNoxFlowFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxFlowFieldSubsystem, STATGROUP_Nox);
+}
+
+void UNoxFlowFieldSubsystem::AddAgent(APawn* Agent, AActor* Goal, const float AcceptanceRadius)
+{
+	if (Agent == NULL || Goal == NULL)
+	{
+		return;
+	}
+
+	RemoveAgent(Agent);
+
+	int32 FieldIndex = FindField(Goal);
+	if (FieldIndex == INDEX_NONE)
+	{
+		// Reuse slot of a field without agents, indices of other fields are kept by agents
+		FieldIndex = Fields.IndexOfByPredicate([](const FFlowField& Field) { return Field.NumAgents == 0; });
+		if (FieldIndex == INDEX_NONE)
+		{
+			FieldIndex = Fields.AddDefaulted();
+		}
+
+		FFlowField& Field = Fields[FieldIndex];
+		Field.Goal = Goal;
+		Field.Directions.Reset();
+		Field.Size = 0;
+
+		RebuildField(Field, Goal->GetActorLocation());
+	}
+
+	Fields[FieldIndex].NumAgents++;
+
+	FHordeAgent& HordeAgent = Agents.AddDefaulted_GetRef();
+	HordeAgent.Pawn = Agent;
+	HordeAgent.FieldIndex = FieldIndex;
+	HordeAgent.AcceptanceRadius = AcceptanceRadius;
+}
+
+void UNoxFlowFieldSubsystem::RemoveAgent(APawn* Agent)
+{
+	for (int32 AgentIndex = 0; AgentIndex < Agents.Num(); AgentIndex++)
+	{
+		if (Agents[AgentIndex].Pawn == Agent)
+		{
+			Fields[Agents[AgentIndex].FieldIndex].NumAgents--;
+			Agents.RemoveAtSwap(AgentIndex);
+			return;
+		}
+	}
+}
+
+bool UNoxFlowFieldSubsystem::SampleDirection(const AActor* Goal, const FVector& Location, FVector& OutDirection) const
+{
+	const int32 FieldIndex = FindField(Goal);
+	if (FieldIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FFlowField& Field = Fields[FieldIndex];
+	const FIntPoint LocalCell = GetCell(Location) - Field.FirstCell;
+
+	if (LocalCell.X < 0 || LocalCell.Y < 0 || LocalCell.X >= Field.Size || LocalCell.Y >= Field.Size)
+	{
+		return false;
+	}
+
+	const uint8 Direction = Field.Directions[LocalCell.Y * Field.Size + LocalCell.X];
+	if (Direction == NoxFlowField::Unreachable)
+	{
+		return false;
+	}
+
+	if (Direction == NoxFlowField::GoalCell)
+	{
+		OutDirection = (Goal->GetActorLocation() - Location).GetSafeNormal2D();
+	}
+	else
+	{
+		OutDirection = NoxFlowField::NeighbourDirections[Direction];
+	}
+
+	return true;
+}
+
+void UNoxFlowFieldSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxFlowFieldTick);
+	NOX_HITCH_SCOPE(HS_FlowField);
+
+	// Drop agents that were destroyed without being removed
+	for (int32 AgentIndex = Agents.Num() - 1; AgentIndex >= 0; AgentIndex--)
+	{
+		if (!Agents[AgentIndex].Pawn.IsValid())
+		{
+			Fields[Agents[AgentIndex].FieldIndex].NumAgents--;
+			Agents.RemoveAtSwap(AgentIndex);
+		}
+	}
+
+	ReleaseAgentsOfLostGoals();
+
+	// Rebuild only fields whose goal moved to another cell
+	for (FFlowField& Field : Fields)
+	{
+		if (Field.NumAgents == 0 || !Field.Goal.IsValid())
+		{
+			continue;
+		}
+
+		const FVector GoalLocation = Field.Goal->GetActorLocation();
+		if (GetCell(GoalLocation) != Field.GoalCell)
+		{
+			RebuildField(Field, GoalLocation);
+		}
+	}
+
+	MoveAgents();
+
+	SET_DWORD_STAT(STAT_NoxFlowFieldAgents, Agents.Num());
+}
+
+void UNoxFlowFieldSubsystem::ReleaseAgentsOfLostGoals()
+{
+	TArray<ANoxAIController*, TInlineAllocator<16>> ControllersToNotify;
+
+	for (int32 AgentIndex = Agents.Num() - 1; AgentIndex >= 0; AgentIndex--)
+	{
+		FFlowField& Field = Fields[Agents[AgentIndex].FieldIndex];
+		if (Field.Goal.IsValid())
+		{
+			continue;
+		}
+
+		if (ANoxAIController* Controller = Cast<ANoxAIController>(Agents[AgentIndex].Pawn->GetController()))
+		{
+			ControllersToNotify.Add(Controller);
+		}
+
+		// Field without agents is reused by the next goal
+		Field.NumAgents--;
+		Agents.RemoveAtSwap(AgentIndex);
+	}
+
+	// Notified after removal, controller can start chasing another goal right away
+	for (ANoxAIController* Controller : ControllersToNotify)
+	{
+		Controller->OnHordeGoalLost();
+	}
+}
+
+void UNoxFlowFieldSubsystem::MoveAgents()
+{
+	const UNoxFlowFieldSettings* Settings = GetDefault<UNoxFlowFieldSettings>();
+	const float SeparationRadius = FMath::Max(Settings->SeparationRadius, 1.f);
+	const float SeparationRadiusSquared = SeparationRadius * SeparationRadius;
+
+	// Spatial hash of all agents with cell size equal to separation radius, so only neighbouring cells have to be checked.
+	// Cells are kept between frames to avoid allocations, but dropped when horde has moved far enough to leave many of them empty.
+	if (SeparationGrid.Num() > Agents.Num() * 4)
+	{
+		SeparationGrid.Reset();
+	}
+
+	for (TPair<FIntPoint, TArray<int32>>& GridCell : SeparationGrid)
+	{
+		GridCell.Value.Reset();
+	}
+
+	AgentLocations.SetNumUninitialized(Agents.Num(), false);
+
+	for (int32 AgentIndex = 0; AgentIndex < Agents.Num(); AgentIndex++)
+	{
+		const FVector Location = Agents[AgentIndex].Pawn->GetActorLocation();
+		AgentLocations[AgentIndex] = Location;
+
+		const FIntPoint GridCell(FMath::FloorToInt(Location.X / SeparationRadius), FMath::FloorToInt(Location.Y / SeparationRadius));
+		SeparationGrid.FindOrAdd(GridCell).Add(AgentIndex);
+	}
+
+	for (int32 AgentIndex = 0; AgentIndex < Agents.Num(); AgentIndex++)
+	{
+		const FHordeAgent& HordeAgent = Agents[AgentIndex];
+		const FFlowField& Field = Fields[HordeAgent.FieldIndex];
+		AActor* Goal = Field.Goal.Get();
+
+		if (Goal == NULL)
+		{
+			continue;
+		}
+
+		const FVector& Location = AgentLocations[AgentIndex];
+		const FVector ToGoal = Goal->GetActorLocation() - Location;
+
+		if (ToGoal.SizeSquared2D() <= FMath::Square(HordeAgent.AcceptanceRadius))
+		{
+			continue;
+		}
+
+		FVector Direction;
+		if (!SampleDirection(Goal, Location, Direction))
+		{
+			// Outside of the field, go straight and let field take over when it is reached
+			Direction = ToGoal.GetSafeNormal2D();
+		}
+
+		// Push away from close neighbours, stronger when they are closer
+		FVector Separation = FVector::ZeroVector;
+		const FIntPoint GridCell(FMath::FloorToInt(Location.X / SeparationRadius), FMath::FloorToInt(Location.Y / SeparationRadius));
+
+		for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+		{
+			for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+			{
+				const TArray<int32>* Neighbours = SeparationGrid.Find(GridCell + FIntPoint(OffsetX, OffsetY));
+				if (Neighbours == NULL)
+				{
+					continue;
+				}
+
+				for (const int32 NeighbourIndex : *Neighbours)
+				{
+					const FVector Away = Location - AgentLocations[NeighbourIndex];
+					const float DistanceSquared = Away.SizeSquared2D();
+
+					if (NeighbourIndex != AgentIndex && DistanceSquared < SeparationRadiusSquared && DistanceSquared > KINDA_SMALL_NUMBER)
+					{
+						const float Distance = FMath::Sqrt(DistanceSquared);
+						Separation += FVector(Away.X, Away.Y, 0.f) / Distance * (1.f - Distance / SeparationRadius);
+					}
+				}
+			}
+		}
+
+		const FVector MoveDirection = (Direction + Separation * Settings->SeparationWeight).GetSafeNormal2D();
+		if (!MoveDirection.IsZero())
+		{
+			HordeAgent.Pawn->AddMovementInput(MoveDirection);
+		}
+	}
+}
+
+void UNoxFlowFieldSubsystem::RebuildField(FFlowField& Field, const FVector& GoalLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxFlowFieldRebuild);
+	INC_DWORD_STAT(STAT_NoxFlowFieldRebuilds);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	// Walkable cells are cached, they have to be projected again when navmesh changes
+	if (NavSys != NULL && !bIsBoundToNavigation)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UNoxFlowFieldSubsystem::OnNavigationGenerationFinished);
+		bIsBoundToNavigation = true;
+	}
+
+	const int32 HalfExtent = FMath::Max(GetDefault<UNoxFlowFieldSettings>()->HalfExtentInCells, 1);
+
+	Field.GoalCell = GetCell(GoalLocation);
+	Field.FirstCell = Field.GoalCell - FIntPoint(HalfExtent, HalfExtent);
+	Field.Size = HalfExtent * 2 + 1;
+
+	const int32 NumCells = Field.Size * Field.Size;
+	Field.Directions.SetNumUninitialized(NumCells, false);
+	FMemory::Memset(Field.Directions.GetData(), NoxFlowField::Unreachable, NumCells);
+
+	// Dijkstra from the goal over walkable cells, every cell then points to its cheapest neighbour
+	TArray<float> Costs;
+	Costs.Init(MAX_flt, NumCells);
+
+	TArray<NoxFlowField::FOpenCell> OpenCells;
+
+	const int32 GoalIndex = HalfExtent * Field.Size + HalfExtent;
+	Costs[GoalIndex] = 0.f;
+	Field.Directions[GoalIndex] = NoxFlowField::GoalCell;
+	OpenCells.HeapPush(NoxFlowField::FOpenCell{ GoalIndex, 0.f });
+
+	while (OpenCells.Num() > 0)
+	{
+		NoxFlowField::FOpenCell OpenCell;
+		OpenCells.HeapPop(OpenCell, false);
+
+		if (OpenCell.Cost > Costs[OpenCell.Index])
+		{
+			continue;
+		}
+
+		const FIntPoint LocalCell(OpenCell.Index % Field.Size, OpenCell.Index / Field.Size);
+
+		for (int32 NeighbourIndex = 0; NeighbourIndex < 8; NeighbourIndex++)
+		{
+			const FIntPoint NeighbourCell = LocalCell + NoxFlowField::NeighbourOffsets[NeighbourIndex];
+			if (NeighbourCell.X < 0 || NeighbourCell.Y < 0 || NeighbourCell.X >= Field.Size || NeighbourCell.Y >= Field.Size)
+			{
+				continue;
+			}
+
+			const int32 NeighbourCellIndex = NeighbourCell.Y * Field.Size + NeighbourCell.X;
+			const float Cost = OpenCell.Cost + NoxFlowField::NeighbourCosts[NeighbourIndex];
+
+			if (Cost >= Costs[NeighbourCellIndex] || !IsCellWalkable(NavSys, Field.FirstCell + NeighbourCell, GoalLocation.Z))
+			{
+				continue;
+			}
+
+			// Diagonal move must not cut the corner of a blocked cell
+			if (NeighbourIndex >= 4)
+			{
+				const FIntPoint Offset = NoxFlowField::NeighbourOffsets[NeighbourIndex];
+				if (!IsCellWalkable(NavSys, Field.FirstCell + LocalCell + FIntPoint(Offset.X, 0), GoalLocation.Z)
+					|| !IsCellWalkable(NavSys, Field.FirstCell + LocalCell + FIntPoint(0, Offset.Y), GoalLocation.Z))
+				{
+					continue;
+				}
+			}
+
+			Costs[NeighbourCellIndex] = Cost;
+
+			// Neighbour moves in opposite direction to reach this cell
+			Field.Directions[NeighbourCellIndex] = (uint8)(NeighbourIndex ^ 1);
+			OpenCells.HeapPush(NoxFlowField::FOpenCell{ NeighbourCellIndex, Cost });
+		}
+	}
+}
+
+bool UNoxFlowFieldSubsystem::IsCellWalkable(UNavigationSystemV1* NavSys, const FIntPoint& Cell, const float Height)
+{
+	if (NavSys == NULL)
+	{
+		return true;
+	}
+
+	const UNoxFlowFieldSettings* Settings = GetDefault<UNoxFlowFieldSettings>();
+	const float BandHeight = FMath::Max(Settings->ProjectionHeight, 1.f);
+	const FIntVector Key(Cell.X, Cell.Y, FMath::FloorToInt(Height / BandHeight));
+
+	if (const bool* bIsWalkable = WalkableCells.Find(Key))
+	{
+		return *bIsWalkable;
+	}
+
+	INC_DWORD_STAT(STAT_NoxFlowFieldProjections);
+
+	// Projected from the middle of the band, so every goal height within the band gets the same answer
+	const FVector CellCenter((Cell.X + 0.5f) * Settings->CellSize, (Cell.Y + 0.5f) * Settings->CellSize, (Key.Z + 0.5f) * BandHeight);
+	const FVector Extent(Settings->CellSize * 0.5f, Settings->CellSize * 0.5f, BandHeight);
+
+	FNavLocation NavLocation;
+	const bool bIsWalkable = NavSys->ProjectPointToNavigation(CellCenter, NavLocation, Extent);
+
+	// Goals wandering over a large map would grow cache forever. Cells of active fields are projected again on their next rebuild.
+	if (WalkableCells.Num() >= Settings->MaxCachedCells)
+	{
+		WalkableCells.Reset();
+	}
+
+	WalkableCells.Add(Key, bIsWalkable);
+
+	return bIsWalkable;
+}
+
+void UNoxFlowFieldSubsystem::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	WalkableCells.Reset();
+
+	// Force rebuild of all fields with new navmesh
+	for (FFlowField& Field : Fields)
+	{
+		if (Field.NumAgents > 0 && Field.Goal.IsValid())
+		{
+			RebuildField(Field, Field.Goal->GetActorLocation());
+		}
+	}
+}
+
+int32 UNoxFlowFieldSubsystem::FindField(const AActor* Goal) const
+{
+	return Fields.IndexOfByPredicate([Goal](const FFlowField& Field) { return Field.NumAgents > 0 && Field.Goal.Get() == Goal; });
+}
+
+FIntPoint UNoxFlowFieldSubsystem::GetCell(const FVector& Location) const
+{
+	const float CellSize = GetDefault<UNoxFlowFieldSettings>()->CellSize;
+
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
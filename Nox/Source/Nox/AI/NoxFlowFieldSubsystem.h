@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/DeveloperSettings.h"
+#include "NoxFlowFieldSubsystem.generated.h"
+
+/**
+ * Settings of horde movement. Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Flow Field"))
+class NOX_API UNoxFlowFieldSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxFlowFieldSettings();
+
+	UPROPERTY(config, EditAnywhere, Category = "Flow Field")
+		float CellSize;
+
+	// Field covers this many cells in every direction from the goal
+	UPROPERTY(config, EditAnywhere, Category = "Flow Field")
+		int32 HalfExtentInCells;
+
+	// Max height difference between cell and goal when cell is projected to navmesh. Also height of one floor band in the walkable cell cache.
+	UPROPERTY(config, EditAnywhere, Category = "Flow Field")
+		float ProjectionHeight;
+
+	// Walkable cell cache is cleared when it grows over this many cells
+	UPROPERTY(config, EditAnywhere, Category = "Flow Field", meta = (ClampMin = "1"))
+		int32 MaxCachedCells;
+
+	// Agents closer than this push each other away
+	UPROPERTY(config, EditAnywhere, Category = "Separation")
+		float SeparationRadius;
+
+	UPROPERTY(config, EditAnywhere, Category = "Separation")
+		float SeparationWeight;
+};
+
+/**
+ * Moves hordes of NPCs toward a common goal without a path per NPC.
+ * One flow field (grid of directions toward the goal) is built per goal and rebuilt only when the goal enters another cell.
+ * Every agent samples its direction in O(1) and is pushed away from neighbours found with one spatial hash per frame.
+ */
+UCLASS()
+class NOX_API UNoxFlowFieldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	/** Move agent toward the goal every frame until it is removed
+	*@param AcceptanceRadius - Agent stops moving when it is closer to the goal than this
+	*/
+	void AddAgent(APawn* Agent, AActor* Goal, const float AcceptanceRadius);
+
+	void RemoveAgent(APawn* Agent);
+
+	/** @return - False when location is outside of the field of the goal or goal can not be reached from it */
+	bool SampleDirection(const AActor* Goal, const FVector& Location, FVector& OutDirection) const;
+
+private:
+	struct FFlowField
+	{
+		TWeakObjectPtr<AActor> Goal;
+
+		// Cell of the goal, field is rebuilt when it changes
+		FIntPoint GoalCell;
+
+		// Cell of the first element of Directions
+		FIntPoint FirstCell;
+
+		int32 Size = 0;
+
+		// Index to NeighbourOffsets for every cell, or one of special values
+		TArray<uint8> Directions;
+
+		int32 NumAgents = 0;
+	};
+
+	struct FHordeAgent
+	{
+		TWeakObjectPtr<APawn> Pawn;
+		int32 FieldIndex;
+		float AcceptanceRadius;
+	};
+
+	TArray<FFlowField> Fields;
+
+	TArray<FHordeAgent> Agents;
+
+	// Result of projecting cell to navmesh, shared by all fields. Key is cell and height band, so floors above each other are cached separately. Cleared when navmesh is rebuilt.
+	TMap<FIntVector, bool> WalkableCells;
+
+	bool bIsBoundToNavigation = false;
+
+	// Reused every frame
+	TMap<FIntPoint, TArray<int32>> SeparationGrid;
+	TArray<FVector> AgentLocations;
+
+	void RebuildField(FFlowField& Field, const FVector& GoalLocation);
+
+	bool IsCellWalkable(class UNavigationSystemV1* NavSys, const FIntPoint& Cell, const float Height);
+
+	// Goal was destroyed, its agents leave the field and their controllers are told to pick another goal
+	void ReleaseAgentsOfLostGoals();
+
+	void MoveAgents();
+
+	UFUNCTION()
+		void OnNavigationGenerationFinished(class ANavigationData* NavData);
+
+	int32 FindField(const AActor* Goal) const;
+
+	FIntPoint GetCell(const FVector& Location) const;
+};
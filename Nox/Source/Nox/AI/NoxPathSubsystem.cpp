@@ -0,0 +1,416 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxPathSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/AI/NoxAIController.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+
+DECLARE_CYCLE_STAT(TEXT("Path Requests"), STAT_NoxPathRequests, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Sent"), STAT_NoxPathQueriesSent, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Cache Hits"), STAT_NoxPathCacheHits, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Requests Joined"), STAT_NoxPathRequestsJoined, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Waiting"), STAT_NoxPathQueriesWaiting, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Paths Cached"), STAT_NoxPathsCached, STATGROUP_Nox);
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxPathSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxPathSettings::UNoxPathSettings()
+{
+	MaxQueriesPerFrame = 8;
+	CacheLifetime = 10.f;
+	MaxCachedPaths = 256;
+	GoalUpdateInterval = 0.25f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxPathSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxPathSubsystem::Deinitialize()
+{
+	if (bIsBoundToNavigation)
+	{
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->OnNavigationGenerationFinishedDelegate.RemoveAll(this);
+			NavSys->OnNavDataRegisteredEvent.RemoveAll(this);
+		}
+		bIsBoundToNavigation = false;
+	}
+
+	Cache.Empty();
+	Queries.Empty();
+	QueriesToSend.Empty();
+	KeysByQueryId.Empty();
+	Chases.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UNoxPathSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && (QueriesToSend.Num() > 0 || Chases.Num() > 0);
+}
+
+TStatId UNoxPathSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxPathSubsystem, STATGROUP_Nox);
+}
+
+void UNoxPathSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now >= NextGoalUpdateTime)
+	{
+		NextGoalUpdateTime = Now + GetDefault<UNoxPathSettings>()->GoalUpdateInterval;
+		UpdateChases();
+	}
+
+	SendQueries();
+
+	SET_DWORD_STAT(STAT_NoxPathQueriesWaiting, Queries.Num());
+	SET_DWORD_STAT(STAT_NoxPathsCached, Cache.Num());
+}
+
+bool UNoxPathSubsystem::RequestMove(ANoxAIController* Controller, AActor* GoalActor, const FVector& GoalLocation, const float AcceptanceRadius, const uint32 RequestSerial)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxPathRequests);
+	NOX_HITCH_SCOPE(HS_PathRequests);
+
+	const ARecastNavMesh* NavMesh = GetNavMesh(Controller);
+	if (NavMesh == NULL || Controller->GetPawn() == NULL)
+	{
+		return false;
+	}
+
+	// Cache has to be cleared when navmesh is rebuilt or replaced
+	if (!bIsBoundToNavigation)
+	{
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UNoxPathSubsystem::OnNavigationChanged);
+			NavSys->OnNavDataRegisteredEvent.AddDynamic(this, &UNoxPathSubsystem::OnNavigationChanged);
+			bIsBoundToNavigation = true;
+		}
+	}
+
+	const FVector Start = Controller->GetNavAgentLocation();
+	const FVector End = GoalActor != NULL ? GoalActor->GetActorLocation() : GoalLocation;
+
+	const NavNodeRef StartPoly = FindPoly(NavMesh, Start);
+	const NavNodeRef GoalPoly = FindPoly(NavMesh, End);
+
+	if (StartPoly == INVALID_NAVNODEREF || GoalPoly == INVALID_NAVNODEREF)
+	{
+		return false;
+	}
+
+	// Controller can chase only one actor, newer request replaces the old one
+	Chases.RemoveAllSwap([Controller](const FChase& Chase) { return Chase.Controller == Controller; });
+
+	if (GoalActor != NULL)
+	{
+		FChase& Chase = Chases.AddDefaulted_GetRef();
+		Chase.Controller = Controller;
+		Chase.GoalActor = GoalActor;
+		Chase.GoalPoly = GoalPoly;
+		Chase.AcceptanceRadius = AcceptanceRadius;
+		Chase.RequestSerial = RequestSerial;
+	}
+
+	FMoveRequest Request;
+	Request.Controller = Controller;
+	Request.GoalActor = GoalActor;
+	Request.GoalLocation = End;
+	Request.AcceptanceRadius = AcceptanceRadius;
+	Request.RequestSerial = RequestSerial;
+	Request.bIsUpdate = false;
+
+	return QueueRequest(Request, FPathKey(StartPoly, GoalPoly), Start, End);
+}
+
+bool UNoxPathSubsystem::QueueRequest(const FMoveRequest& Request, const FPathKey& Key, const FVector& Start, const FVector& End)
+{
+	if (const FCachedPath* CachedPath = Cache.Find(Key))
+	{
+		if (GetWorld()->GetTimeSeconds() - CachedPath->CreationTime < GetDefault<UNoxPathSettings>()->CacheLifetime)
+		{
+			INC_DWORD_STAT(STAT_NoxPathCacheHits);
+			StartMove(Request, CachedPath->Path);
+			return true;
+		}
+
+		Cache.Remove(Key);
+	}
+
+	// Same path is already being found for another NPC
+	if (FPathQuery* Query = Queries.Find(Key))
+	{
+		INC_DWORD_STAT(STAT_NoxPathRequestsJoined);
+		Query->Waiters.Add(Request);
+		return true;
+	}
+
+	FPathQuery& Query = Queries.Add(Key);
+	Query.Waiters.Add(Request);
+	Query.Start = Start;
+	Query.End = End;
+	Query.NavGeneration = NavGeneration;
+
+	QueriesToSend.Add(Key);
+
+	return true;
+}
+
+void UNoxPathSubsystem::SendQueries()
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys == NULL)
+	{
+		return;
+	}
+
+	if (!QueryDelegate.IsBound())
+	{
+		QueryDelegate.BindUObject(this, &UNoxPathSubsystem::OnPathFound);
+	}
+
+	// Navigation system runs all async queries of a frame in one batch on worker thread
+	const int32 NumToSend = FMath::Min(QueriesToSend.Num(), GetDefault<UNoxPathSettings>()->MaxQueriesPerFrame);
+
+	for (int32 KeyIndex = 0; KeyIndex < NumToSend; KeyIndex++)
+	{
+		const FPathKey& Key = QueriesToSend[KeyIndex];
+		FPathQuery* Query = Queries.Find(Key);
+		if (Query == NULL)
+		{
+			continue;
+		}
+
+		// Agent properties and navmesh are taken from the first waiter that still exists
+		const FMoveRequest* Waiter = Query->Waiters.FindByPredicate([](const FMoveRequest& Request) { return Request.Controller.IsValid(); });
+		const ARecastNavMesh* NavMesh = Waiter != NULL ? GetNavMesh(Waiter->Controller.Get()) : NULL;
+
+		// Nothing to search on, waiters must not wait forever
+		if (NavMesh == NULL)
+		{
+			FPathQuery DroppedQuery;
+			Queries.RemoveAndCopyValue(Key, DroppedQuery);
+
+			for (const FMoveRequest& Request : DroppedQuery.Waiters)
+			{
+				FailMove(Request);
+			}
+			continue;
+		}
+
+		FPathFindingQuery PathQuery(this, *NavMesh, Query->Start, Query->End, NavMesh->GetDefaultQueryFilter());
+
+		Query->QueryId = NavSys->FindPathAsync(Waiter->Controller->GetNavAgentPropertiesRef(), PathQuery, QueryDelegate);
+		KeysByQueryId.Add(Query->QueryId, Key);
+
+		INC_DWORD_STAT(STAT_NoxPathQueriesSent);
+	}
+
+	QueriesToSend.RemoveAt(0, NumToSend, false);
+}
+
+void UNoxPathSubsystem::OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FPathKey Key;
+	if (!KeysByQueryId.RemoveAndCopyValue(QueryId, Key))
+	{
+		return;
+	}
+
+	FPathQuery Query;
+	if (!Queries.RemoveAndCopyValue(Key, Query))
+	{
+		return;
+	}
+
+	const bool bIsFound = Result == ENavigationQueryResult::Success && Path.IsValid() && Path->IsValid();
+
+	// Path found on navmesh that changed in the meantime can still be used, but is not shared with later requests
+	if (bIsFound && Query.NavGeneration == NavGeneration)
+	{
+		const UNoxPathSettings* Settings = GetDefault<UNoxPathSettings>();
+
+		if (Cache.Num() >= Settings->MaxCachedPaths)
+		{
+			// Drop the oldest path
+			FPathKey OldestKey;
+			float OldestTime = MAX_flt;
+			for (const TPair<FPathKey, FCachedPath>& CachedPath : Cache)
+			{
+				if (CachedPath.Value.CreationTime < OldestTime)
+				{
+					OldestTime = CachedPath.Value.CreationTime;
+					OldestKey = CachedPath.Key;
+				}
+			}
+			Cache.Remove(OldestKey);
+		}
+
+		FCachedPath& CachedPath = Cache.Add(Key);
+		CachedPath.Path = Path;
+		CachedPath.CreationTime = GetWorld()->GetTimeSeconds();
+	}
+
+	for (const FMoveRequest& Request : Query.Waiters)
+	{
+		if (bIsFound)
+		{
+			StartMove(Request, Path);
+		}
+		else
+		{
+			FailMove(Request);
+		}
+	}
+}
+
+void UNoxPathSubsystem::FailMove(const FMoveRequest& Request)
+{
+	ANoxAIController* Controller = Request.Controller.Get();
+
+	// Failed update keeps the old path
+	if (Controller != NULL && !Request.bIsUpdate && Controller->GetAsyncPathRequestSerial() == Request.RequestSerial)
+	{
+		Controller->OnAsyncPathFailed();
+	}
+}
+
+void UNoxPathSubsystem::StartMove(const FMoveRequest& Request, const FNavPathSharedPtr& SharedPath)
+{
+	ANoxAIController* Controller = Request.Controller.Get();
+
+	// Controller asked for another path in the meantime
+	if (Controller == NULL || Controller->GetAsyncPathRequestSerial() != Request.RequestSerial || Controller->GetPawn() == NULL)
+	{
+		return;
+	}
+
+	// Shared path must not be changed, path following keeps its own copy
+	FNavMeshPath* NavMeshPath = new FNavMeshPath();
+	FNavPathSharedPtr Path = MakeShareable(NavMeshPath);
+
+	TArray<FNavPathPoint>& PathPoints = NavMeshPath->GetPathPoints();
+	PathPoints = SharedPath->GetPathPoints();
+
+	if (const FNavMeshPath* SharedNavMeshPath = SharedPath->CastPath<FNavMeshPath>())
+	{
+		NavMeshPath->PathCorridor = SharedNavMeshPath->PathCorridor;
+		NavMeshPath->PathCorridorCost = SharedNavMeshPath->PathCorridorCost;
+	}
+
+	// Path was found from location of another NPC. Start and goal polygons are the same and convex,
+	// so first and last point can be moved to this NPC and its goal. Height is kept from navmesh.
+	const FVector Start = Controller->GetNavAgentLocation();
+	const FVector Goal = Request.GoalActor.IsValid() ? Request.GoalActor->GetActorLocation() : Request.GoalLocation;
+
+	if (PathPoints.Num() > 0)
+	{
+		PathPoints[0].Location.X = Start.X;
+		PathPoints[0].Location.Y = Start.Y;
+		PathPoints.Last().Location.X = Goal.X;
+		PathPoints.Last().Location.Y = Goal.Y;
+	}
+
+	NavMeshPath->SetNavigationDataUsed(SharedPath->GetNavigationDataUsed());
+	NavMeshPath->SetQuerier(Controller);
+	NavMeshPath->SetTimeStamp(SharedPath->GetTimeStamp());
+	NavMeshPath->MarkReady();
+
+	Controller->OnAsyncPathFound(Path, Request.GoalActor.Get(), Request.GoalLocation, Request.AcceptanceRadius, Request.bIsUpdate);
+}
+
+void UNoxPathSubsystem::UpdateChases()
+{
+	for (int32 ChaseIndex = Chases.Num() - 1; ChaseIndex >= 0; ChaseIndex--)
+	{
+		FChase& Chase = Chases[ChaseIndex];
+		ANoxAIController* Controller = Chase.Controller.Get();
+
+		if (Controller == NULL || !Chase.GoalActor.IsValid() || Controller->GetAsyncPathRequestSerial() != Chase.RequestSerial || !Controller->IsAsyncMoveActive())
+		{
+			Chases.RemoveAtSwap(ChaseIndex);
+			continue;
+		}
+
+		// First path did not arrive yet
+		if (Controller->IsAsyncMovePending())
+		{
+			continue;
+		}
+
+		const ARecastNavMesh* NavMesh = GetNavMesh(Controller);
+		if (NavMesh == NULL)
+		{
+			continue;
+		}
+
+		// Path is found again only when goal moves to another polygon
+		const FVector GoalLocation = Chase.GoalActor->GetActorLocation();
+		const NavNodeRef GoalPoly = FindPoly(NavMesh, GoalLocation);
+
+		if (GoalPoly == INVALID_NAVNODEREF || GoalPoly == Chase.GoalPoly)
+		{
+			continue;
+		}
+
+		const FVector Start = Controller->GetNavAgentLocation();
+		const NavNodeRef StartPoly = FindPoly(NavMesh, Start);
+
+		if (StartPoly == INVALID_NAVNODEREF)
+		{
+			continue;
+		}
+
+		Chase.GoalPoly = GoalPoly;
+
+		FMoveRequest Request;
+		Request.Controller = Controller;
+		Request.GoalActor = Chase.GoalActor;
+		Request.GoalLocation = GoalLocation;
+		Request.AcceptanceRadius = Chase.AcceptanceRadius;
+		Request.RequestSerial = Chase.RequestSerial;
+		Request.bIsUpdate = true;
+
+		QueueRequest(Request, FPathKey(StartPoly, GoalPoly), Start, GoalLocation);
+	}
+}
+
+void UNoxPathSubsystem::ClearCache()
+{
+	Cache.Reset();
+	NavGeneration++;
+}
+
+void UNoxPathSubsystem::OnNavigationChanged(ANavigationData* NavData)
+{
+	ClearCache();
+}
+
+NavNodeRef UNoxPathSubsystem::FindPoly(const ARecastNavMesh* NavMesh, const FVector& Location) const
+{
+	// Nearest polygon lookup is cheap compared to path query, it is done on game thread
+	return NavMesh->FindNearestPoly(Location, NavMesh->GetConfig().DefaultQueryExtent, NavMesh->GetDefaultQueryFilter());
+}
+
+ARecastNavMesh* UNoxPathSubsystem::GetNavMesh(const ANoxAIController* Controller) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys == NULL || Controller == NULL)
+	{
+		return NULL;
+	}
+
+	return Cast<ARecastNavMesh>(NavSys->GetNavDataForProps(Controller->GetNavAgentPropertiesRef()));
+}
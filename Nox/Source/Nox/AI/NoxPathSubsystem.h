@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/DeveloperSettings.h"
+#include "NavigationSystemTypes.h"
+#include "NoxPathSubsystem.generated.h"
+
+/**
+ * Settings of async pathfinding. Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Pathfinding"))
+class NOX_API UNoxPathSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxPathSettings();
+
+	// Max number of path queries sent to navigation system every frame, others wait for next frame
+	UPROPERTY(config, EditAnywhere, Category = "Pathfinding")
+		int32 MaxQueriesPerFrame;
+
+	// Cached path is found again after this time in seconds even if navmesh did not change
+	UPROPERTY(config, EditAnywhere, Category = "Cache")
+		float CacheLifetime;
+
+	UPROPERTY(config, EditAnywhere, Category = "Cache")
+		int32 MaxCachedPaths;
+
+	// Time in seconds between checks if chased actor moved to another nav polygon
+	UPROPERTY(config, EditAnywhere, Category = "Chase")
+		float GoalUpdateInterval;
+};
+
+/**
+ * Finds paths for ANoxAIController with async navmesh queries, so game thread never waits for a path.
+ * Paths are cached by start and goal nav polygon and shared by all NPCs moving between the same polygons
+ * (NPCs on the same patrol or chasing the same target). Cache is cleared when navmesh changes.
+ */
+UCLASS()
+class NOX_API UNoxPathSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	/** Find path and start move of controller when it is ready. Move starts in the same call when path is cached.
+	*@param GoalActor - Optional, path is updated while actor moves between nav polygons
+	*@param RequestSerial - Path is used only if controller did not send newer request in the meantime
+	*@return - False when start or goal is not on navmesh
+	*/
+	bool RequestMove(class ANoxAIController* Controller, AActor* GoalActor, const FVector& GoalLocation, const float AcceptanceRadius, const uint32 RequestSerial);
+
+	// Drop cached paths, e.g. when navmesh changes
+	void ClearCache();
+
+private:
+	typedef TPair<NavNodeRef, NavNodeRef> FPathKey;
+
+	struct FMoveRequest
+	{
+		TWeakObjectPtr<class ANoxAIController> Controller;
+		TWeakObjectPtr<AActor> GoalActor;
+		FVector GoalLocation;
+		float AcceptanceRadius;
+		uint32 RequestSerial;
+
+		// Path of already running chase move is replaced
+		bool bIsUpdate;
+	};
+
+	struct FCachedPath
+	{
+		FNavPathSharedPtr Path;
+		float CreationTime;
+	};
+
+	struct FPathQuery
+	{
+		// Requests waiting for the same path
+		TArray<FMoveRequest> Waiters;
+
+		FVector Start;
+		FVector End;
+
+		// 0 - query not sent yet
+		uint32 QueryId = 0;
+		uint32 NavGeneration = 0;
+	};
+
+	struct FChase
+	{
+		TWeakObjectPtr<class ANoxAIController> Controller;
+		TWeakObjectPtr<AActor> GoalActor;
+		NavNodeRef GoalPoly;
+		float AcceptanceRadius;
+		uint32 RequestSerial;
+	};
+
+	TMap<FPathKey, FCachedPath> Cache;
+
+	TMap<FPathKey, FPathQuery> Queries;
+
+	// Keys of Queries that were not sent yet, in order of requests
+	TArray<FPathKey> QueriesToSend;
+
+	TMap<uint32, FPathKey> KeysByQueryId;
+
+	TArray<FChase> Chases;
+
+	float NextGoalUpdateTime = 0.f;
+
+	// Increased when navmesh changes, results of queries sent before are not cached
+	uint32 NavGeneration = 0;
+
+	bool bIsBoundToNavigation = false;
+
+	FNavPathQueryDelegate QueryDelegate;
+
+	// Use cached path or join query for the same polygons, new query is sent next tick
+	bool QueueRequest(const FMoveRequest& Request, const FPathKey& Key, const FVector& Start, const FVector& End);
+
+	void SendQueries();
+
+	void UpdateChases();
+
+	void OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	// Give every waiter its own copy of the path that starts at its location
+	void StartMove(const FMoveRequest& Request, const FNavPathSharedPtr& SharedPath);
+
+	// Tell waiters that are still waiting for this request that there is no path
+	void FailMove(const FMoveRequest& Request);
+
+	NavNodeRef FindPoly(const class ARecastNavMesh* NavMesh, const FVector& Location) const;
+
+	class ARecastNavMesh* GetNavMesh(const class ANoxAIController* Controller) const;
+
+	UFUNCTION()
+		void OnNavigationChanged(class ANavigationData* NavData);
+};
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxPatrolPath.h"
+#include "Components/SceneComponent.h"
+
+ANoxPatrolPath::ANoxPatrolPath()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("DefaultSceneRoot")));
+
+	bIsLooping = true;
+}
+
+FVector ANoxPatrolPath::GetWorldPoint(const int32 PointIndex) const
+{
+	if (!PathPoints.IsValidIndex(PointIndex))
+	{
+		return GetActorLocation();
+	}
+
+	return GetActorTransform().TransformPosition(PathPoints[PointIndex]);
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "NoxPatrolPath.generated.h"
+
+/**
+ * Points followed by patrolling NPCs. Points are relative to the actor and can be moved in the level with widgets.
+ */
+UCLASS()
+class NOX_API ANoxPatrolPath : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ANoxPatrolPath();
+
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category = "Patrol", Meta = (MakeEditWidget = "true"))
+		TArray<FVector> PathPoints;
+
+	// After last point go back to the first one. Otherwise walk the path back.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Patrol")
+		bool bIsLooping;
+
+	FORCEINLINE int32 GetNumPoints() const { return PathPoints.Num(); }
+
+	/** @return - Location of point in world space */
+	UFUNCTION(BlueprintCallable, Category = "Patrol")
+		FVector GetWorldPoint(const int32 PointIndex) const;
+};
@@ -0,0 +1,353 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxSightSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/Diagnostics/NoxReplaySubsystem.h"
+#include "Nox/AI/NoxAIController.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sight Update"), STAT_NoxSightUpdate, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Listeners Updated"), STAT_NoxSightListenersUpdated, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Line Of Sight Traces"), STAT_NoxSightTraces, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Line Of Sight Cache Hits"), STAT_NoxSightCacheHits, STATGROUP_Nox);
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxSightSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxSightSettings::UNoxSightSettings()
+{
+	CellSize = 500.f;
+	LineOfSightCacheLifetime = 0.3f;
+	TimeBudgetMs = 1.f;
+	LineOfSightChannel = ECC_Visibility;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxSightSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxSightSubsystem::Deinitialize()
+{
+	Sources.Empty();
+	Listeners.Empty();
+	Grid.Empty();
+	LineOfSightCache.Empty();
+	PendingNotifies.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UNoxSightSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && (Listeners.Num() > 0 || PendingNotifies.Num() > 0);
+}
+
+TStatId UNoxSightSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxSightSubsystem, STATGROUP_Nox);
+}
+
+void UNoxSightSubsystem::RegisterSource(AActor* Source)
+{
+	if (Source == NULL)
+	{
+		return;
+	}
+
+	for (const FSightSource& SightSource : Sources)
+	{
+		if (SightSource.Actor == Source)
+		{
+			return;
+		}
+	}
+
+	FSightSource& SightSource = Sources.AddDefaulted_GetRef();
+	SightSource.Actor = Source;
+	SightSource.Location = Source->GetActorLocation();
+}
+
+void UNoxSightSubsystem::UnregisterSource(AActor* Source)
+{
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); SourceIndex++)
+	{
+		if (Sources[SourceIndex].Actor == Source)
+		{
+			// Grid is rebuilt before it is used again, so indices can change
+			Sources.RemoveAtSwap(SourceIndex);
+			break;
+		}
+	}
+
+	for (FSightListener& Listener : Listeners)
+	{
+		if (Listener.SeenActors.Remove(Source) > 0)
+		{
+			PendingNotifies.Add({ Listener.Controller, Source, false });
+		}
+	}
+}
+
+void UNoxSightSubsystem::RegisterListener(ANoxAIController* Listener)
+{
+	if (Listener == NULL)
+	{
+		return;
+	}
+
+	for (const FSightListener& SightListener : Listeners)
+	{
+		if (SightListener.Controller == Listener)
+		{
+			return;
+		}
+	}
+
+	FSightListener& SightListener = Listeners.AddDefaulted_GetRef();
+	SightListener.Controller = Listener;
+}
+
+void UNoxSightSubsystem::UnregisterListener(ANoxAIController* Listener)
+{
+	for (int32 ListenerIndex = 0; ListenerIndex < Listeners.Num(); ListenerIndex++)
+	{
+		if (Listeners[ListenerIndex].Controller == Listener)
+		{
+			Listeners.RemoveAtSwap(ListenerIndex);
+			break;
+		}
+	}
+}
+
+void UNoxSightSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxSightUpdate);
+	NOX_HITCH_SCOPE(HS_Sight);
+
+	RebuildGrid();
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double TimeBudget = GetDefault<UNoxSightSettings>()->TimeBudgetMs * 0.001;
+
+	// Replay updates the same listeners as the recorded frame, wall clock would pick different ones
+	const int32 ReplayedCount = UNoxReplaySubsystem::GetReplayedBudgetCount(ENoxReplayBudget::RB_Sight);
+	if (ReplayedCount == 0)
+	{
+		SendPendingNotifies();
+		return;
+	}
+
+	// At least one listener is updated every frame, so all of them are updated eventually
+	int32 NumUpdated = 0;
+	while (NumUpdated < Listeners.Num())
+	{
+		if (NextListenerIndex >= Listeners.Num())
+		{
+			// Every listener was updated, good moment to drop old results
+			NextListenerIndex = 0;
+			RemoveExpiredLineOfSight();
+		}
+
+		UpdateListener(Listeners[NextListenerIndex]);
+		NextListenerIndex++;
+		NumUpdated++;
+
+		INC_DWORD_STAT(STAT_NoxSightListenersUpdated);
+
+		const bool bIsOverBudget = ReplayedCount != INDEX_NONE ? NumUpdated >= ReplayedCount : FPlatformTime::Seconds() - StartTime > TimeBudget;
+		if (bIsOverBudget)
+		{
+			break;
+		}
+	}
+
+	UNoxReplaySubsystem::RecordBudgetCount(ENoxReplayBudget::RB_Sight, NumUpdated);
+
+	SendPendingNotifies();
+}
+
+void UNoxSightSubsystem::RebuildGrid()
+{
+	for (auto& Cell : Grid)
+	{
+		Cell.Value.Reset();
+	}
+
+	for (int32 SourceIndex = Sources.Num() - 1; SourceIndex >= 0; SourceIndex--)
+	{
+		FSightSource& Source = Sources[SourceIndex];
+
+		const AActor* SourceActor = Source.Actor.Get();
+		if (SourceActor == NULL)
+		{
+			Sources.RemoveAtSwap(SourceIndex);
+			continue;
+		}
+
+		Source.Location = SourceActor->GetActorLocation();
+	}
+
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); SourceIndex++)
+	{
+		Grid.FindOrAdd(GetCell(Sources[SourceIndex].Location)).Add(SourceIndex);
+	}
+}
+
+void UNoxSightSubsystem::UpdateListener(FSightListener& Listener)
+{
+	ANoxAIController* Controller = Listener.Controller.Get();
+	APawn* Pawn = Controller != NULL ? Controller->GetPawn() : NULL;
+
+	if (Pawn == NULL || !Controller->IsSightEnabled())
+	{
+		return;
+	}
+
+	const FVector ViewLocation = Pawn->GetPawnViewLocation();
+	const float SightRadiusSquared = FMath::Square(Controller->SightRadius);
+	const float LoseSightRadiusSquared = FMath::Square(FMath::Max(Controller->SightRadius, Controller->LoseSightRadius));
+	const float MaxRadius = FMath::Max(Controller->SightRadius, Controller->LoseSightRadius);
+
+	const FIntPoint MinCell = GetCell(ViewLocation - FVector(MaxRadius, MaxRadius, 0.f));
+	const FIntPoint MaxCell = GetCell(ViewLocation + FVector(MaxRadius, MaxRadius, 0.f));
+
+	TArray<AActor*, TInlineAllocator<16>> SeenActors;
+
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+		{
+			const TArray<int32>* Cell = Grid.Find(FIntPoint(CellX, CellY));
+			if (Cell == NULL)
+			{
+				continue;
+			}
+
+			for (const int32 SourceIndex : *Cell)
+			{
+				const FSightSource& Source = Sources[SourceIndex];
+				AActor* SourceActor = Source.Actor.Get();
+
+				if (SourceActor == NULL || SourceActor == Pawn)
+				{
+					continue;
+				}
+
+				// Actors already seen are lost only past lose sight radius
+				const bool bWasSeen = Listener.SeenActors.Contains(SourceActor);
+				const float DistanceSquared = FVector::DistSquared(ViewLocation, Source.Location);
+
+				if (DistanceSquared > (bWasSeen ? LoseSightRadiusSquared : SightRadiusSquared))
+				{
+					continue;
+				}
+
+				if (HasLineOfSight(Pawn, ViewLocation, SourceActor, Source.Location))
+				{
+					SeenActors.Add(SourceActor);
+				}
+			}
+		}
+	}
+
+	for (const TWeakObjectPtr<AActor>& SeenActor : Listener.SeenActors)
+	{
+		if (SeenActor.IsValid() && !SeenActors.Contains(SeenActor.Get()))
+		{
+			PendingNotifies.Add({ Controller, SeenActor, false });
+		}
+	}
+
+	for (AActor* SeenActor : SeenActors)
+	{
+		if (!Listener.SeenActors.Contains(SeenActor))
+		{
+			PendingNotifies.Add({ Controller, SeenActor, true });
+		}
+	}
+
+	Listener.SeenActors.Reset(SeenActors.Num());
+	for (AActor* SeenActor : SeenActors)
+	{
+		Listener.SeenActors.Add(SeenActor);
+	}
+}
+
+bool UNoxSightSubsystem::HasLineOfSight(const AActor* Viewer, const FVector& ViewLocation, const AActor* Target, const FVector& TargetLocation)
+{
+	const uint64 PairKey = MakePairKey(Viewer, Target);
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	if (const FLineOfSight* CachedLineOfSight = LineOfSightCache.Find(PairKey))
+	{
+		if (CachedLineOfSight->ExpireTime > CurrentTime)
+		{
+			INC_DWORD_STAT(STAT_NoxSightCacheHits);
+			return CachedLineOfSight->bIsVisible;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_NoxSightTraces);
+
+	const UNoxSightSettings* Settings = GetDefault<UNoxSightSettings>();
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(NoxSightLineOfSight), true, Viewer);
+	QueryParams.AddIgnoredActor(Target);
+
+	const bool bIsVisible = !GetWorld()->LineTraceTestByChannel(ViewLocation, TargetLocation, Settings->LineOfSightChannel, QueryParams);
+
+	// Line of sight is treated as symmetric, so both listeners of a pair share the result
+	LineOfSightCache.Add(PairKey, { bIsVisible, CurrentTime + Settings->LineOfSightCacheLifetime });
+
+	return bIsVisible;
+}
+
+void UNoxSightSubsystem::RemoveExpiredLineOfSight()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (auto It = LineOfSightCache.CreateIterator(); It; ++It)
+	{
+		if (It.Value().ExpireTime <= CurrentTime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UNoxSightSubsystem::SendPendingNotifies()
+{
+	// Callbacks can add new notifies, those are sent next frame
+	TArray<FSightNotify> Notifies = MoveTemp(PendingNotifies);
+	PendingNotifies.Reset();
+
+	for (const FSightNotify& Notify : Notifies)
+	{
+		ANoxAIController* Controller = Notify.Controller.Get();
+		AActor* Actor = Notify.Actor.Get();
+
+		if (Controller != NULL && Actor != NULL)
+		{
+			Controller->OnSightChanged(Actor, Notify.bIsSeen);
+		}
+	}
+}
+
+FIntPoint UNoxSightSubsystem::GetCell(const FVector& Location) const
+{
+	const float CellSize = FMath::Max(GetDefault<UNoxSightSettings>()->CellSize, 1.f);
+
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+uint64 UNoxSightSubsystem::MakePairKey(const AActor* A, const AActor* B)
+{
+	const uint32 IdA = A->GetUniqueID();
+	const uint32 IdB = B->GetUniqueID();
+
+	return IdA < IdB ? ((uint64)IdA << 32) | IdB : ((uint64)IdB << 32) | IdA;
+}
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/DeveloperSettings.h"
+#include "NoxSightSubsystem.generated.h"
+
+/**
+ * Settings of shared AI sight. Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Sight"))
+class NOX_API UNoxSightSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxSightSettings();
+
+	// Size of a grid cell used to find sources near a listener. Should be close to the usual sight radius.
+	UPROPERTY(config, EditAnywhere, Category = "Sight")
+		float CellSize;
+
+	// Time in seconds for which line of sight result between two actors is reused
+	UPROPERTY(config, EditAnywhere, Category = "Sight")
+		float LineOfSightCacheLifetime;
+
+	// Time in milliseconds that sight can use every frame. Listeners that do not fit are updated in next frames.
+	UPROPERTY(config, EditAnywhere, Category = "Sight")
+		float TimeBudgetMs;
+
+	UPROPERTY(config, EditAnywhere, Category = "Sight")
+		TEnumAsByte<ECollisionChannel> LineOfSightChannel;
+};
+
+/**
+ * Sight of all ANoxAIController in the world, replacing per character sense objects.
+ * Sources are put into a 2D grid every frame, so every listener checks only sources in nearby cells.
+ * Listeners are updated round-robin within a time budget and line of sight results are cached per pair of actors.
+ * Changes of what listener sees are sent to ANoxAIController::OnSightChanged().
+ */
+UCLASS()
+class NOX_API UNoxSightSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	// Actor that can be seen by listeners
+	void RegisterSource(AActor* Source);
+
+	// Listeners that see this source lose sight of it
+	void UnregisterSource(AActor* Source);
+
+	// Controller that sees sources from location of its pawn
+	void RegisterListener(class ANoxAIController* Listener);
+
+	void UnregisterListener(class ANoxAIController* Listener);
+
+private:
+	struct FSightSource
+	{
+		TWeakObjectPtr<AActor> Actor;
+		FVector Location;
+	};
+
+	struct FSightListener
+	{
+		TWeakObjectPtr<class ANoxAIController> Controller;
+		TArray<TWeakObjectPtr<AActor>> SeenActors;
+	};
+
+	struct FLineOfSight
+	{
+		bool bIsVisible;
+		float ExpireTime;
+	};
+
+	struct FSightNotify
+	{
+		TWeakObjectPtr<class ANoxAIController> Controller;
+		TWeakObjectPtr<AActor> Actor;
+		bool bIsSeen;
+	};
+
+	TArray<FSightSource> Sources;
+
+	TArray<FSightListener> Listeners;
+
+	// Indices of Sources in every cell, rebuilt every frame
+	TMap<FIntPoint, TArray<int32>> Grid;
+
+	// Key is made from unique ids of both actors
+	TMap<uint64, FLineOfSight> LineOfSightCache;
+
+	// Changes are sent after all listeners of this frame are updated, so callbacks can register and unregister freely
+	TArray<FSightNotify> PendingNotifies;
+
+	// Listener that will be updated first in next frame
+	int32 NextListenerIndex = 0;
+
+	void RebuildGrid();
+
+	void UpdateListener(FSightListener& Listener);
+
+	bool HasLineOfSight(const AActor* Viewer, const FVector& ViewLocation, const AActor* Target, const FVector& TargetLocation);
+
+	void RemoveExpiredLineOfSight();
+
+	void SendPendingNotifies();
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	static uint64 MakePairKey(const AActor* A, const AActor* B);
+};
@@ -23,7 +23,7 @@ void UHitBoxNotify::BranchingPointNotify(FBranchingPointNotifyPayload& Branching
 	{
 		if (UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(MeshComp->GetAnimInstance()))
 		{
-			NoxAnimInstance->OnHitBoxNotifyBegin.Broadcast(CollisionPart, BranchingPointPayload);			
+			NoxAnimInstance->DispatchHitBoxNotifyBegin(CollisionPart, BranchingPointPayload);			
 		}
 	}
 }
@@ -46,7 +46,7 @@ void UHitBoxNotifyWindow::BranchingPointNotifyBegin(FBranchingPointNotifyPayload
 	{
 		if (UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(MeshComp->GetAnimInstance()))
 		{			
-			NoxAnimInstance->OnHitBoxNotifyBegin.Broadcast(CollisionPart, BranchingPointPayload);
+			NoxAnimInstance->DispatchHitBoxNotifyBegin(CollisionPart, BranchingPointPayload);
 		}
 	}
 }
@@ -57,9 +57,11 @@ void UHitBoxNotifyWindow::BranchingPointNotifyTick(FBranchingPointNotifyPayload&
 
 	if (USkeletalMeshComponent* MeshComp = BranchingPointPayload.SkelMeshComponent)
 	{
-		if (UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(MeshComp->GetAnimInstance()))
+		// Nothing is done on frames of the window when nobody listens
+		UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(MeshComp->GetAnimInstance());
+		if (NoxAnimInstance != NULL && NoxAnimInstance->WantsHitBoxNotifyTick())
 		{
-			NoxAnimInstance->OnHitBoxNotifyTick.Broadcast(CollisionPart, BranchingPointPayload);
+			NoxAnimInstance->DispatchHitBoxNotifyTick(CollisionPart, BranchingPointPayload);
 		}
 	}
 }
@@ -72,7 +74,7 @@ void UHitBoxNotifyWindow::BranchingPointNotifyEnd(FBranchingPointNotifyPayload&
 	{
 		if (UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(MeshComp->GetAnimInstance()))
 		{
-			NoxAnimInstance->OnHitBoxNotifyEnd.Broadcast(CollisionPart, BranchingPointPayload);
+			NoxAnimInstance->DispatchHitBoxNotifyEnd(CollisionPart, BranchingPointPayload);
 		}
 	}
 }
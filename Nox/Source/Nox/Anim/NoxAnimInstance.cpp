@@ -2,4 +2,118 @@
 
 
 #include "NoxAnimInstance.h"
+#include "Nox/NoxCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
 
+//////////////////////////////////////////////////////////////////////////
+// FNoxAnimInstanceProxy
+//////////////////////////////////////////////////////////////////////////
+
+void FNoxAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Only place where character is read, everything else works on copied values
+	if (ANoxCharacter* NoxCharacter = Cast<ANoxCharacter>(InAnimInstance->TryGetPawnOwner()))
+	{
+		OwnerVelocity = NoxCharacter->GetVelocity();
+		OwnerRotation = NoxCharacter->GetActorRotation();
+		bIsInAir = NoxCharacter->GetCharacterMovement() != NULL && NoxCharacter->GetCharacterMovement()->IsFalling();
+		bIsAttacking = NoxCharacter->IsAttacking();
+		bIsWeaponEquipped = NoxCharacter->IsWeaponEquipped();
+		bIsAlive = NoxCharacter->IsAlive();
+	}
+}
+
+void FNoxAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	// Runs on a worker thread when multi-threaded animation update is enabled
+	Speed = OwnerVelocity.Size();
+	bIsMoving = Speed > KINDA_SMALL_NUMBER;
+
+	if (bIsMoving)
+	{
+		const FVector LocalVelocity = OwnerRotation.UnrotateVector(OwnerVelocity);
+		Direction = FMath::RadiansToDegrees(FMath::Atan2(LocalVelocity.Y, LocalVelocity.X));
+	}
+	else
+	{
+		Direction = 0.f;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxAnimInstance
+//////////////////////////////////////////////////////////////////////////
+
+FAnimInstanceProxy* UNoxAnimInstance::CreateAnimInstanceProxy()
+{
+	return &Proxy;
+}
+
+void UNoxAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	// Proxy is a member, nothing to delete
+}
+
+void UNoxAnimInstance::AddHitBoxListener(INoxHitBoxListener* Listener, const bool bWantsTick)
+{
+	if (Listener == NULL)
+	{
+		return;
+	}
+
+	HitBoxListeners.AddUnique(Listener);
+
+	if (bWantsTick)
+	{
+		HitBoxTickListeners.AddUnique(Listener);
+	}
+}
+
+void UNoxAnimInstance::RemoveHitBoxListener(INoxHitBoxListener* Listener)
+{
+	HitBoxListeners.Remove(Listener);
+	HitBoxTickListeners.Remove(Listener);
+}
+
+void UNoxAnimInstance::DispatchHitBoxNotifyBegin(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	for (INoxHitBoxListener* Listener : HitBoxListeners)
+	{
+		Listener->OnHitBoxNotifyBegin(CollisionPart, BranchingPointPayload);
+	}
+
+	if (OnHitBoxNotifyBegin.IsBound())
+	{
+		OnHitBoxNotifyBegin.Broadcast(CollisionPart, BranchingPointPayload);
+	}
+}
+
+void UNoxAnimInstance::DispatchHitBoxNotifyEnd(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	for (INoxHitBoxListener* Listener : HitBoxListeners)
+	{
+		Listener->OnHitBoxNotifyEnd(CollisionPart, BranchingPointPayload);
+	}
+
+	if (OnHitBoxNotifyEnd.IsBound())
+	{
+		OnHitBoxNotifyEnd.Broadcast(CollisionPart, BranchingPointPayload);
+	}
+}
+
+void UNoxAnimInstance::DispatchHitBoxNotifyTick(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	for (INoxHitBoxListener* Listener : HitBoxTickListeners)
+	{
+		Listener->OnHitBoxNotifyTick(CollisionPart, BranchingPointPayload);
+	}
+
+	if (OnHitBoxNotifyTick.IsBound())
+	{
+		OnHitBoxNotifyTick.Broadcast(CollisionPart, BranchingPointPayload);
+	}
+}
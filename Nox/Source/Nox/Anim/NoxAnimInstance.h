@@ -4,12 +4,84 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Nox/Anim/AnimNotify/HitBoxNotify.h"
 #include "NoxAnimInstance.generated.h"
 
 
 /** Delegate called by 'HitBoxNotify'(not implemented yet) and 'HitBoxNotifyWindow' **/
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FHitBoxAnimNotifyDelegate, const ECollisionPart&, CollisionPart, const FBranchingPointNotifyPayload&, BranchingPointPayload);
 
+/**
+ * Native receiver of hitbox notifies. Called directly by UNoxAnimInstance, without reflection.
+ * Register with UNoxAnimInstance::AddHitBoxListener() and remove before listener is destroyed.
+ */
+class NOX_API INoxHitBoxListener
+{
+public:
+	virtual ~INoxHitBoxListener() {}
+
+	/** Called when a montage hits a 'HitBoxNotify' or 'HitBoxNotifyWindow' begin */
+	virtual void OnHitBoxNotifyBegin(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload) {}
+
+	/** Called when a montage hits a 'HitBoxNotifyWindow' end */
+	virtual void OnHitBoxNotifyEnd(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload) {}
+
+	/** Called every frame of 'HitBoxNotifyWindow', only for listeners added with bWantsTick */
+	virtual void OnHitBoxNotifyTick(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload) {}
+};
+
+/**
+ * Animation state of ANoxCharacter. Gathered once per frame on the game thread in PreUpdate(), rest of the update runs on a worker thread.
+ * Anim graph reads these values through UNoxAnimInstance::Proxy, so member access stays on the fast path.
+ */
+USTRUCT(BlueprintType)
+struct NOX_API FNoxAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FNoxAnimInstanceProxy()
+		: FAnimInstanceProxy()
+	{}
+
+	FNoxAnimInstanceProxy(UAnimInstance* Instance)
+		: FAnimInstanceProxy(Instance)
+	{}
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		float Speed = 0.f;
+
+	// Angle between velocity and facing of the character, in degrees (-180, 180)
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		float Direction = 0.f;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		bool bIsMoving = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		bool bIsInAir = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		bool bIsAttacking = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		bool bIsWeaponEquipped = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox")
+		bool bIsAlive = true;
+
+protected:
+	// FAnimInstanceProxy interface
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+	// End FAnimInstanceProxy interface
+
+private:
+	// Copied from the character in PreUpdate(), used by Update() on a worker thread
+	FVector OwnerVelocity = FVector::ZeroVector;
+	FRotator OwnerRotation = FRotator::ZeroRotator;
+};
+
 /**
  * 
  */
@@ -20,13 +92,49 @@ class NOX_API UNoxAnimInstance : public UAnimInstance
 
 public: 
 
+	// Blueprint bridge. Delegates are broadcast only when something is bound, native code should use INoxHitBoxListener.
+
 	/** Called when a montage hits a 'HitBoxNotify' or 'HitBoxNotifyWindow' begin */	
-	FHitBoxAnimNotifyDelegate OnHitBoxNotifyBegin;
+	UPROPERTY(BlueprintAssignable, Category = "HitBox")
+		FHitBoxAnimNotifyDelegate OnHitBoxNotifyBegin;
 
 	/** Called when a montage hits a 'HitBoxNotifyWindow' end */
-	FHitBoxAnimNotifyDelegate OnHitBoxNotifyEnd;
+	UPROPERTY(BlueprintAssignable, Category = "HitBox")
+		FHitBoxAnimNotifyDelegate OnHitBoxNotifyEnd;
 
 	/** Called during whole notify state duration */
-	FHitBoxAnimNotifyDelegate OnHitBoxNotifyTick;
+	UPROPERTY(BlueprintAssignable, Category = "HitBox")
+		FHitBoxAnimNotifyDelegate OnHitBoxNotifyTick;
+
+public:
+	/** Add native listener of hitbox notifies
+	*@param bWantsTick - Listener receives OnHitBoxNotifyTick() every frame of a hit window
+	*/
+	void AddHitBoxListener(INoxHitBoxListener* Listener, const bool bWantsTick = false);
+
+	void RemoveHitBoxListener(INoxHitBoxListener* Listener);
+
+	// Called by hitbox notifies
+	void DispatchHitBoxNotifyBegin(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload);
+	void DispatchHitBoxNotifyEnd(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload);
+	void DispatchHitBoxNotifyTick(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload);
+
+	// Notify window can skip per frame dispatch when this is false
+	FORCEINLINE bool WantsHitBoxNotifyTick() const { return HitBoxTickListeners.Num() > 0 || OnHitBoxNotifyTick.IsBound(); }
+
+protected:
+	// UAnimInstance interface
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+	// End UAnimInstance interface
+
+	// Owned by this instance, so graph can read it as a regular member
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Nox", Meta = (AllowPrivateAccess = "true"))
+		FNoxAnimInstanceProxy Proxy;
+
+private:
+	TArray<INoxHitBoxListener*> HitBoxListeners;
 
+	// Subset of HitBoxListeners that receive OnHitBoxNotifyTick()
+	TArray<INoxHitBoxListener*> HitBoxTickListeners;
 };
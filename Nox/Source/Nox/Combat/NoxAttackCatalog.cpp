@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxAttackCatalog.h"
+
+const FPrimaryAssetType UNoxAttackCatalog::PrimaryAssetType = FName("NoxAttackCatalog");
+const FName UNoxAttackCatalog::UnarmedBundle = FName("Unarmed");
+const FName UNoxAttackCatalog::WeaponBundle = FName("Weapon");
+
+UNoxAttackCatalog* UNoxAttackCatalog::CreateFromLegacyAttacks(UObject* Outer, const TArray<FUnarmedAttack>& InUnarmedAttacks, const TArray<FWeaponAttack>& InWeaponAttacks)
+{
+	// Public, so level instances can keep pointing to catalog of their Blueprint defaults
+	UNoxAttackCatalog* Catalog = NewObject<UNoxAttackCatalog>(Outer, NAME_None, RF_Public);
+	Catalog->UnarmedAttacks = InUnarmedAttacks;
+	Catalog->WeaponAttacks = InWeaponAttacks;
+	Catalog->CompileAttacks();
+
+	return Catalog;
+}
+
+FPrimaryAssetId UNoxAttackCatalog::GetPrimaryAssetId() const
+{
+	if (!IsAsset())
+	{
+		return FPrimaryAssetId();
+	}
+
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+void UNoxAttackCatalog::PostLoad()
+{
+	Super::PostLoad();
+
+	CompileAttacks();
+}
+
+#if WITH_EDITOR
+void UNoxAttackCatalog::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompileAttacks();
+}
+#endif
+
+int32 UNoxAttackCatalog::GetUnarmedAttackIndex(const int32 UnarmedAttackToUse) const
+{
+	// Unarmed attacks are stored at the beginning of Attacks array, so index is the same
+	if (UnarmedAttackToUse >= 0 && UnarmedAttackToUse < NumUnarmedAttacks)
+	{
+		return UnarmedAttackToUse;
+	}
+
+	return INDEX_NONE;
+}
+
+void UNoxAttackCatalog::GetUnarmedAttackAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	for (int32 AttackIndex = 0; AttackIndex < NumUnarmedAttacks; AttackIndex++)
+	{
+		if (!Attacks[AttackIndex].Montage.IsNull())
+		{
+			OutAssets.AddUnique(Attacks[AttackIndex].Montage.ToSoftObjectPath());
+		}
+	}
+}
+
+void UNoxAttackCatalog::GetWeaponAttackAssets(const FGameplayTag& WeaponTag, TArray<FSoftObjectPath>& OutAssets) const
+{
+	const int32 AttackIndex = FindWeaponAttackIndex(WeaponTag);
+	if (AttackIndex != INDEX_NONE && !Attacks[AttackIndex].Montage.IsNull())
+	{
+		OutAssets.AddUnique(Attacks[AttackIndex].Montage.ToSoftObjectPath());
+	}
+}
+
+int32 UNoxAttackCatalog::FindWeaponAttackIndex(const FGameplayTag& WeaponTag) const
+{
+	const int32* AttackIndex = WeaponAttackIndexByTag.Find(WeaponTag);
+
+	return AttackIndex != NULL ? *AttackIndex : INDEX_NONE;
+}
+
+void UNoxAttackCatalog::CompileAttacks()
+{
+	Attacks.Reset(UnarmedAttacks.Num() + WeaponAttacks.Num());
+	WeaponAttackIndexByTag.Reset();
+
+	for (const FUnarmedAttack& UnarmedAttack : UnarmedAttacks)
+	{
+		FNoxAttackDefinition& Attack = Attacks.AddDefaulted_GetRef();
+		Attack.Montage = UnarmedAttack.Montage;
+		Attack.AttackDamageParams = UnarmedAttack.AttackDamageParams;
+		Attack.MeleeCollisionParams = UnarmedAttack.MeleeCollisionParams;
+	}
+
+	NumUnarmedAttacks = Attacks.Num();
+
+	for (const FWeaponAttack& WeaponAttack : WeaponAttacks)
+	{
+		if (!WeaponAttack.Tag.IsValid())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Weapon attack without tag in %s will never be used"), *GetName());
+			continue;
+		}
+
+		// First attack with given tag is used, same as when attacks were searched one by one
+		if (WeaponAttackIndexByTag.Contains(WeaponAttack.Tag))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Weapon attack with tag %s is duplicated in %s"), *WeaponAttack.Tag.ToString(), *GetName());
+			continue;
+		}
+
+		WeaponAttackIndexByTag.Add(WeaponAttack.Tag, Attacks.Num());
+
+		FNoxAttackDefinition& Attack = Attacks.AddDefaulted_GetRef();
+		Attack.Montage = WeaponAttack.Montage;
+		Attack.AttackDamageParams = WeaponAttack.AttackDamageParams;
+		Attack.MeleeCollisionParams = WeaponAttack.MeleeCollisionParams;
+		Attack.bIsWeaponAttack = true;
+		Attack.bOverrideMeleeCollisionParams = WeaponAttack.bOverrideMeleeCollisionParams;
+		Attack.bUseHandCollisionWithWeaponAttack = WeaponAttack.bUseHandCollisionWithWeaponAttack;
+
+		// If weapon attack does not override params, DrawDebugTrace is greyed out in editor and should not be used
+		if (!WeaponAttack.bOverrideMeleeCollisionParams)
+		{
+			Attack.MeleeCollisionParams.DrawDebugTrace = EDrawDebugTrace::None;
+		}
+	}
+}
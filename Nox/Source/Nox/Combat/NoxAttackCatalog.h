@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Engine/DataAsset.h"
+#include "Nox/Weapons/BaseWeapon.h"
+#include "NoxAttackCatalog.generated.h"
+
+USTRUCT(BlueprintType)
+struct FUnarmedAttack
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (AssetBundles = "Unarmed"))
+		TSoftObjectPtr<UAnimMontage> Montage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		FAttackDamageParams AttackDamageParams;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		FMeleeCollisionParams MeleeCollisionParams;
+};
+
+USTRUCT(BlueprintType)
+struct FWeaponAttack
+{
+	GENERATED_BODY()
+
+	// Montage tag used to determine for which weapon this animation should be played.
+	//	e.g. Weapon have tag Sword.HeavyAttack. Montage with that tag will be played when character attack with a weapon.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FGameplayTag Tag;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (AssetBundles = "Weapon"))
+		TSoftObjectPtr<UAnimMontage> Montage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		FAttackDamageParams AttackDamageParams;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta =(InlineEditConditionToggle))
+		bool bOverrideMeleeCollisionParams;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (DisplayName = "Override Melee Collision Params", EditCondition = "bOverrideMeleeCollisionParams"))
+		FMeleeCollisionParams MeleeCollisionParams;
+
+	// Turn on collision for hands when attacking with weapon (only usable with weapon that use Trace Socket Collision)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (DisplayAfter = "MeleeCollisionParams", EditCondition = "bOverrideMeleeCollisionParams"))
+		bool bUseHandCollisionWithWeaponAttack;
+};
+
+/** Flat attack built from FUnarmedAttack or FWeaponAttack when catalog is loaded. Never changed at runtime. */
+struct FNoxAttackDefinition
+{
+	// Streamed in by catalog bundles, can be not loaded yet
+	TSoftObjectPtr<UAnimMontage> Montage;
+
+	FAttackDamageParams AttackDamageParams;
+
+	FMeleeCollisionParams MeleeCollisionParams;
+
+	bool bIsWeaponAttack = false;
+
+	bool bOverrideMeleeCollisionParams = false;
+
+	bool bUseHandCollisionWithWeaponAttack = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+/// UNoxAttackCatalog CLASS
+///////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Attacks of one character archetype. Asset is shared by all characters that use it, characters keep only index of the current attack.
+ * Catalog is a primary asset. Its montages are soft references loaded with Asset Manager bundles ("Unarmed" and "Weapon").
+ */
+UCLASS(BlueprintType)
+class NOX_API UNoxAttackCatalog : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Animation montages to play when attack without a weapon is done
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unarmed Attack")
+		TArray<FUnarmedAttack> UnarmedAttacks;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Attack")
+		TArray<FWeaponAttack> WeaponAttacks;
+
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	// Bundle with montages of unarmed attacks
+	static const FName UnarmedBundle;
+
+	// Bundle with montages of all weapon attacks
+	static const FName WeaponBundle;
+
+	/** Build catalog from attacks that used to be saved on ANoxCharacter.
+	*@param Outer - Character that owned the attacks, catalog is saved together with it
+	*/
+	static UNoxAttackCatalog* CreateFromLegacyAttacks(UObject* Outer, const TArray<FUnarmedAttack>& InUnarmedAttacks, const TArray<FWeaponAttack>& InWeaponAttacks);
+
+	// Invalid for catalogs that are not stand-alone assets
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/** @return - Index of unarmed attack in this catalog or INDEX_NONE */
+	int32 GetUnarmedAttackIndex(const int32 UnarmedAttackToUse) const;
+
+	/** @return - Index of attack for weapon with given tag or INDEX_NONE */
+	int32 FindWeaponAttackIndex(const FGameplayTag& WeaponTag) const;
+
+	FORCEINLINE bool IsValidAttackIndex(const int32 AttackIndex) const { return Attacks.IsValidIndex(AttackIndex); }
+
+	FORCEINLINE const FNoxAttackDefinition& GetAttack(const int32 AttackIndex) const { return Attacks[AttackIndex]; }
+
+	// Add assets used by all unarmed attacks, for catalogs that are not loaded through Asset Manager bundles
+	void GetUnarmedAttackAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
+	// Add assets used by attacks of a weapon with given tag. Lets single weapon type be streamed in without whole "Weapon" bundle.
+	void GetWeaponAttackAssets(const FGameplayTag& WeaponTag, TArray<FSoftObjectPath>& OutAssets) const;
+
+private:
+	// Build Attacks and WeaponAttackIndexByTag from UnarmedAttacks and WeaponAttacks
+	void CompileAttacks();
+
+	// Unarmed attacks first, then weapon attacks
+	TArray<FNoxAttackDefinition> Attacks;
+
+	TMap<FGameplayTag, int32> WeaponAttackIndexByTag;
+
+	int32 NumUnarmedAttacks = 0;
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxCombatAssetLibrary.h"
+#include "NoxAttackCatalog.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/Weapons/BaseWeapon.h"
+#include "Engine/AssetManager.h"
+
+void UNoxCombatAssetLibrary::PreloadCharacterArchetype(TSoftClassPtr<ANoxCharacter> CharacterClass)
+{
+	if (CharacterClass.IsNull())
+	{
+		return;
+	}
+
+	// Managed handle keeps class loaded after request is done
+	UAssetManager::GetStreamableManager().RequestAsyncLoad(CharacterClass.ToSoftObjectPath(), FStreamableDelegate::CreateStatic(&UNoxCombatAssetLibrary::OnCharacterClassLoaded, CharacterClass), FStreamableManager::DefaultAsyncLoadPriority, true);
+}
+
+void UNoxCombatAssetLibrary::PreloadWeapon(UNoxAttackCatalog* AttackCatalog, TSoftClassPtr<ABaseWeapon> WeaponClass)
+{
+	if (WeaponClass.IsNull())
+	{
+		return;
+	}
+
+	UAssetManager::GetStreamableManager().RequestAsyncLoad(WeaponClass.ToSoftObjectPath(), FStreamableDelegate::CreateStatic(&UNoxCombatAssetLibrary::OnWeaponClassLoaded, TWeakObjectPtr<UNoxAttackCatalog>(AttackCatalog), WeaponClass), FStreamableManager::DefaultAsyncLoadPriority, true);
+}
+
+void UNoxCombatAssetLibrary::OnCharacterClassLoaded(TSoftClassPtr<ANoxCharacter> CharacterClass)
+{
+	if (CharacterClass.Get() == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to preload character class %s"), *CharacterClass.ToString());
+		return;
+	}
+
+	const ANoxCharacter* CharacterDefaults = CharacterClass.Get()->GetDefaultObject<ANoxCharacter>();
+
+	UAssetManager& AssetManager = UAssetManager::Get();
+
+	if (CharacterDefaults->GetAttackCatalog() != NULL)
+	{
+		AssetManager.LoadPrimaryAsset(CharacterDefaults->GetAttackCatalog()->GetPrimaryAssetId(), { UNoxAttackCatalog::UnarmedBundle });
+	}
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+	CharacterDefaults->GetCombatAssetsToPreload(AssetsToLoad);
+
+	if (AssetsToLoad.Num() > 0)
+	{
+		AssetManager.GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate(), FStreamableManager::DefaultAsyncLoadPriority, true);
+	}
+}
+
+void UNoxCombatAssetLibrary::OnWeaponClassLoaded(TWeakObjectPtr<UNoxAttackCatalog> AttackCatalog, TSoftClassPtr<ABaseWeapon> WeaponClass)
+{
+	if (WeaponClass.Get() == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to preload weapon class %s"), *WeaponClass.ToString());
+		return;
+	}
+
+	if (AttackCatalog.IsValid())
+	{
+		TArray<FSoftObjectPath> AssetsToLoad;
+		AttackCatalog->GetWeaponAttackAssets(WeaponClass.Get()->GetDefaultObject<ABaseWeapon>()->WeaponTag, AssetsToLoad);
+
+		if (AssetsToLoad.Num() > 0)
+		{
+			UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate(), FStreamableManager::DefaultAsyncLoadPriority, true);
+		}
+	}
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "NoxCombatAssetLibrary.generated.h"
+
+/**
+ * Stream in combat assets ahead of need, e.g. from a trigger when NPC type is about to enter a region or when weapon is added to inventory.
+ * Assets stay loaded after request, nothing waits for them on the game thread.
+ */
+UCLASS()
+class NOX_API UNoxCombatAssetLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Load character class, unarmed attacks of its catalog, death and equip montages and weapon class
+	UFUNCTION(BlueprintCallable, Category = "Nox|Assets")
+		static void PreloadCharacterArchetype(TSoftClassPtr<class ANoxCharacter> CharacterClass);
+
+	// Load weapon class and attacks of the catalog that are done with this type of weapon
+	UFUNCTION(BlueprintCallable, Category = "Nox|Assets")
+		static void PreloadWeapon(class UNoxAttackCatalog* AttackCatalog, TSoftClassPtr<class ABaseWeapon> WeaponClass);
+
+private:
+	static void OnCharacterClassLoaded(TSoftClassPtr<class ANoxCharacter> CharacterClass);
+
+	static void OnWeaponClassLoaded(TWeakObjectPtr<class UNoxAttackCatalog> AttackCatalog, TSoftClassPtr<class ABaseWeapon> WeaponClass);
+};
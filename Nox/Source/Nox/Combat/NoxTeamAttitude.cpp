@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxTeamAttitude.h"
+#include "GameFramework/Actor.h"
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxTeamSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxTeamSettings::UNoxTeamSettings()
+{
+	SameTeamAttitude = ETeamAttitude::Friendly;
+	OtherTeamAttitude = ETeamAttitude::Hostile;
+	NoTeamAttitude = ETeamAttitude::Neutral;
+}
+
+#if WITH_EDITOR
+void UNoxTeamSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	FNoxTeamAttitude::Rebuild();
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// FNoxTeamAttitude
+//////////////////////////////////////////////////////////////////////////
+
+uint32 FNoxTeamAttitude::PackedAttitudes[256 * 256 / 16];
+
+void FNoxTeamAttitude::Initialize()
+{
+	Rebuild();
+
+	FGenericTeamId::SetAttitudeSolver(FNoxTeamAttitude::GetAttitude);
+}
+
+void FNoxTeamAttitude::Rebuild()
+{
+	const UNoxTeamSettings* Settings = GetDefault<UNoxTeamSettings>();
+	const uint8 NoTeam = FGenericTeamId::NoTeam.GetId();
+
+	for (int32 Team = 0; Team < 256; Team++)
+	{
+		for (int32 OtherTeam = 0; OtherTeam < 256; OtherTeam++)
+		{
+			ETeamAttitude::Type Attitude = Team == OtherTeam ? Settings->SameTeamAttitude : Settings->OtherTeamAttitude;
+
+			if (Team == NoTeam || OtherTeam == NoTeam)
+			{
+				Attitude = Settings->NoTeamAttitude;
+			}
+
+			SetAttitude(Team, OtherTeam, Attitude);
+		}
+	}
+
+	for (const FNoxTeamAttitudeRule& Rule : Settings->Rules)
+	{
+		SetAttitude(Rule.Team, Rule.OtherTeam, Rule.Attitude);
+
+		if (Rule.bSymmetric)
+		{
+			SetAttitude(Rule.OtherTeam, Rule.Team, Rule.Attitude);
+		}
+	}
+}
+
+ETeamAttitude::Type FNoxTeamAttitude::GetAttitudeTowards(FGenericTeamId Team, const AActor& Other)
+{
+	const IGenericTeamAgentInterface* OtherTeamAgent = Cast<const IGenericTeamAgentInterface>(&Other);
+
+	return GetAttitude(Team, OtherTeamAgent != NULL ? OtherTeamAgent->GetGenericTeamId() : FGenericTeamId::NoTeam);
+}
+
+void FNoxTeamAttitude::SetAttitude(uint8 Team, uint8 OtherTeam, ETeamAttitude::Type Attitude)
+{
+	const uint32 PairIndex = ((uint32)Team << 8) | OtherTeam;
+	const uint32 Shift = (PairIndex & 15) << 1;
+
+	uint32& Word = PackedAttitudes[PairIndex >> 4];
+	Word = (Word & ~(3u << Shift)) | (((uint32)Attitude & 3) << Shift);
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GenericTeamAgentInterface.h"
+#include "Engine/DeveloperSettings.h"
+#include "NoxTeamAttitude.generated.h"
+
+
+USTRUCT(BlueprintType)
+struct FNoxTeamAttitudeRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		uint8 Team = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		uint8 OtherTeam = 0;
+
+	// Attitude of Team towards OtherTeam
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		TEnumAsByte<ETeamAttitude::Type> Attitude = ETeamAttitude::Hostile;
+
+	// Set the same attitude of OtherTeam towards Team
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		bool bSymmetric = true;
+};
+
+/**
+ * Attitudes between teams (FGenericTeamId). Values are set in DefaultGame.ini.
+ * Rules are applied in order over the defaults, so later rules win.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Teams"))
+class NOX_API UNoxTeamSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxTeamSettings();
+
+	// Attitude of a team towards itself
+	UPROPERTY(config, EditAnywhere, Category = "Defaults")
+		TEnumAsByte<ETeamAttitude::Type> SameTeamAttitude;
+
+	// Attitude between two different teams
+	UPROPERTY(config, EditAnywhere, Category = "Defaults")
+		TEnumAsByte<ETeamAttitude::Type> OtherTeamAttitude;
+
+	// Attitude of every team towards FGenericTeamId::NoTeam (255) and of NoTeam towards every team. Dead characters are in NoTeam.
+	UPROPERTY(config, EditAnywhere, Category = "Defaults")
+		TEnumAsByte<ETeamAttitude::Type> NoTeamAttitude;
+
+	UPROPERTY(config, EditAnywhere, Category = "Rules")
+		TArray<FNoxTeamAttitudeRule> Rules;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+/// FNoxTeamAttitude
+///////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 256 x 256 attitude table built from UNoxTeamSettings, 2 bits per pair of teams.
+ * Installed as attitude solver of FGenericTeamId, so every attitude query of the engine and of Nox controllers is one array lookup.
+ */
+class NOX_API FNoxTeamAttitude
+{
+public:
+	// Build table from settings and install it as FGenericTeamId attitude solver
+	static void Initialize();
+
+	// Rebuild table from current settings
+	static void Rebuild();
+
+	FORCEINLINE static ETeamAttitude::Type GetAttitude(FGenericTeamId Team, FGenericTeamId OtherTeam)
+	{
+		const uint32 PairIndex = ((uint32)Team.GetId() << 8) | OtherTeam.GetId();
+		return (ETeamAttitude::Type)((PackedAttitudes[PairIndex >> 4] >> ((PairIndex & 15) << 1)) & 3);
+	}
+
+	/** @return - Attitude of Team towards Other actor, NoTeam is used for actors that do not implement IGenericTeamAgentInterface */
+	static ETeamAttitude::Type GetAttitudeTowards(FGenericTeamId Team, const AActor& Other);
+
+private:
+	static void SetAttitude(uint8 Team, uint8 OtherTeam, ETeamAttitude::Type Attitude);
+
+	// 16 pairs per word
+	static uint32 PackedAttitudes[256 * 256 / 16];
+};
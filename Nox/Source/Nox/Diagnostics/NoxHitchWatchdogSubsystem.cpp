@@ -0,0 +1,350 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxHitchWatchdogSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/Weapons/Projectiles/NoxProjectileSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "RenderCore.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	// Ring buffer is sized for this frame rate, faster frames make the written window shorter
+	const float MaxRecordedFramesPerSecond = 240.f;
+
+	const TCHAR* HitchScopeNames[(int32)ENoxHitchScope::HS_MAX] =
+	{
+		TEXT("SignificanceMs"),
+		TEXT("SightMs"),
+		TEXT("AISchedulerMs"),
+		TEXT("PathRequestsMs"),
+		TEXT("FlowFieldMs"),
+		TEXT("ProjectilesMs"),
+		TEXT("HitscanMs"),
+		TEXT("ReplicationMs"),
+	};
+}
+
+uint32 UNoxHitchWatchdogSubsystem::ScopeCycles[(int32)ENoxHitchScope::HS_MAX] = { 0 };
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxHitchWatchdogSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxHitchWatchdogSettings::UNoxHitchWatchdogSettings()
+{
+	bEnabled = true;
+	HitchThresholdMs = 50.f;
+	HistorySeconds = 5.f;
+	PostHitchSeconds = 2.f;
+	MinSecondsBetweenCaptures = 10.f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxHitchWatchdogSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxHitchWatchdogSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UNoxHitchWatchdogSettings* Settings = GetDefault<UNoxHitchWatchdogSettings>();
+
+	bIsEnabled = Settings->bEnabled && !FParse::Param(FCommandLine::Get(), TEXT("NoNoxHitchWatchdog"));
+	HitchThresholdMs = Settings->HitchThresholdMs;
+
+	NextFrameIndex = 0;
+	NumFrames = 0;
+	PendingAttacks = 0;
+	PendingDeaths = 0;
+	bIsCapturing = false;
+	CaptureTimeLeft = 0.f;
+	LastCaptureTime = 0.0;
+	LastTickTime = 0.0;
+	NumHitches = 0;
+
+	OutputDir = FPaths::ProfilingDir() / TEXT("NoxHitch");
+
+	if (bIsEnabled)
+	{
+		// Allocated once, recording never allocates
+		const int32 Capacity = FMath::CeilToInt((Settings->HistorySeconds + Settings->PostHitchSeconds) * MaxRecordedFramesPerSecond);
+		Frames.SetNum(FMath::Max(Capacity, 1));
+	}
+}
+
+void UNoxHitchWatchdogSubsystem::Deinitialize()
+{
+	Frames.Empty();
+	Deaths.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UNoxHitchWatchdogSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && bIsEnabled;
+}
+
+TStatId UNoxHitchWatchdogSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxHitchWatchdogSubsystem, STATGROUP_Nox);
+}
+
+void UNoxHitchWatchdogSubsystem::Tick(float DeltaTime)
+{
+	// Wall time between ticks, fixed time step of simulation or replay would hide hitches in DeltaTime
+	const double Now = FPlatformTime::Seconds();
+	const float FrameMs = LastTickTime > 0.0 ? (float)((Now - LastTickTime) * 1000.0) : 0.f;
+	LastTickTime = Now;
+
+	FHitchFrame& Frame = Frames[NextFrameIndex];
+	Frame.FrameNumber = GFrameCounter;
+	Frame.WorldTime = GetWorld()->GetTimeSeconds();
+	Frame.FrameMs = FrameMs;
+
+	// Thread times are of the previous frame. GGameThreadTime stays 0 on dedicated server, so game thread is the frame without idle time.
+	Frame.GameThreadMs = FMath::Max(FrameMs - (float)(FApp::GetIdleTime() * 1000.0), 0.f);
+	Frame.RenderThreadMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	Frame.GPUMs = FPlatformTime::ToMilliseconds(GGPUFrameTime);
+
+	// Scopes ticked after the watchdog (replication) land in the next frame
+	for (int32 ScopeIndex = 0; ScopeIndex < (int32)ENoxHitchScope::HS_MAX; ScopeIndex++)
+	{
+		Frame.ScopeMs[ScopeIndex] = FPlatformTime::ToMilliseconds(ScopeCycles[ScopeIndex]);
+		ScopeCycles[ScopeIndex] = 0;
+	}
+
+	const UNoxProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UNoxProjectileSubsystem>();
+	Frame.NumProjectiles = ProjectileSubsystem != NULL ? ProjectileSubsystem->GetNumProjectiles() : 0;
+
+	Frame.NumAttacks = PendingAttacks;
+	Frame.NumDeaths = PendingDeaths;
+	PendingAttacks = 0;
+	PendingDeaths = 0;
+
+	NextFrameIndex = (NextFrameIndex + 1) % Frames.Num();
+	NumFrames = FMath::Min(NumFrames + 1, Frames.Num());
+
+	if (bIsCapturing)
+	{
+		CaptureTimeLeft -= FrameMs / 1000.f;
+		if (CaptureTimeLeft <= 0.f)
+		{
+			FinishCapture();
+		}
+	}
+	else if (FrameMs > HitchThresholdMs)
+	{
+		NumHitches++;
+
+		if (LastCaptureTime == 0.0 || Now - LastCaptureTime >= GetDefault<UNoxHitchWatchdogSettings>()->MinSecondsBetweenCaptures)
+		{
+			StartCapture(FString::Printf(TEXT("Frame %llu took %.1f ms"), Frame.FrameNumber, FrameMs));
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Hitch of %.1f ms at frame %llu, too close to the last capture"), FrameMs, Frame.FrameNumber);
+		}
+	}
+}
+
+void UNoxHitchWatchdogSubsystem::NoteAttack()
+{
+	if (bIsEnabled && PendingAttacks < MAX_uint16)
+	{
+		PendingAttacks++;
+	}
+}
+
+void UNoxHitchWatchdogSubsystem::NoteDeath(const ANoxCharacter* Character)
+{
+	if (!bIsEnabled)
+	{
+		return;
+	}
+
+	if (PendingDeaths < MAX_uint16)
+	{
+		PendingDeaths++;
+	}
+
+	// Drop deaths that left the window
+	const uint64 OldestFrameNumber = NumFrames > 0 ? Frames[(NextFrameIndex - NumFrames + Frames.Num()) % Frames.Num()].FrameNumber : 0;
+	Deaths.RemoveAll([OldestFrameNumber](const FHitchDeath& Death) { return Death.FrameNumber < OldestFrameNumber; });
+
+	FHitchDeath& Death = Deaths.AddDefaulted_GetRef();
+	Death.FrameNumber = GFrameCounter;
+	Death.CharacterName = Character->GetName();
+	Death.Location = Character->GetActorLocation();
+}
+
+void UNoxHitchWatchdogSubsystem::RequestCapture(const FString& Reason)
+{
+	if (!bIsEnabled)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Hitch watchdog is disabled"));
+		return;
+	}
+
+	if (bIsCapturing)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Hitch capture is already running"));
+		return;
+	}
+
+	StartCapture(Reason);
+}
+
+void UNoxHitchWatchdogSubsystem::StartCapture(const FString& Reason)
+{
+	bIsCapturing = true;
+	CaptureTimeLeft = GetDefault<UNoxHitchWatchdogSettings>()->PostHitchSeconds;
+	CaptureReason = Reason;
+
+	// Context is taken at the hitch, not when the capture is written
+	CaptureContext = BuildContext();
+
+	UE_LOG(LogTemp, Warning, TEXT("Hitch capture started: %s"), *Reason);
+
+	if (CaptureTimeLeft <= 0.f)
+	{
+		FinishCapture();
+	}
+}
+
+void UNoxHitchWatchdogSubsystem::FinishCapture()
+{
+	bIsCapturing = false;
+	LastCaptureTime = FPlatformTime::Seconds();
+
+	const UNoxHitchWatchdogSettings* Settings = GetDefault<UNoxHitchWatchdogSettings>();
+	const float WindowMs = (Settings->HistorySeconds + Settings->PostHitchSeconds) * 1000.f;
+
+	// Walk back from the newest frame until the window is full
+	const int32 Capacity = Frames.Num();
+	int32 NumWindowFrames = 0;
+	float WindowSumMs = 0.f;
+	while (NumWindowFrames < NumFrames && WindowSumMs < WindowMs)
+	{
+		WindowSumMs += Frames[(NextFrameIndex - 1 - NumWindowFrames + Capacity) % Capacity].FrameMs;
+		NumWindowFrames++;
+	}
+
+	TArray<FHitchFrame> WindowFrames;
+	WindowFrames.Reserve(NumWindowFrames);
+	for (int32 Index = NumWindowFrames; Index > 0; Index--)
+	{
+		WindowFrames.Add(Frames[(NextFrameIndex - Index + Capacity) % Capacity]);
+	}
+
+	FString Header = FString::Printf(TEXT("# %s\n# Map %s\n%s"), *CaptureReason, *GetWorld()->GetMapName(), *CaptureContext);
+	for (const FHitchDeath& Death : Deaths)
+	{
+		if (WindowFrames.Num() > 0 && Death.FrameNumber >= WindowFrames[0].FrameNumber)
+		{
+			Header += FString::Printf(TEXT("# Died at frame %llu: %s at %s\n"), Death.FrameNumber, *Death.CharacterName, *Death.Location.ToString());
+		}
+	}
+
+	const FString Path = OutputDir / FString::Printf(TEXT("Hitch-%s-%llu.csv"), *FDateTime::Now().ToString(), GFrameCounter);
+
+	UE_LOG(LogTemp, Warning, TEXT("Hitch capture of %d frames written to %s"), WindowFrames.Num(), *Path);
+
+	// Formatting thousands of rows would be another hitch, game thread only copies the window
+	Async(EAsyncExecution::ThreadPool, [Path, Header, WindowFrames]()
+	{
+		FString Text = Header;
+		Text += TEXT("Frame,WorldTime,FrameMs,GameThreadMs,RenderThreadMs,GPUMs");
+		for (int32 ScopeIndex = 0; ScopeIndex < (int32)ENoxHitchScope::HS_MAX; ScopeIndex++)
+		{
+			Text += TEXT(",");
+			Text += HitchScopeNames[ScopeIndex];
+		}
+		Text += TEXT(",Projectiles,Attacks,Deaths\n");
+
+		for (const FHitchFrame& Frame : WindowFrames)
+		{
+			Text += FString::Printf(TEXT("%llu,%.3f,%.2f,%.2f,%.2f,%.2f"), Frame.FrameNumber, Frame.WorldTime, Frame.FrameMs, Frame.GameThreadMs, Frame.RenderThreadMs, Frame.GPUMs);
+			for (int32 ScopeIndex = 0; ScopeIndex < (int32)ENoxHitchScope::HS_MAX; ScopeIndex++)
+			{
+				Text += FString::Printf(TEXT(",%.3f"), Frame.ScopeMs[ScopeIndex]);
+			}
+			Text += FString::Printf(TEXT(",%d,%d,%d\n"), Frame.NumProjectiles, Frame.NumAttacks, Frame.NumDeaths);
+		}
+
+		FFileHelper::SaveStringToFile(Text, *Path);
+	});
+}
+
+FString UNoxHitchWatchdogSubsystem::BuildContext() const
+{
+	int32 NumNPCs = 0;
+	int32 NumPlayers = 0;
+	TArray<FString> Attackers;
+
+	for (TActorIterator<ANoxCharacter> It(GetWorld()); It; ++It)
+	{
+		if (!It->IsAlive())
+		{
+			continue;
+		}
+
+		if (It->IsPlayerControlled())
+		{
+			NumPlayers++;
+		}
+		else
+		{
+			NumNPCs++;
+		}
+
+		if (It->IsAttacking())
+		{
+			Attackers.Add(It->GetName());
+		}
+	}
+
+	return FString::Printf(TEXT("# Live NPCs %d, live players %d, hitches so far %d\n# Active attacks %d: %s\n"),
+		NumNPCs, NumPlayers, NumHitches, Attackers.Num(), *FString::Join(Attackers, TEXT(" ")));
+}
+
+namespace
+{
+	// Nox.Hitch.Capture [Reason] - write the window now, e.g. to compare with a hitch capture
+	void CaptureHitch(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UNoxHitchWatchdogSubsystem* Watchdog = World != NULL ? World->GetSubsystem<UNoxHitchWatchdogSubsystem>() : NULL)
+		{
+			Watchdog->RequestCapture(Args.Num() > 0 ? FString::Join(Args, TEXT(" ")) : TEXT("Requested by console"));
+		}
+	}
+
+	// Nox.Hitch.Threshold Ms - frame time that starts a capture
+	void SetHitchThreshold(const TArray<FString>& Args, UWorld* World)
+	{
+		UNoxHitchWatchdogSubsystem* Watchdog = World != NULL ? World->GetSubsystem<UNoxHitchWatchdogSubsystem>() : NULL;
+		if (Watchdog != NULL && Args.Num() > 0)
+		{
+			Watchdog->SetHitchThresholdMs(FCString::Atof(*Args[0]));
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs CaptureHitchCommand(
+		TEXT("Nox.Hitch.Capture"),
+		TEXT("Write frame times of the last seconds and the next seconds to Saved/Profiling/NoxHitch. Usage: Nox.Hitch.Capture [Reason]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&CaptureHitch));
+
+	FAutoConsoleCommandWithWorldAndArgs SetHitchThresholdCommand(
+		TEXT("Nox.Hitch.Threshold"),
+		TEXT("Frame time in ms that starts a hitch capture. Usage: Nox.Hitch.Threshold Ms"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SetHitchThreshold));
+}
@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/DeveloperSettings.h"
+#include "NoxHitchWatchdogSubsystem.generated.h"
+
+// Nox systems timed by the watchdog every frame. Every scope also has its own cycle stat in STATGROUP_Nox.
+enum class ENoxHitchScope : uint8
+{
+	HS_Significance,
+	HS_Sight,
+	HS_AIScheduler,
+	HS_PathRequests,
+	HS_FlowField,
+	HS_Projectiles,
+	HS_Hitscan,
+	HS_Replication,
+	HS_MAX
+};
+
+/**
+ * Hitch watchdog. Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Hitch Watchdog"))
+class NOX_API UNoxHitchWatchdogSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxHitchWatchdogSettings();
+
+	// Can also be turned off by -NoNoxHitchWatchdog
+	UPROPERTY(config, EditAnywhere, Category = "Watchdog")
+		bool bEnabled;
+
+	// Frame longer than this starts a capture, can be changed by Nox.Hitch.Threshold
+	UPROPERTY(config, EditAnywhere, Category = "Watchdog", meta = (ClampMin = "1"))
+		float HitchThresholdMs;
+
+	// Frames before the hitch written to the capture
+	UPROPERTY(config, EditAnywhere, Category = "Watchdog", meta = (ClampMin = "0.1"))
+		float HistorySeconds;
+
+	// Frames after the hitch written to the capture
+	UPROPERTY(config, EditAnywhere, Category = "Watchdog", meta = (ClampMin = "0"))
+		float PostHitchSeconds;
+
+	// Hitches right after a capture are usually the same problem, they only get logged
+	UPROPERTY(config, EditAnywhere, Category = "Watchdog", meta = (ClampMin = "0"))
+		float MinSecondsBetweenCaptures;
+};
+
+/**
+ * Keeps frame times, Nox scope times and combat counters of the last few seconds in a ring buffer.
+ * Frame over the threshold keeps recording for PostHitchSeconds and then writes the whole window to Saved/Profiling/NoxHitch/*.csv,
+ * together with context of the hitch: NPC count, characters in the middle of an attack and characters that died within the window.
+ * Frames without a hitch cost one copy of a small struct and two cycle reads per timed scope.
+ */
+UCLASS()
+class NOX_API UNoxHitchWatchdogSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	// Add time spent in a scope this frame, game thread only
+	static void AddScopeCycles(const ENoxHitchScope Scope, const uint32 Cycles) { ScopeCycles[(int32)Scope] += Cycles; }
+
+	void NoteAttack();
+
+	void NoteDeath(const class ANoxCharacter* Character);
+
+	// Write the current window without waiting for a hitch
+	void RequestCapture(const FString& Reason);
+
+	void SetHitchThresholdMs(const float InHitchThresholdMs) { HitchThresholdMs = FMath::Max(InHitchThresholdMs, 1.f); }
+
+private:
+	struct FHitchFrame
+	{
+		uint64 FrameNumber = 0;
+		float WorldTime = 0.f;
+		float FrameMs = 0.f;
+		float GameThreadMs = 0.f;
+		float RenderThreadMs = 0.f;
+		float GPUMs = 0.f;
+		float ScopeMs[(int32)ENoxHitchScope::HS_MAX] = { 0.f };
+		int32 NumProjectiles = 0;
+		uint16 NumAttacks = 0;
+		uint16 NumDeaths = 0;
+	};
+
+	struct FHitchDeath
+	{
+		uint64 FrameNumber = 0;
+		FString CharacterName;
+		FVector Location = FVector::ZeroVector;
+	};
+
+	// Cycles of timed scopes since the last tick of the watchdog
+	static uint32 ScopeCycles[(int32)ENoxHitchScope::HS_MAX];
+
+	bool bIsEnabled;
+
+	float HitchThresholdMs;
+
+	double LastTickTime;
+
+	// Ring buffer of frames, oldest frame is overwritten
+	TArray<FHitchFrame> Frames;
+	int32 NextFrameIndex;
+	int32 NumFrames;
+
+	// Counted since the last tick of the watchdog
+	uint16 PendingAttacks;
+	uint16 PendingDeaths;
+
+	// Deaths are rare, only names of the ones still in the window are kept
+	TArray<FHitchDeath> Deaths;
+
+	// Capture waits for frames after the hitch
+	bool bIsCapturing;
+	float CaptureTimeLeft;
+	FString CaptureReason;
+	FString CaptureContext;
+	double LastCaptureTime;
+
+	int32 NumHitches;
+
+	FString OutputDir;
+
+	void StartCapture(const FString& Reason);
+
+	// Copy the window and write it on a worker thread
+	void FinishCapture();
+
+	// Describe what the game was doing at the hitch
+	FString BuildContext() const;
+};
+
+// Time the rest of the scope for the hitch watchdog
+class FNoxHitchScopeCounter
+{
+public:
+	explicit FNoxHitchScopeCounter(const ENoxHitchScope InScope)
+		: Scope(InScope)
+		, StartCycles(FPlatformTime::Cycles())
+	{
+	}
+
+	~FNoxHitchScopeCounter()
+	{
+		UNoxHitchWatchdogSubsystem::AddScopeCycles(Scope, FPlatformTime::Cycles() - StartCycles);
+	}
+
+private:
+	ENoxHitchScope Scope;
+	uint32 StartCycles;
+};
+
+#define NOX_HITCH_SCOPE(Scope) FNoxHitchScopeCounter PREPROCESSOR_JOIN(NoxHitchScope_, __LINE__)(ENoxHitchScope::Scope)
@@ -0,0 +1,699 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxReplaySubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/NoxPlayerController.h"
+#include "Containers/CircularQueue.h"
+#include "Containers/Queue.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	const uint32 NoxReplayMagic = 0x52584F4E; // "NOXR"
+	const uint32 NoxReplayVersion = 2;
+
+	// Records that fit the ring buffer (power of two), about 1.5 MB. Writer empties it every 100 ms.
+	const uint32 NoxReplayBufferSize = 1 << 16;
+
+	struct FNoxReplayHeader
+	{
+		uint32 Magic = NoxReplayMagic;
+		uint32 Version = NoxReplayVersion;
+		int32 Seed = 0;
+		uint32 RecordSize = sizeof(FNoxReplayRecord);
+	};
+
+	const TCHAR* GetEventName(const ENoxReplayEvent Type)
+	{
+		switch (Type)
+		{
+		case ENoxReplayEvent::RE_Attack:		return TEXT("Attack");
+		case ENoxReplayEvent::RE_EquipWeapon:	return TEXT("EquipWeapon");
+		case ENoxReplayEvent::RE_MoveForward:	return TEXT("MoveForward");
+		case ENoxReplayEvent::RE_CursorHit:		return TEXT("CursorHit");
+		case ENoxReplayEvent::RE_AITarget:		return TEXT("AITarget");
+		case ENoxReplayEvent::RE_Damage:		return TEXT("Damage");
+		case ENoxReplayEvent::RE_BudgetCount:	return TEXT("BudgetCount");
+		default:								return TEXT("Other");
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FNoxReplayWriter
+//////////////////////////////////////////////////////////////////////////
+
+/**
+ * Single producer (game thread), single consumer (writer thread). Game thread never locks or waits for the disk.
+ * Records that do not fit the full buffer are dropped and counted.
+ */
+class FNoxReplayWriter : public FRunnable
+{
+public:
+	FNoxReplayWriter(FArchive* InFile)
+		: Records(NoxReplayBufferSize)
+		, File(InFile)
+		, bStopping(false)
+		, NumDropped(0)
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, TEXT("NoxReplayWriter"), 0, TPri_BelowNormal);
+	}
+
+	// Writes everything that is still queued
+	virtual ~FNoxReplayWriter()
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		delete File;
+	}
+
+	// Game thread only
+	void Enqueue(const FNoxReplayRecord& Record)
+	{
+		if (!Records.Enqueue(Record))
+		{
+			NumDropped++;
+		}
+	}
+
+	// Game thread only. Names are rare, so allocation of the linked queue is fine.
+	void EnqueueName(const uint16 ActorId, const FString& Name)
+	{
+		Names.Enqueue(TPair<uint16, FString>(ActorId, Name));
+	}
+
+	int32 GetNumDropped() const { return NumDropped; }
+
+	// FRunnable interface
+	virtual uint32 Run() override
+	{
+		while (!bStopping)
+		{
+			WakeEvent->Wait(100);
+			Drain();
+		}
+
+		Drain();
+		File->Flush();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+		WakeEvent->Trigger();
+	}
+	// End FRunnable interface
+
+private:
+	TCircularQueue<FNoxReplayRecord> Records;
+	TQueue<TPair<uint16, FString>, EQueueMode::Spsc> Names;
+
+	FArchive* File;
+	FEvent* WakeEvent;
+	FRunnableThread* Thread;
+	FThreadSafeBool bStopping;
+	int32 NumDropped;
+
+	// Writer thread only
+	TArray<FNoxReplayRecord> Batch;
+
+	void Drain()
+	{
+		// Name can be written after the first record using it, reader loads whole file before replay
+		TPair<uint16, FString> Name;
+		while (Names.Dequeue(Name))
+		{
+			FTCHARToUTF8 NameUtf8(*Name.Value);
+
+			FNoxReplayRecord NameRecord;
+			NameRecord.Type = ENoxReplayEvent::RE_ActorName;
+			NameRecord.ActorId = Name.Key;
+			NameRecord.OtherActorId = (uint16)FMath::Min(NameUtf8.Length(), (int32)MAX_uint16);
+
+			File->Serialize(&NameRecord, sizeof(NameRecord));
+			File->Serialize((void*)NameUtf8.Get(), NameRecord.OtherActorId);
+		}
+
+		Batch.Reset();
+
+		FNoxReplayRecord Record;
+		while (Records.Dequeue(Record))
+		{
+			Batch.Add(Record);
+		}
+
+		if (Batch.Num() > 0)
+		{
+			File->Serialize(Batch.GetData(), Batch.Num() * sizeof(FNoxReplayRecord));
+		}
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxReplaySubsystem
+//////////////////////////////////////////////////////////////////////////
+
+UNoxReplaySubsystem* UNoxReplaySubsystem::ActiveReplay = NULL;
+
+void UNoxReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsRecording = false;
+	bIsReplaying = false;
+	CurrentFrame = 0;
+	Seed = 0;
+	Writer = NULL;
+	NextActorId = 1;
+	LastRecordedCursor = FVector(BIG_NUMBER);
+	RecordCycles = 0;
+	RecordedFrameSeconds = 0.0;
+	FrameBegin = 0;
+	FrameEnd = 0;
+	bHasReplayedCursor = false;
+	ReplayedCursor = FVector::ZeroVector;
+	bPlayerInputDisabled = false;
+	bHasAppliedFirstFrame = false;
+	NumDivergences = 0;
+	CaptureFrame = MAX_uint32;
+	CaptureFrames = 60;
+	bIsCapturing = false;
+
+	// Only one world records or replays, frames are counted from the start of its map
+	if (GetWorld() == NULL || !GetWorld()->IsGameWorld() || ActiveReplay != NULL)
+	{
+		return;
+	}
+
+	FString ReplayPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("NoxReplay="), ReplayPath))
+	{
+		if (!LoadReplay(ReplayPath))
+		{
+			return;
+		}
+
+		FMath::RandInit(Seed);
+		FMath::SRandInit(Seed);
+
+		// Every frame takes the recorded time, frame rate limit is not used
+		FApp::SetUseFixedTimeStep(true);
+
+		FParse::Value(FCommandLine::Get(), TEXT("NoxReplayCaptureFrame="), CaptureFrame);
+		FParse::Value(FCommandLine::Get(), TEXT("NoxReplayCaptureFrames="), CaptureFrames);
+
+		bIsReplaying = true;
+		ActiveReplay = this;
+
+		AdvanceReplayFrame();
+
+		UE_LOG(LogTemp, Log, TEXT("Replaying %s: %d records, seed %d"), *ReplayPath, ReplayRecords.Num(), Seed);
+		LogLongestFrames();
+	}
+	else if (FParse::Param(FCommandLine::Get(), TEXT("NoxRecord")))
+	{
+		FString RecordPath = FPaths::ProfilingDir() / FString::Printf(TEXT("NoxReplay-%s.noxreplay"), *FDateTime::Now().ToString());
+		FParse::Value(FCommandLine::Get(), TEXT("NoxRecordFile="), RecordPath);
+
+		StartRecording(RecordPath);
+	}
+}
+
+void UNoxReplaySubsystem::Deinitialize()
+{
+	if (bIsRecording)
+	{
+		StopRecording();
+	}
+
+	if (bIsReplaying)
+	{
+		StopReplay();
+	}
+
+	Super::Deinitialize();
+}
+
+bool UNoxReplaySubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && (bIsRecording || bIsReplaying);
+}
+
+TStatId UNoxReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxReplaySubsystem, STATGROUP_Nox);
+}
+
+void UNoxReplaySubsystem::Tick(float DeltaTime)
+{
+	if (bIsRecording)
+	{
+		// Real frame time, before time dilation. Replay gives the same time to the same frame.
+		FNoxReplayRecord FrameRecord;
+		FrameRecord.Frame = CurrentFrame;
+		FrameRecord.Type = ENoxReplayEvent::RE_Frame;
+		FrameRecord.Values[0] = (float)FApp::GetDeltaTime();
+		Writer->Enqueue(FrameRecord);
+
+		RecordedFrameSeconds += FApp::GetDeltaTime();
+		CurrentFrame++;
+		return;
+	}
+
+	if (!bPlayerInputDisabled)
+	{
+		// Recorded input is fed instead of the real one
+		if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+		{
+			PlayerController->DisableInput(PlayerController);
+			InputDisabledController = PlayerController;
+			bPlayerInputDisabled = true;
+		}
+	}
+
+	if (!bHasAppliedFirstFrame)
+	{
+		ApplyPlayerInput();
+		bHasAppliedFirstFrame = true;
+	}
+
+	CurrentFrame++;
+
+	if (FrameEnd >= ReplayRecords.Num())
+	{
+		StopReplay();
+		return;
+	}
+
+	AdvanceReplayFrame();
+	ApplyPlayerInput();
+
+	if (!bIsCapturing && CurrentFrame == CaptureFrame)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Replay reached frame %u, capturing %u frames"), CurrentFrame, CaptureFrames);
+		GEngine->Exec(GetWorld(), TEXT("stat startfile"));
+		bIsCapturing = true;
+	}
+	else if (bIsCapturing && CurrentFrame >= CaptureFrame + CaptureFrames)
+	{
+		GEngine->Exec(GetWorld(), TEXT("stat stopfile"));
+		bIsCapturing = false;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Recording
+
+void UNoxReplaySubsystem::StartRecording(const FString& Path)
+{
+	FArchive* File = IFileManager::Get().CreateFileWriter(*Path);
+	if (File == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay can not be recorded to %s"), *Path);
+		return;
+	}
+
+	Seed = (int32)FPlatformTime::Cycles();
+	FParse::Value(FCommandLine::Get(), TEXT("NoxRecordSeed="), Seed);
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	FNoxReplayHeader Header;
+	Header.Seed = Seed;
+	File->Serialize(&Header, sizeof(Header));
+
+	Writer = new FNoxReplayWriter(File);
+
+	// Id 0 is the map, replay checks it is the same
+	Writer->EnqueueName(0, GetWorld()->GetMapName());
+
+	bIsRecording = true;
+	ActiveReplay = this;
+
+	UE_LOG(LogTemp, Log, TEXT("Recording replay to %s, seed %d"), *Path, Seed);
+}
+
+void UNoxReplaySubsystem::StopRecording()
+{
+	const int32 NumDropped = Writer->GetNumDropped();
+
+	// Waits for the writer thread to write the rest
+	delete Writer;
+	Writer = NULL;
+
+	bIsRecording = false;
+	ActiveReplay = NULL;
+
+	const double RecordMs = FPlatformTime::ToMilliseconds64(RecordCycles);
+	const double FrameMs = RecordedFrameSeconds * 1000.0;
+
+	UE_LOG(LogTemp, Log, TEXT("Replay recorded %u frames. Recording took %.2f ms of %.0f ms frame time (%.3f%%), %d records dropped."),
+		CurrentFrame, RecordMs, FrameMs, FrameMs > 0.0 ? 100.0 * RecordMs / FrameMs : 0.0, NumDropped);
+}
+
+uint16 UNoxReplaySubsystem::GetActorId(const AActor* Actor)
+{
+	if (Actor == NULL)
+	{
+		return 0;
+	}
+
+	const FObjectKey ActorKey(Actor);
+	if (const uint16* ActorId = ActorIds.Find(ActorKey))
+	{
+		return *ActorId;
+	}
+
+	// Out of ids, event is recorded without actor
+	if (NextActorId == MAX_uint16)
+	{
+		return 0;
+	}
+
+	const uint16 NewActorId = NextActorId++;
+	ActorIds.Add(ActorKey, NewActorId);
+	Writer->EnqueueName(NewActorId, Actor->GetName());
+
+	return NewActorId;
+}
+
+void UNoxReplaySubsystem::AddEvent(const ENoxReplayEvent Type, const AActor* Actor, const AActor* OtherActor, const FVector& Values)
+{
+	if (bIsReplaying)
+	{
+		VerifyEvent(Type, Actor, OtherActor);
+		return;
+	}
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	// Actions of player controlled pawns are input, replay calls them instead of checking them
+	const APawn* Pawn = Cast<APawn>(Actor);
+	const bool bPlayerInput = Pawn != NULL && Pawn->IsPlayerControlled() && Type != ENoxReplayEvent::RE_Damage && Type != ENoxReplayEvent::RE_AITarget;
+
+	FNoxReplayRecord Record;
+	Record.Frame = CurrentFrame;
+	Record.Type = Type;
+	Record.bPlayerInput = bPlayerInput ? 1 : 0;
+	Record.ActorId = GetActorId(Actor);
+	Record.OtherActorId = GetActorId(OtherActor);
+	Record.Values[0] = Values.X;
+	Record.Values[1] = Values.Y;
+	Record.Values[2] = Values.Z;
+
+	Writer->Enqueue(Record);
+
+	RecordCycles += FPlatformTime::Cycles() - StartCycles;
+}
+
+void UNoxReplaySubsystem::AddBudgetCount(const ENoxReplayBudget Budget, const int32 Count)
+{
+	FNoxReplayRecord Record;
+	Record.Frame = CurrentFrame;
+	Record.Type = ENoxReplayEvent::RE_BudgetCount;
+	Record.Values[0] = (float)Count;
+	Record.Values[1] = (float)Budget;
+
+	Writer->Enqueue(Record);
+}
+
+void UNoxReplaySubsystem::RecordCursorHit(const AActor* Pawn, const FVector& Location)
+{
+	if (ActiveReplay == NULL || !ActiveReplay->bIsRecording || FVector::DistSquared(Location, ActiveReplay->LastRecordedCursor) < 1.f)
+	{
+		return;
+	}
+
+	ActiveReplay->LastRecordedCursor = Location;
+	ActiveReplay->AddEvent(ENoxReplayEvent::RE_CursorHit, Pawn, NULL, Location);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Replay
+
+bool UNoxReplaySubsystem::LoadReplay(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path) || Bytes.Num() < sizeof(FNoxReplayHeader))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay %s can not be loaded"), *Path);
+		return false;
+	}
+
+	FNoxReplayHeader Header;
+	FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+	if (Header.Magic != NoxReplayMagic || Header.Version != NoxReplayVersion || Header.RecordSize != sizeof(FNoxReplayRecord))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay %s has unknown format"), *Path);
+		return false;
+	}
+
+	Seed = Header.Seed;
+
+	int32 Offset = sizeof(Header);
+	while (Offset + (int32)sizeof(FNoxReplayRecord) <= Bytes.Num())
+	{
+		FNoxReplayRecord Record;
+		FMemory::Memcpy(&Record, Bytes.GetData() + Offset, sizeof(Record));
+		Offset += sizeof(Record);
+
+		if (Record.Type != ENoxReplayEvent::RE_ActorName)
+		{
+			ReplayRecords.Add(Record);
+			continue;
+		}
+
+		// Name bytes follow the record
+		if (Offset + Record.OtherActorId > Bytes.Num())
+		{
+			break;
+		}
+
+		const FUTF8ToTCHAR NameTCHAR((const ANSICHAR*)Bytes.GetData() + Offset, Record.OtherActorId);
+		const FName Name(FString(NameTCHAR.Length(), NameTCHAR.Get()));
+		Offset += Record.OtherActorId;
+
+		if (ReplayActorNames.Num() <= Record.ActorId)
+		{
+			ReplayActorNames.SetNum(Record.ActorId + 1);
+		}
+		ReplayActorNames[Record.ActorId] = Name;
+
+		if (Record.ActorId != 0)
+		{
+			ReplayActorIdsByName.Add(Name, Record.ActorId);
+		}
+	}
+
+	ReplayActors.SetNum(ReplayActorNames.Num());
+
+	if (ReplayActorNames.Num() > 0 && ReplayActorNames[0] != FName(*GetWorld()->GetMapName()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay %s was recorded in map %s, it will diverge"), *Path, *ReplayActorNames[0].ToString());
+	}
+
+	return ReplayRecords.Num() > 0;
+}
+
+void UNoxReplaySubsystem::AdvanceReplayFrame()
+{
+	FrameBegin = FrameEnd;
+	while (FrameEnd < ReplayRecords.Num() && ReplayRecords[FrameEnd].Frame == CurrentFrame)
+	{
+		FrameEnd++;
+	}
+
+	// Frame record is the last one of its frame
+	if (FrameEnd > FrameBegin && ReplayRecords[FrameEnd - 1].Type == ENoxReplayEvent::RE_Frame)
+	{
+		FApp::SetFixedDeltaTime(ReplayRecords[FrameEnd - 1].Values[0]);
+	}
+}
+
+void UNoxReplaySubsystem::ApplyPlayerInput()
+{
+	for (int32 Index = FrameBegin; Index < FrameEnd; Index++)
+	{
+		const FNoxReplayRecord& Record = ReplayRecords[Index];
+		if (!Record.bPlayerInput)
+		{
+			continue;
+		}
+
+		if (Record.Type == ENoxReplayEvent::RE_CursorHit)
+		{
+			bHasReplayedCursor = true;
+			ReplayedCursor = FVector(Record.Values[0], Record.Values[1], Record.Values[2]);
+			continue;
+		}
+
+		ANoxCharacter* Character = Cast<ANoxCharacter>(FindReplayActor(Record.ActorId));
+		if (Character == NULL)
+		{
+			continue;
+		}
+
+		switch (Record.Type)
+		{
+		case ENoxReplayEvent::RE_Attack:
+			Character->Attack();
+			break;
+
+		case ENoxReplayEvent::RE_EquipWeapon:
+			Character->EquipWeapon();
+			break;
+
+		case ENoxReplayEvent::RE_MoveForward:
+			if (ANoxPlayerController* PlayerController = Cast<ANoxPlayerController>(Character->GetController()))
+			{
+				PlayerController->MoveForward(Record.Values[0]);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+AActor* UNoxReplaySubsystem::FindReplayActor(const uint16 ActorId)
+{
+	if (ActorId == 0 || !ReplayActors.IsValidIndex(ActorId))
+	{
+		return NULL;
+	}
+
+	if (AActor* Actor = ReplayActors[ActorId].Get())
+	{
+		return Actor;
+	}
+
+	// Actors are spawned in the same order as in the recorded run, so they get the same names
+	AActor* Actor = FindObjectFast<AActor>(GetWorld()->PersistentLevel, ReplayActorNames[ActorId]);
+	ReplayActors[ActorId] = Actor;
+
+	return Actor;
+}
+
+void UNoxReplaySubsystem::VerifyEvent(const ENoxReplayEvent Type, const AActor* Actor, const AActor* OtherActor)
+{
+	const uint16* ActorId = Actor != NULL ? ReplayActorIdsByName.Find(Actor->GetFName()) : NULL;
+	const uint16* OtherActorId = OtherActor != NULL ? ReplayActorIdsByName.Find(OtherActor->GetFName()) : NULL;
+
+	for (int32 Index = FrameBegin; Index < FrameEnd; Index++)
+	{
+		const FNoxReplayRecord& Record = ReplayRecords[Index];
+		if (Record.Type == Type && Record.ActorId == (ActorId != NULL ? *ActorId : 0) && Record.OtherActorId == (OtherActorId != NULL ? *OtherActorId : 0))
+		{
+			return;
+		}
+	}
+
+	// First divergences are enough, everything after them is different anyway
+	NumDivergences++;
+	if (NumDivergences <= 10)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay diverged at frame %u: %s of %s (%s) was not recorded"),
+			CurrentFrame, GetEventName(Type), Actor != NULL ? *Actor->GetName() : TEXT("None"), OtherActor != NULL ? *OtherActor->GetName() : TEXT("None"));
+	}
+}
+
+int32 UNoxReplaySubsystem::GetReplayedBudgetCount(const ENoxReplayBudget Budget)
+{
+	if (ActiveReplay == NULL || !ActiveReplay->bIsReplaying)
+	{
+		return INDEX_NONE;
+	}
+
+	// Systems tick in the same order as in the recorded run, so count has the same frame number
+	for (int32 Index = ActiveReplay->FrameBegin; Index < ActiveReplay->FrameEnd; Index++)
+	{
+		const FNoxReplayRecord& Record = ActiveReplay->ReplayRecords[Index];
+		if (Record.Type == ENoxReplayEvent::RE_BudgetCount && (ENoxReplayBudget)(int32)Record.Values[1] == Budget)
+		{
+			return (int32)Record.Values[0];
+		}
+	}
+
+	// System did no work in this frame of the recording
+	return 0;
+}
+
+bool UNoxReplaySubsystem::GetReplayedCursorHit(FHitResult& OutHit)
+{
+	if (ActiveReplay == NULL || !ActiveReplay->bIsReplaying)
+	{
+		return false;
+	}
+
+	OutHit = FHitResult();
+	OutHit.bBlockingHit = ActiveReplay->bHasReplayedCursor;
+	OutHit.Location = ActiveReplay->ReplayedCursor;
+	OutHit.ImpactPoint = ActiveReplay->ReplayedCursor;
+	OutHit.Normal = FVector::UpVector;
+	OutHit.ImpactNormal = FVector::UpVector;
+
+	return true;
+}
+
+void UNoxReplaySubsystem::LogLongestFrames() const
+{
+	TArray<int32> FrameRecords;
+	for (int32 Index = 0; Index < ReplayRecords.Num(); Index++)
+	{
+		if (ReplayRecords[Index].Type == ENoxReplayEvent::RE_Frame)
+		{
+			FrameRecords.Add(Index);
+		}
+	}
+
+	FrameRecords.Sort([this](const int32 A, const int32 B) { return ReplayRecords[A].Values[0] > ReplayRecords[B].Values[0]; });
+
+	for (int32 Index = 0; Index < FMath::Min(FrameRecords.Num(), 5); Index++)
+	{
+		const FNoxReplayRecord& Record = ReplayRecords[FrameRecords[Index]];
+		UE_LOG(LogTemp, Log, TEXT("  Recorded frame %u took %.1f ms (capture with -NoxReplayCaptureFrame=%u)"), Record.Frame, Record.Values[0] * 1000.f, Record.Frame);
+	}
+}
+
+void UNoxReplaySubsystem::StopReplay()
+{
+	if (bIsCapturing)
+	{
+		GEngine->Exec(GetWorld(), TEXT("stat stopfile"));
+		bIsCapturing = false;
+	}
+
+	FApp::SetUseFixedTimeStep(false);
+
+	// Game keeps running after the replay, player can play on from there
+	if (APlayerController* PlayerController = InputDisabledController.Get())
+	{
+		PlayerController->EnableInput(PlayerController);
+	}
+	InputDisabledController.Reset();
+	bPlayerInputDisabled = false;
+
+	bIsReplaying = false;
+	ActiveReplay = NULL;
+
+	UE_LOG(LogTemp, Log, TEXT("Replay finished at frame %u with %d divergent events"), CurrentFrame, NumDivergences);
+}
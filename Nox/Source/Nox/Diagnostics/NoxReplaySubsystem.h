@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "NoxReplaySubsystem.generated.h"
+
+enum class ENoxReplayEvent : uint8
+{
+	// End of frame, Values[0] is frame delta time
+	RE_Frame,
+	// Name of ActorId follows the record, OtherActorId is its length in bytes. Id 0 is the map.
+	RE_ActorName,
+	RE_Attack,
+	RE_EquipWeapon,
+	// Values[0] is axis value
+	RE_MoveForward,
+	// Values are location under cursor
+	RE_CursorHit,
+	// OtherActorId is the new target of AI
+	RE_AITarget,
+	// OtherActorId is damage causer, Values[0] is damage
+	RE_Damage,
+	// Values[0] is number of items a time budgeted system processed, Values[1] is the system (ENoxReplayBudget)
+	RE_BudgetCount,
+};
+
+// Systems that stop on a time budget. Replay stops them after the recorded number of items instead, so every frame does the same work.
+enum class ENoxReplayBudget : uint8
+{
+	RB_AIScheduler,
+	RB_Sight,
+};
+
+// One event of the replay file. Fixed size, so it fits lock-free ring buffer and is written to disk as it is.
+struct FNoxReplayRecord
+{
+	uint32 Frame = 0;
+	ENoxReplayEvent Type = ENoxReplayEvent::RE_Frame;
+	// Event came from input of a player, replay calls it again instead of checking it
+	uint8 bPlayerInput = 0;
+	uint16 ActorId = 0;
+	uint16 OtherActorId = 0;
+	uint16 Padding = 0;
+	float Values[3] = { 0.f, 0.f, 0.f };
+};
+
+/**
+ * Records inputs, AI decisions and damage of a fight to a compact binary file and plays them back frame for frame.
+ * Recording (-NoxRecord) seeds random numbers, pushes fixed size records to a lock-free ring buffer and a background thread writes them to Saved/Profiling/*.noxreplay.
+ * Replay (-NoxReplay=File) loads the same map with the same seed and recorded frame times, feeds recorded player input and reports first events that diverge.
+ * -NoxReplayCaptureFrame=N starts stat file capture at frame N (-NoxReplayCaptureFrames=60 frames long), so a recorded hitch can be profiled on demand.
+ */
+UCLASS()
+class NOX_API UNoxReplaySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	/** Record event while recording, or check it against the recording while replaying. Does nothing otherwise.
+	*@param OtherActor - Target of AI or damage causer
+	*/
+	static void RecordEvent(const ENoxReplayEvent Type, const AActor* Actor, const AActor* OtherActor = NULL, const FVector& Values = FVector::ZeroVector)
+	{
+		if (ActiveReplay != NULL)
+		{
+			ActiveReplay->AddEvent(Type, Actor, OtherActor, Values);
+		}
+	}
+
+	// Cursor is recorded only when it moves
+	static void RecordCursorHit(const AActor* Pawn, const FVector& Location);
+
+	// Record number of items a time budgeted system processed this frame
+	static void RecordBudgetCount(const ENoxReplayBudget Budget, const int32 Count)
+	{
+		if (ActiveReplay != NULL && ActiveReplay->bIsRecording)
+		{
+			ActiveReplay->AddBudgetCount(Budget, Count);
+		}
+	}
+
+	/** Replay gives budgeted systems the recorded amount of work instead of wall clock time.
+	*@return - Number of items to process this frame, or INDEX_NONE if system should use its time budget
+	*/
+	static int32 GetReplayedBudgetCount(const ENoxReplayBudget Budget);
+
+	/** Replay moves cursor of the local player.
+	*@return - True if OutHit was set from the recording
+	*/
+	static bool GetReplayedCursorHit(FHitResult& OutHit);
+
+private:
+	// Subsystem of the game world that records or replays, NULL most of the time
+	static UNoxReplaySubsystem* ActiveReplay;
+
+	bool bIsRecording;
+	bool bIsReplaying;
+
+	// Frame of the recording, counted from the start of the map
+	uint32 CurrentFrame;
+
+	int32 Seed;
+
+	//////////////////////////////////////////////////////////////////////////
+	// Recording
+
+	class FNoxReplayWriter* Writer;
+
+	TMap<FObjectKey, uint16> ActorIds;
+	uint16 NextActorId;
+
+	FVector LastRecordedCursor;
+
+	// Cost of recording compared to frame time
+	uint64 RecordCycles;
+	double RecordedFrameSeconds;
+
+	void StartRecording(const FString& Path);
+
+	void StopRecording();
+
+	uint16 GetActorId(const AActor* Actor);
+
+	//////////////////////////////////////////////////////////////////////////
+	// Replay
+
+	TArray<FNoxReplayRecord> ReplayRecords;
+
+	// Recorded actor names by id, used to find the same actors in the replayed map
+	TArray<FName> ReplayActorNames;
+	TMap<FName, uint16> ReplayActorIdsByName;
+	TArray<TWeakObjectPtr<AActor>> ReplayActors;
+
+	// Records of CurrentFrame
+	int32 FrameBegin;
+	int32 FrameEnd;
+
+	bool bHasReplayedCursor;
+	FVector ReplayedCursor;
+
+	bool bPlayerInputDisabled;
+
+	// Gets its input back when replay stops
+	TWeakObjectPtr<class APlayerController> InputDisabledController;
+
+	// Input of the first frame is applied by the first tick, player does not exist yet in Initialize()
+	bool bHasAppliedFirstFrame;
+
+	int32 NumDivergences;
+
+	uint32 CaptureFrame;
+	uint32 CaptureFrames;
+	bool bIsCapturing;
+
+	bool LoadReplay(const FString& Path);
+
+	// Find records of the next frame and use its recorded frame time
+	void AdvanceReplayFrame();
+
+	// Call recorded player input of CurrentFrame again
+	void ApplyPlayerInput();
+
+	AActor* FindReplayActor(const uint16 ActorId);
+
+	// Log the longest recorded frames, these are the hitches worth capturing
+	void LogLongestFrames() const;
+
+	void StopReplay();
+
+	void AddEvent(const ENoxReplayEvent Type, const AActor* Actor, const AActor* OtherActor, const FVector& Values);
+
+	void AddBudgetCount(const ENoxReplayBudget Budget, const int32 Count);
+
+	void VerifyEvent(const ENoxReplayEvent Type, const AActor* Actor, const AActor* OtherActor);
+};
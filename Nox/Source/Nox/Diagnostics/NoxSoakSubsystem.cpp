@@ -0,0 +1,303 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxSoakSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/Network/NoxReplicationGraph.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "EngineUtils.h"
+#include "RenderCore.h"
+#include "NavigationSystem.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FSoakCost
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxSoakSubsystem::FSoakCost::Add(const double InMemoryMB, const double InGameThreadMs, const double InReplicationMs, const double InOutKBps, const int32 Change)
+{
+	// Every added or removed player (NPC) counts as one measurement
+	const int32 Weight = FMath::Abs(Change);
+
+	MemoryMB = (MemoryMB * NumChanges + InMemoryMB / Change * Weight) / (NumChanges + Weight);
+	GameThreadMs = (GameThreadMs * NumChanges + InGameThreadMs / Change * Weight) / (NumChanges + Weight);
+	ReplicationMs = (ReplicationMs * NumChanges + InReplicationMs / Change * Weight) / (NumChanges + Weight);
+	OutKBps = (OutKBps * NumChanges + InOutKBps / Change * Weight) / (NumChanges + Weight);
+	NumChanges += Weight;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxSoakSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxSoakSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsRunning = false;
+
+	// Headless runs start reporting without console, e.g. NoxServer Map -log -NoxSoak
+	float CommandLineInterval = 5.f;
+	if (FParse::Param(FCommandLine::Get(), TEXT("NoxSoak")) || FParse::Value(FCommandLine::Get(), TEXT("NoxSoakInterval="), CommandLineInterval))
+	{
+		if (GetWorld() != NULL && GetWorld()->IsGameWorld())
+		{
+			StartSoak(CommandLineInterval);
+		}
+	}
+}
+
+void UNoxSoakSubsystem::Deinitialize()
+{
+	if (bIsRunning)
+	{
+		StopSoak();
+	}
+
+	Super::Deinitialize();
+}
+
+bool UNoxSoakSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && bIsRunning;
+}
+
+TStatId UNoxSoakSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxSoakSubsystem, STATGROUP_Nox);
+}
+
+void UNoxSoakSubsystem::Tick(float DeltaTime)
+{
+	const float FrameMs = DeltaTime * 1000.f;
+
+	// Frame time includes waiting for server tick rate, game thread time is the real work.
+	// GGameThreadTime is only measured with a renderer, dedicated server would always report 0
+	FrameMsSum += FrameMs;
+	GameThreadMsSum += FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0) * 1000.0;
+	ReplicationMsSum += GetReplicationMs();
+	MaxFrameMs = FMath::Max(MaxFrameMs, FrameMs);
+	NumFrames++;
+
+	TimeToNextSample -= DeltaTime;
+	if (TimeToNextSample <= 0.f)
+	{
+		TakeSample();
+		TimeToNextSample = SampleInterval;
+	}
+}
+
+void UNoxSoakSubsystem::StartSoak(const float InSampleInterval)
+{
+	bIsRunning = true;
+	SampleInterval = FMath::Max(InSampleInterval, 0.5f);
+	TimeToNextSample = SampleInterval;
+
+	FrameMsSum = 0.0;
+	GameThreadMsSum = 0.0;
+	ReplicationMsSum = 0.0;
+	MaxFrameMs = 0.f;
+	NumFrames = 0;
+
+	bHasPreviousSample = false;
+	CostPerPlayer = FSoakCost();
+	CostPerNPC = FSoakCost();
+
+	CsvPath = FPaths::ProfilingDir() / FString::Printf(TEXT("NoxSoak-%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(TEXT("Time,Players,Connections,NPCs,AvgFrameMs,MaxFrameMs,AvgGameThreadMs,AvgReplicationMs,UsedPhysicalMB,OutKBps\n"), *CsvPath);
+
+	UE_LOG(LogTemp, Log, TEXT("Soak test started, sampling every %.1f s to %s"), SampleInterval, *CsvPath);
+}
+
+void UNoxSoakSubsystem::StopSoak()
+{
+	bIsRunning = false;
+
+	UE_LOG(LogTemp, Log, TEXT("Soak test stopped. Per player: %.2f MB, %.3f ms game thread, %.3f ms replication, %.2f KB/s sent (%d changes). Per NPC: %.2f MB, %.3f ms game thread, %.3f ms replication, %.2f KB/s sent (%d changes)."),
+		CostPerPlayer.MemoryMB, CostPerPlayer.GameThreadMs, CostPerPlayer.ReplicationMs, CostPerPlayer.OutKBps, CostPerPlayer.NumChanges,
+		CostPerNPC.MemoryMB, CostPerNPC.GameThreadMs, CostPerNPC.ReplicationMs, CostPerNPC.OutKBps, CostPerNPC.NumChanges);
+}
+
+void UNoxSoakSubsystem::TakeSample()
+{
+	FSoakSample Sample;
+	Sample.NumPlayers = GetWorld()->GetNumPlayerControllers();
+	Sample.NumNPCs = CountLiveNPCs();
+	Sample.AverageFrameMs = NumFrames > 0 ? (float)(FrameMsSum / NumFrames) : 0.f;
+	Sample.MaxFrameMs = MaxFrameMs;
+	Sample.AverageGameThreadMs = NumFrames > 0 ? (float)(GameThreadMsSum / NumFrames) : 0.f;
+	Sample.AverageReplicationMs = NumFrames > 0 ? (float)(ReplicationMsSum / NumFrames) : 0.f;
+	Sample.UsedPhysicalMB = FPlatformMemory::GetStats().UsedPhysical / (1024.f * 1024.f);
+
+	// Updated by net driver once per second, sum over all client connections
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	Sample.OutKBps = NetDriver != NULL ? NetDriver->OutBytesPerSecond / 1024.f : 0.f;
+	Sample.NumConnections = NetDriver != NULL ? NetDriver->ClientConnections.Num() : 0;
+
+	FrameMsSum = 0.0;
+	GameThreadMsSum = 0.0;
+	ReplicationMsSum = 0.0;
+	MaxFrameMs = 0.f;
+	NumFrames = 0;
+
+	// Charge the difference only when one count changed, otherwise it can not be split between players and NPCs
+	if (bHasPreviousSample)
+	{
+		const int32 PlayersChange = Sample.NumPlayers - PreviousSample.NumPlayers;
+		const int32 NPCsChange = Sample.NumNPCs - PreviousSample.NumNPCs;
+		const double MemoryChange = Sample.UsedPhysicalMB - PreviousSample.UsedPhysicalMB;
+		const double GameThreadChange = Sample.AverageGameThreadMs - PreviousSample.AverageGameThreadMs;
+		const double ReplicationChange = Sample.AverageReplicationMs - PreviousSample.AverageReplicationMs;
+		const double OutKBpsChange = Sample.OutKBps - PreviousSample.OutKBps;
+
+		if (PlayersChange != 0 && NPCsChange == 0)
+		{
+			CostPerPlayer.Add(MemoryChange, GameThreadChange, ReplicationChange, OutKBpsChange, PlayersChange);
+		}
+		else if (NPCsChange != 0 && PlayersChange == 0)
+		{
+			CostPerNPC.Add(MemoryChange, GameThreadChange, ReplicationChange, OutKBpsChange, NPCsChange);
+		}
+	}
+
+	PreviousSample = Sample;
+	bHasPreviousSample = true;
+
+	UE_LOG(LogTemp, Log, TEXT("Soak: %d players (%d connections), %d NPCs, frame %.2f ms (max %.2f), game thread %.2f ms, replication %.3f ms, memory %.1f MB, sent %.1f KB/s, per player %.2f MB %.3f ms %.2f KB/s, per NPC %.2f MB %.3f ms %.2f KB/s"),
+		Sample.NumPlayers, Sample.NumConnections, Sample.NumNPCs, Sample.AverageFrameMs, Sample.MaxFrameMs, Sample.AverageGameThreadMs, Sample.AverageReplicationMs, Sample.UsedPhysicalMB, Sample.OutKBps,
+		CostPerPlayer.MemoryMB, CostPerPlayer.ReplicationMs, CostPerPlayer.OutKBps, CostPerNPC.MemoryMB, CostPerNPC.ReplicationMs, CostPerNPC.OutKBps);
+
+	const FString Row = FString::Printf(TEXT("%.1f,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.1f,%.2f\n"),
+		GetWorld()->GetTimeSeconds(), Sample.NumPlayers, Sample.NumConnections, Sample.NumNPCs, Sample.AverageFrameMs, Sample.MaxFrameMs, Sample.AverageGameThreadMs, Sample.AverageReplicationMs, Sample.UsedPhysicalMB, Sample.OutKBps);
+	FFileHelper::SaveStringToFile(Row, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+float UNoxSoakSubsystem::GetReplicationMs() const
+{
+	// Only measured when UNoxReplicationGraph is the replication driver
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	const UNoxReplicationGraph* ReplicationGraph = NetDriver != NULL ? Cast<UNoxReplicationGraph>(NetDriver->GetReplicationDriver()) : NULL;
+
+	return ReplicationGraph != NULL ? ReplicationGraph->GetLastReplicateActorsMs() : 0.f;
+}
+
+int32 UNoxSoakSubsystem::CountLiveNPCs() const
+{
+	int32 NumNPCs = 0;
+
+	for (TActorIterator<ANoxCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->IsAlive() && !It->IsPlayerControlled())
+		{
+			NumNPCs++;
+		}
+	}
+
+	return NumNPCs;
+}
+
+void UNoxSoakSubsystem::SpawnNPCs(const int32 Count)
+{
+	// Copy class of the first live NPC, so the map decides what is measured
+	ANoxCharacter* SourceNPC = NULL;
+	for (TActorIterator<ANoxCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->IsAlive() && !It->IsPlayerControlled())
+		{
+			SourceNPC = *It;
+			break;
+		}
+	}
+
+	UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (SourceNPC == NULL || NavigationSystem == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Soak test can not spawn NPCs, map needs at least one NPC and navigation"));
+		return;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+	const float SpawnHeight = SourceNPC->GetActorLocation().Z - SourceNPC->GetNavAgentLocation().Z;
+
+	int32 NumSpawned = 0;
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		FNavLocation SpawnLocation;
+		if (!NavigationSystem->GetRandomReachablePointInRadius(SourceNPC->GetActorLocation(), 3000.f, SpawnLocation))
+		{
+			continue;
+		}
+
+		const FRotator SpawnRotation(0.f, FMath::FRandRange(0.f, 360.f), 0.f);
+		APawn* NPC = GetWorld()->SpawnActor<APawn>(SourceNPC->GetClass(), SpawnLocation.Location + FVector(0.f, 0.f, SpawnHeight), SpawnRotation, SpawnParameters);
+		if (NPC != NULL)
+		{
+			if (NPC->GetController() == NULL)
+			{
+				NPC->SpawnDefaultController();
+			}
+			NumSpawned++;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Soak test spawned %d of %d NPCs of class %s"), NumSpawned, Count, *SourceNPC->GetClass()->GetName());
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console commands
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	// Nox.Soak.Start [SampleInterval] - start logging server cost, e.g. on dedicated server through -ExecCmds
+	void StartSoak(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UNoxSoakSubsystem* SoakSubsystem = World != NULL ? World->GetSubsystem<UNoxSoakSubsystem>() : NULL)
+		{
+			SoakSubsystem->StartSoak(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 5.f);
+		}
+	}
+
+	// Nox.Soak.Stop - log cost per player and per NPC measured so far
+	void StopSoak(const TArray<FString>& Args, UWorld* World)
+	{
+		UNoxSoakSubsystem* SoakSubsystem = World != NULL ? World->GetSubsystem<UNoxSoakSubsystem>() : NULL;
+		if (SoakSubsystem != NULL && SoakSubsystem->IsRunning())
+		{
+			SoakSubsystem->StopSoak();
+		}
+	}
+
+	// Nox.Soak.SpawnNPCs [Count] - add NPCs while number of players stays the same
+	void SpawnSoakNPCs(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UNoxSoakSubsystem* SoakSubsystem = World != NULL ? World->GetSubsystem<UNoxSoakSubsystem>() : NULL)
+		{
+			SoakSubsystem->SpawnNPCs(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50);
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs StartSoakCommand(
+		TEXT("Nox.Soak.Start"),
+		TEXT("Log server frame time and memory per player and per NPC. Usage: Nox.Soak.Start [SampleInterval=5]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartSoak));
+
+	FAutoConsoleCommandWithWorldAndArgs StopSoakCommand(
+		TEXT("Nox.Soak.Stop"),
+		TEXT("Stop soak test and log measured cost per player and per NPC."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StopSoak));
+
+	FAutoConsoleCommandWithWorldAndArgs SpawnNPCsCommand(
+		TEXT("Nox.Soak.SpawnNPCs"),
+		TEXT("Spawn copies of an existing NPC for soak test. Usage: Nox.Soak.SpawnNPCs [Count=50]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SpawnSoakNPCs));
+}
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "NoxSoakSubsystem.generated.h"
+
+/**
+ * Soak test reporter meant for headless dedicated server with loopback clients.
+ * Every interval logs server frame time, replication time, memory and outgoing bandwidth together with number of connected players and live NPCs, and appends it to Saved/Profiling/NoxSoak-*.csv.
+ * Change of memory, game thread time, replication time and bandwidth between two samples is charged to players or NPCs when only one of the counts changed, which gives cost per player and per NPC.
+ * Started by -NoxSoak command line switch or Nox.Soak.Start console command.
+ */
+UCLASS()
+class NOX_API UNoxSoakSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	void StartSoak(const float InSampleInterval);
+
+	// Log summary of the run and stop sampling
+	void StopSoak();
+
+	bool IsRunning() const { return bIsRunning; }
+
+	// Spawn copies of an existing NPC around it, so cost per NPC can be measured with fixed number of players
+	void SpawnNPCs(const int32 Count);
+
+private:
+	struct FSoakSample
+	{
+		int32 NumPlayers = 0;
+		int32 NumConnections = 0;
+		int32 NumNPCs = 0;
+		float AverageFrameMs = 0.f;
+		float MaxFrameMs = 0.f;
+		float AverageGameThreadMs = 0.f;
+		float AverageReplicationMs = 0.f;
+		float UsedPhysicalMB = 0.f;
+		float OutKBps = 0.f;
+	};
+
+	// Running average of cost charged to one player or one NPC
+	struct FSoakCost
+	{
+		double MemoryMB = 0.0;
+		double GameThreadMs = 0.0;
+		double ReplicationMs = 0.0;
+		double OutKBps = 0.0;
+		int32 NumChanges = 0;
+
+		void Add(const double InMemoryMB, const double InGameThreadMs, const double InReplicationMs, const double InOutKBps, const int32 Change);
+	};
+
+	bool bIsRunning;
+
+	float SampleInterval;
+	float TimeToNextSample;
+
+	// Frame times accumulated since last sample
+	double FrameMsSum;
+	double GameThreadMsSum;
+	double ReplicationMsSum;
+	float MaxFrameMs;
+	int32 NumFrames;
+
+	bool bHasPreviousSample;
+	FSoakSample PreviousSample;
+
+	FSoakCost CostPerPlayer;
+	FSoakCost CostPerNPC;
+
+	FString CsvPath;
+
+	void TakeSample();
+
+	// Time spent by replication graph in the last server frame
+	float GetReplicationMs() const;
+
+	int32 CountLiveNPCs() const;
+};
@@ -0,0 +1,275 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxReplicationGraph.h"
+#include "Nox/Nox.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/Weapons/BaseWeapon.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Replicate Actors"), STAT_NoxReplicateActors, STATGROUP_Nox);
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxReplicationGraph
+//////////////////////////////////////////////////////////////////////////
+
+UNoxReplicationGraph::UNoxReplicationGraph()
+{
+	GridCellSize = 10000.f;
+	SpatialBias = FVector2D(-150000.f, -200000.f);
+
+	GridNode = NULL;
+	AlwaysRelevantNode = NULL;
+	LastReplicateActorsMs = 0.f;
+}
+
+void UNoxReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Classes that are not routed by their defaults. Subclasses (e.g. blueprints) use policy of the closest parent.
+	ClassRepNodePolicies.Set(AReplicationGraphDebugActor::StaticClass(), ENoxClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), ENoxClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), ENoxClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(ABaseWeapon::StaticClass(), ENoxClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(AGameStateBase::StaticClass(), ENoxClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(APlayerState::StaticClass(), ENoxClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(ANoxCharacter::StaticClass(), ENoxClassRepNodeMapping::Spatialize_Dormancy);
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (ActorCDO == NULL || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Leftovers of blueprint compilation
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		ENoxClassRepNodeMapping Policy;
+		if (const ENoxClassRepNodeMapping* ExplicitPolicy = ClassRepNodePolicies.Get(Class))
+		{
+			Policy = *ExplicitPolicy;
+		}
+		else
+		{
+			Policy = GetPolicyFromDefaults(ActorCDO);
+			ClassRepNodePolicies.Set(Class, Policy);
+		}
+
+		// Replication graph replaces per actor NetUpdateFrequency with number of server frames between updates
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(NetDriver->NetServerMaxTickRate / FMath::Max(ActorCDO->NetUpdateFrequency, 1.f)), 1);
+
+		// Actors using owner relevancy go to the grid when they have no owner, see AddOwnerDependency()
+		if (Policy == ENoxClassRepNodeMapping::Spatialize_Static || Policy == ENoxClassRepNodeMapping::Spatialize_Dynamic || Policy == ENoxClassRepNodeMapping::Spatialize_Dormancy || ActorCDO->bNetUseOwnerRelevancy)
+		{
+			ClassInfo.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+		}
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UNoxReplicationGraph::InitGlobalGraphNodes()
+{
+	// Lists used by grid cells and gathered actors. Cells with many NPCs need the large ones.
+	PreAllocateRepList(3, 12);
+	PreAllocateRepList(6, 12);
+	PreAllocateRepList(128, 64);
+	PreAllocateRepList(512, 16);
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+
+	// Grid is not rebuilt when actor leaves its bounds, rebuild with hundreds of NPCs would hitch the server
+	GridNode->AddSpatialRebuildBlacklistClass(AActor::StaticClass());
+
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UNoxReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UNoxReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UNoxReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+ENoxClassRepNodeMapping UNoxReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	// Classes loaded after InitGlobalActorClassSettings() use policy of the closest parent
+	if (const ENoxClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	// No parent has a policy either, use the same rule as classes known at init so the actor is not silently dropped
+	const ENoxClassRepNodeMapping Policy = GetPolicyFromDefaults(GetDefault<AActor>(Class));
+	ClassRepNodePolicies.Set(Class, Policy);
+
+	return Policy;
+}
+
+ENoxClassRepNodeMapping UNoxReplicationGraph::GetPolicyFromDefaults(const AActor* ActorCDO)
+{
+	if (ActorCDO->bAlwaysRelevant && !ActorCDO->bOnlyRelevantToOwner)
+	{
+		return ENoxClassRepNodeMapping::RelevantAllConnections;
+	}
+	else if (ActorCDO->bOnlyRelevantToOwner || ActorCDO->bNetUseOwnerRelevancy)
+	{
+		return ENoxClassRepNodeMapping::NotRouted;
+	}
+
+	return ActorCDO->IsReplicatingMovement() ? ENoxClassRepNodeMapping::Spatialize_Dynamic : ENoxClassRepNodeMapping::Spatialize_Static;
+}
+
+void UNoxReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const ENoxClassRepNodeMapping Policy = GetMappingPolicy(ActorInfo.Class);
+	switch (Policy)
+	{
+	case ENoxClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case ENoxClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case ENoxClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case ENoxClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+
+	if (ActorInfo.Actor->bNetUseOwnerRelevancy)
+	{
+		AddOwnerDependency(ActorInfo, GlobalInfo, Policy);
+	}
+}
+
+void UNoxReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case ENoxClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case ENoxClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case ENoxClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case ENoxClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+
+	if (ActorInfo.Actor->bNetUseOwnerRelevancy)
+	{
+		RemoveOwnerDependency(ActorInfo);
+	}
+}
+
+void UNoxReplicationGraph::AddOwnerDependency(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, const ENoxClassRepNodeMapping Policy)
+{
+	// Pooled weapons are spawned with their character as owner, so owner is known when weapon is added
+	AActor* Owner = ActorInfo.Actor->GetOwner();
+	if (Owner == NULL)
+	{
+		// Nothing to replicate with, actor is replicated by its own position. Routed classes are already in a node.
+		if (Policy == ENoxClassRepNodeMapping::NotRouted)
+		{
+			GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			OwnerlessActors.Add(ActorInfo.Actor);
+		}
+		return;
+	}
+
+	FGlobalActorReplicationInfo& OwnerInfo = GlobalActorReplicationInfoMap.Get(Owner);
+	OwnerInfo.DependentActorList.PrepareForWrite();
+	if (!OwnerInfo.DependentActorList.Contains(ActorInfo.Actor))
+	{
+		OwnerInfo.DependentActorList.Add(ActorInfo.Actor);
+	}
+}
+
+void UNoxReplicationGraph::RemoveOwnerDependency(const FNewReplicatedActorInfo& ActorInfo)
+{
+	// Owner could have been set after the actor was added, it is still in the grid
+	if (OwnerlessActors.Remove(ActorInfo.Actor) > 0)
+	{
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		return;
+	}
+
+	// Owner can be removed first, its info goes away together with dependent list
+	AActor* Owner = ActorInfo.Actor->GetOwner();
+	FGlobalActorReplicationInfo* OwnerInfo = Owner != NULL ? GlobalActorReplicationInfoMap.Find(Owner) : NULL;
+	if (OwnerInfo != NULL)
+	{
+		OwnerInfo->DependentActorList.PrepareForWrite();
+		OwnerInfo->DependentActorList.Remove(ActorInfo.Actor);
+	}
+}
+
+int32 UNoxReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxReplicateActors);
+	NOX_HITCH_SCOPE(HS_Replication);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+
+	LastReplicateActorsMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	return NumReplicated;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxReplicationGraphNode_AlwaysRelevant_ForConnection
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// Rebuilt every frame, player can possess another pawn or change view target at any time
+	ReplicationActorList.Reset();
+
+	UNetConnection* NetConnection = Params.ConnectionManager.NetConnection;
+	ReplicationActorList.ConditionalAdd(NetConnection->PlayerController);
+	ReplicationActorList.ConditionalAdd(NetConnection->ViewTarget);
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "NoxReplicationGraph.generated.h"
+
+// How actors of a class are routed to graph nodes
+enum class ENoxClassRepNodeMapping : uint8
+{
+	// Not added to any node, replicated by per connection node (player controllers) or together with owner (weapons and other owner relevant actors)
+	NotRouted,
+	// Replicated to every connection
+	RelevantAllConnections,
+	// Grid, actor does not move
+	Spatialize_Static,
+	// Grid, actor position is updated every frame
+	Spatialize_Dynamic,
+	// Grid, dynamic while awake and static while dormant (dead NPCs)
+	Spatialize_Dormancy,
+};
+
+/**
+ * Replication driver used instead of per connection relevancy checks of every actor.
+ * NPCs are stored in spatial grid, so each connection only gathers actors from cells around its viewer. Dead NPCs go dormant and are no longer updated.
+ * Set as ReplicationDriverClassName of IpNetDriver in DefaultEngine.ini.
+ */
+UCLASS(transient, config = Engine)
+class NOX_API UNoxReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UNoxReplicationGraph();
+
+	// UReplicationGraph interface
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+	// End UReplicationGraph interface
+
+	// Size of one grid cell. Should be close to net cull distance of NPCs.
+	UPROPERTY(config)
+		float GridCellSize;
+
+	// Lowest corner of the grid. Actors below it are clamped to the first cells.
+	UPROPERTY(config)
+		FVector2D SpatialBias;
+
+	// Time of the last ServerReplicateActors() call, read by soak test
+	float GetLastReplicateActorsMs() const { return LastReplicateActorsMs; }
+
+private:
+	UPROPERTY()
+		class UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+		class UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	TClassMap<ENoxClassRepNodeMapping> ClassRepNodePolicies;
+
+	// Actors using owner relevancy that had no owner when added, they are in the grid instead
+	TSet<AActor*> OwnerlessActors;
+
+	float LastReplicateActorsMs;
+
+	ENoxClassRepNodeMapping GetMappingPolicy(UClass* Class);
+
+	// Policy of a class without explicit one, taken from its defaults
+	static ENoxClassRepNodeMapping GetPolicyFromDefaults(const AActor* ActorCDO);
+
+	// Actor using owner relevancy (e.g. weapon) replicates right after its owner, so it is relevant exactly when owner is
+	void AddOwnerDependency(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, const ENoxClassRepNodeMapping Policy);
+
+	void RemoveOwnerDependency(const FNewReplicatedActorInfo& ActorInfo);
+};
+
+/** Actors that only one connection needs: its player controller and view target (player pawn). */
+UCLASS()
+class NOX_API UNoxReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
@@ -2,7 +2,18 @@
 
 #include "Nox.h"
 #include "Modules/ModuleManager.h"
+#include "Combat/NoxTeamAttitude.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Nox, "Nox" );
+class FNoxGameModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Team attitudes are needed before any controller asks for them
+		FNoxTeamAttitude::Initialize();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FNoxGameModule, Nox, "Nox" );
 
 DEFINE_LOG_CATEGORY(LogNox) 
@@ -5,3 +5,8 @@
 #include "CoreMinimal.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogNox, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Nox"), STATGROUP_Nox, STATCAT_Advanced);
+
+// Debug drawing is never compiled into dedicated server builds
+#define NOX_DRAW_DEBUG (ENABLE_DRAW_DEBUG && !UE_SERVER)
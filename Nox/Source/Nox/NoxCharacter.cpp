@@ -2,12 +2,9 @@
 
 #include "NoxCharacter.h"
 #include "UObject/ConstructorHelpers.h"
-#include "Camera/CameraComponent.h"
-#include "Components/DecalComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
-#include "GameFramework/SpringArmComponent.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Materials/Material.h"
 #include "Engine/World.h"
@@ -15,15 +12,26 @@
 #include "Components/WidgetComponent.h"
 #include "TimerManager.h"
 #include "Nox/Anim/NoxAnimInstance.h"
+#include "Nox/Combat/NoxTeamAttitude.h"
+#include "Nox/AI/NoxSightSubsystem.h"
 #include "Perception/AIPerceptionStimuliSourceComponent.h"
 #include "Perception/AISense_Sight.h"
+#include "Nox/Player/NoxPlayerViewComponent.h"
 #include "GameplayTagsManager.h"
+#include "Nox/Combat/NoxAttackCatalog.h"
+#include "Nox/Diagnostics/NoxReplaySubsystem.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/Nox.h"
+#include "Engine/AssetManager.h"
+#include "Engine/DamageEvents.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "Animation/AnimMontage.h"
 
 #include "Engine/Engine.h"
 
-#define ECC_CursorMovement ECC_GameTraceChannel1 
-#define ECC_CameraView ECC_GameTraceChannel2
-#define ECC_Ground ECC_GameTraceChannel3
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Prediction Round Trip Ms"), STAT_NoxPredictionRoundTripMs, STATGROUP_Nox);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Rejected Predictions"), STAT_NoxRejectedPredictions, STATGROUP_Nox);
 
 ANoxCharacter::ANoxCharacter()
 {
@@ -41,37 +49,23 @@ ANoxCharacter::ANoxCharacter()
 	GetCharacterMovement()->RotationRate = FRotator(0.f, 470.f, 0.f);
 	GetCharacterMovement()->bConstrainToPlane = true;
 	GetCharacterMovement()->bSnapToPlaneAtStart = true;
+	// Far away NPCs use nav walking (see FNoxSignificance::UpdateMovementMode), it should not sweep either
+	GetCharacterMovement()->bSweepWhileNavWalking = false;
+
+	// Needed to change animation update rate by significance tier
+	GetMesh()->bEnableUpdateRateOptimizations = true;
 	
 
-	// Create a camera boom...
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->SetUsingAbsoluteRotation(true); // Don't want arm to rotate when character does
-	CameraBoom->TargetArmLength = 800.f;
-	CameraBoom->SetRelativeRotation(FRotator(-60.f, 0.f, 0.f));
-	CameraBoom->bDoCollisionTest = false; // Don't want to pull camera in when it collides with level
-
-	// Create a camera...
-	TopDownCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("TopDownCamera"));
-	TopDownCameraComponent->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
-	TopDownCameraComponent->bUsePawnControlRotation = false; // Camera does not rotate relative to arm	
-
-	// Create a decal in the world to show the cursor's location
-	CursorToWorld = CreateDefaultSubobject<UDecalComponent>("CursorToWorld");
-	CursorToWorld->SetupAttachment(RootComponent);
-	CursorToWorld->DecalSize = FVector(16.0f, 32.0f, 32.0f);
-	CursorToWorld->SetRelativeRotation(FRotator(90.0f, 0.0f, 0.0f).Quaternion());
-
-	// Create widget above character
+	// Create widget above character. Dedicated server never draws it, it is destroyed in BeginPlay.
 	InformationBar = CreateDefaultSubobject<UWidgetComponent>("Information Bar");
 	InformationBar->SetupAttachment(RootComponent);
 	InformationBar->SetRelativeLocation(FVector(0.0f, 0.0f, 160.0f));
 	InformationBar->SetDrawSize(FVector2D(120.0f, 500.0f));
 	InformationBar->SetWidgetSpace(EWidgetSpace::Screen);
 	InformationBar->SetWindowVisibility(EWindowVisibility::Visible);
-	
-	// Create AI stimuli source
-	AIPerceptionStimuliSource = CreateDefaultSubobject<UAIPerceptionStimuliSourceComponent>("AIPerceptionStimuliSource");	
+
+	// Create AI stimuli source. Only perception sight of old controller blueprints uses it, UNoxSightSubsystem does not.
+	AIPerceptionStimuliSource = CreateDefaultSubobject<UAIPerceptionStimuliSourceComponent>("AIPerceptionStimuliSource");
 	AISight = CreateDefaultSubobject<UAISense_Sight>("AISight");
 	AIPerceptionStimuliSource->RegisterForSense(AISight->GetClass());
 	AIPerceptionStimuliSource->bAutoRegister = true;
@@ -90,61 +84,149 @@ ANoxCharacter::ANoxCharacter()
 	bIsWeaponEquiped = false;	
 	bCanAttack = true;
 
-	// Activate ticking in order to update the cursor every frame.
+	EquippedWeapon = NULL;
+	WeaponToEquip = NULL;
+	ReplicatedHealth = MAX_uint16;
+	ReplicatedMana = MAX_uint16;
+
+	// Combat state changes call ForceNetUpdate(), regular updates only have to keep up with movement
+	NetUpdateFrequency = 30.f;
+	MinNetUpdateFrequency = 5.f;
+
+	SignificanceTier = ENoxSignificanceTier::ST_High;
+
+	NativePatrolPath = NULL;
+
+	MeshSmoothingOffsetZ = 0.f;
+	MeshSmoothingSpeed = 8.f;
+
+	CurrentAttackIndex = INDEX_NONE;
+	NextPredictionKey = 0;
+	LastPredictedAttackKey = 0;
+	PredictedEquipKey = 0;
+	PredictionEndTolerance = 0.1f;
+	DeadDormancyDelay = 1.f;
+	CurrentHandCollisionSockets = &GetSocketsByECollisionPart(ECollisionPart::CP_None);
+
+	// Ticking is turned on only when there is work to do, see UpdateTickEnabled()
 	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;				
+	PrimaryActorTick.bStartWithTickEnabled = false;				
+}
+
+void ANoxCharacter::PostLoad()
+{
+	Super::PostLoad();
+
+	// Blueprints of the class defaults are loaded first, spawned characters copy catalog from them
+	if (AttackCatalog == NULL && (UnarmedAttacks_DEPRECATED.Num() > 0 || WeaponAttacks_DEPRECATED.Num() > 0))
+	{
+		AttackCatalog = UNoxAttackCatalog::CreateFromLegacyAttacks(this, UnarmedAttacks_DEPRECATED, WeaponAttacks_DEPRECATED);
+
+		UE_LOG(LogTemp, Warning, TEXT("%s has attacks saved on the character, they were moved to %s. Assign a shared attack catalog asset to it."), *GetPathName(), *AttackCatalog->GetName());
+	}
+
+	UnarmedAttacks_DEPRECATED.Empty();
+	WeaponAttacks_DEPRECATED.Empty();
 }
 
 void ANoxCharacter::BeginPlay()
 {
+	// Component stays in the class so blueprints and assets are the same for every target, server only drops it at runtime
+	if (GetNetMode() == NM_DedicatedServer && InformationBar != NULL)
+	{
+		InformationBar->DestroyComponent();
+		InformationBar = NULL;
+	}
+
 	// Call the base class  
 	Super::BeginPlay();
 
 	// Default values that have to be calculated by BP children of which counctructor does not know anything. Thats why those variables have to be here.
-	Health = MaxHealth;
-	Mana = MaxMana;	
-	// Set health percentage
-	HealthPercentage = CalculatePercentage(Health, MaxHealth);
-	ManaPercentage = CalculatePercentage(Mana, MaxMana);
+	// Client can get damaged character in the first replication, before BeginPlay
+	if (HasAuthority())
+	{
+		Health = MaxHealth;
+		Mana = MaxMana;	
+		// Set health percentage
+		HealthPercentage = CalculatePercentage(Health, MaxHealth);
+		ManaPercentage = CalculatePercentage(Mana, MaxMana);
+	}
+	else
+	{
+		OnRep_ReplicatedHealth();
+		OnRep_ReplicatedMana();
+	}
 
-	// Bind function to Hitbox notify delegates
+	// Listen to Hitbox notifies. Character does not need per frame notify tick.
 	UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(GetMesh()->GetAnimInstance());
 	if (NoxAnimInstance != NULL)
 	{
-		FScriptDelegate OnNotifyBegin;
-		OnNotifyBegin.BindUFunction(this, FName("OnDealDamageBegin"));
-		NoxAnimInstance->OnHitBoxNotifyBegin.AddUnique(OnNotifyBegin);
-
-		FScriptDelegate OnNotifyEnd;
-		OnNotifyEnd.BindUFunction(this, FName("OnDealDamageEnd"));
-		NoxAnimInstance->OnHitBoxNotifyEnd.AddUnique(OnNotifyEnd);		
+		NoxAnimInstance->AddHitBoxListener(this);
 	}
 	else
 	{
 		UE_LOG(LogTemp, Warning, TEXT("(Binding Delegate for HitBoxNotify Failed! Cast To UNoxAnimInstance is NULL!"));
 	}
-	
+
+	// Every character can be seen by AI
+	if (UNoxSightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UNoxSightSubsystem>())
+	{
+		SightSubsystem->RegisterSource(this);
+	}
+
+	// Player characters are removed from significance when possessed, see PossessedBy()
+	if (!IsPlayerControlled())
+	{
+		FNoxSignificance::RegisterCharacter(this);
+	}
+
+	// Stream in montages and weapon before they are needed. Weapon is put into the pool when its class is loaded.
+	RequestCombatAssets();
+
+	UpdateServerAnimTickOption();
 }
 
-void ANoxCharacter::Tick(float DeltaSeconds)
+void ANoxCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaSeconds);		
-	
-	if (GetController()->IsPlayerController())
+	FNoxSignificance::UnregisterCharacter(this);
+
+	if (UNoxSightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UNoxSightSubsystem>())
 	{
-		TArray<FHitResult> CameraViewHits;
-		GetCameraViewPointCollisions(OUT CameraViewHits);
-		ChangeMaterialOfCollidingObjects(CameraViewHits, TranslucentMaterial, true);
+		SightSubsystem->UnregisterSource(this);
+	}
+
+	if (UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(GetMesh()->GetAnimInstance()))
+	{
+		NoxAnimInstance->RemoveHitBoxListener(this);
+	}
 
-		FHitResult HitUnderCharacter;
-		GetCollisionUnderCharacter(OUT HitUnderCharacter);
-		ChangeChannelCollisionResponseWhileColliding(HitUnderCharacter, ECollisionChannel::ECC_CursorMovement, ECollisionResponse::ECR_Block);
+	// Pooled weapons are owned by this character and go away with it
+	for (const auto& PooledWeapon : WeaponPool)
+	{
+		if (PooledWeapon.Value != NULL)
+		{
+			PooledWeapon.Value->Destroy();
+		}
 	}
+	WeaponPool.Empty();
+	EquippedWeapon = NULL;
+
+	Super::EndPlay(EndPlayReason);
+}
 
+void ANoxCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);		
+	
 	if (bIsAttackingWithHands)
 	{
 		UnarmedAttack();
 	}	
+
+	if (MeshSmoothingOffsetZ != 0.f)
+	{
+		UpdateMeshSmoothing(DeltaSeconds);
+	}
 }
 
 void ANoxCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -159,123 +241,96 @@ void ANoxCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompon
 
 }
 
-void ANoxCharacter::GetCameraViewPointCollisions(TArray<FHitResult>& OutHits)
-{	
-	// Find Character's CameraComponent StartLocation
-	const FVector StartLocation = TopDownCameraComponent->GetComponentLocation();
-	// Find Character's CameraComponent EndLocation where lenght of ray corresponds to CameraBoom arm length
-	const FVector EndLocation = (StartLocation + (TopDownCameraComponent->GetForwardVector() * CameraBoom->TargetArmLength));
-	
-	FCollisionQueryParams QueryParams;	
+void ANoxCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
 
-	// Ignore all objects with non static/stationary mobility type (ignore movable mobility type) 
-	QueryParams.MobilityType = EQueryMobilityType::Static;
+	// Character controlled by player is always fully detailed
+	if (IsPlayerControlled())
+	{
+		FNoxSignificance::UnregisterCharacter(this);
+		FNoxSignificance::ApplyTier(this, ENoxSignificanceTier::ST_High);
+	}
 
-	// Collisions for subcalsses of APawn are ignored by default in DefaultEngine.ini for ECC_CameraView channel. Default ECC_CameraView response is overlap  
-	GetWorld()->LineTraceMultiByChannel(OutHits, StartLocation, EndLocation, ECollisionChannel::ECC_CameraView, QueryParams);
+	UpdateTickEnabled();
 }
 
-void ANoxCharacter::ChangeMaterialOfCollidingObjects(const TArray<FHitResult>& CollidingObjects, UMaterialInterface* NewMaterial, bool bRestoreOriginalMaterial)
+void ANoxCharacter::UnPossessed()
 {
-/// Set new material, add elements to array
+	Super::UnPossessed();
 
-	// For loop works only, if there are collisions.   
-	for (int i = 0; i < CollidingObjects.Num(); i++)
-	{			
-		if (NewMaterial != NULL)
-		{
-			// Change material only once
-			if (CollidingObjects[i].GetComponent()->GetMaterial(0)->GetName() != NewMaterial->GetName())
-			{
-				// Add elements to array only if Origin material should be restored.
-				if (bRestoreOriginalMaterial)
-				{
-					// Object with changed material and pointer to its original material 
-					FObjectAndOriginalMaterial TempObjectAndMaterial{ CollidingObjects[i], CollidingObjects[i].GetComponent()->GetMaterial(0) };
-					// Add element to array
-					ObjectsWithChangedMaterial.Push(TempObjectAndMaterial);
-				}
-				// Set new translucent material
-				CollidingObjects[i].GetComponent()->SetMaterial(0, NewMaterial);				
-			}
-		}
-		else
-		{
-			// Error code
-			UE_LOG(LogTemp, Warning, TEXT("(Function: ChangeMaterialWhileColliding) - Pointer to NewMaterial is not found!"));
-			return;
-		}			
-	}	
+	UpdateTickEnabled();
+}
+
+void ANoxCharacter::OnRep_Controller()
+{
+	Super::OnRep_Controller();
+
+	UpdateTickEnabled();
+}
+
+void ANoxCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ANoxCharacter, ReplicatedHealth);
+	DOREPLIFETIME(ANoxCharacter, ReplicatedMana);
+	DOREPLIFETIME(ANoxCharacter, bIsAlive);
+	DOREPLIFETIME(ANoxCharacter, EquippedWeapon);
+	DOREPLIFETIME(ANoxCharacter, ReplicatedAttack);
+	DOREPLIFETIME_CONDITION(ANoxCharacter, WeaponToEquip, COND_OwnerOnly);
+}
+
+void ANoxCharacter::UpdateTickEnabled()
+{
+	SetActorTickEnabled(bIsAttackingWithHands || MeshSmoothingOffsetZ != 0.f);
+}
 
-/// Restore original material, remove elements from array
+void ANoxCharacter::SetNavWalkingEnabled(const bool bEnabled)
+{
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	if (!bIsAlive || !Movement->IsActive())
+	{
+		return;
+	}
 
-	// Check if any object stopped colliding. If bRestoreOriginalMaterial is false, this condition is also false (ObjectsWithChangedMaterial always 0).
-	if (CollidingObjects.Num() < ObjectsWithChangedMaterial.Num())
+	if (bEnabled)
 	{
-		if (CollidingObjects.Num() == NULL)
+		// Falling or flying characters switch later, when significance or combat state changes again
+		if (Movement->MovementMode == MOVE_Walking)
 		{
-			for (int k = 0; k < ObjectsWithChangedMaterial.Num(); k++)
-			{
-				ObjectsWithChangedMaterial[k].Object.GetComponent()->SetMaterial(0, ObjectsWithChangedMaterial[k].OriginalMaterial);
-			}
-			ObjectsWithChangedMaterial.Empty();
+			Movement->SetMovementMode(MOVE_NavWalking);
 		}
-		else
+	}
+	else if (Movement->MovementMode == MOVE_NavWalking)
+	{
+		// Capsule is moved out of geometry onto the real floor. If there is no free spot yet, movement keeps trying by itself.
+		const float NavWalkingZ = GetActorLocation().Z;
+		if (Movement->TryToLeaveNavWalking())
 		{
-			for (int i = 0; i < ObjectsWithChangedMaterial.Num(); i++)
-			{
-				for (int j = 0; j < CollidingObjects.Num(); j++)
-				{
-					//Check if camera view is still blocked and object should stay translucent
-					if (ObjectsWithChangedMaterial[i].Object.GetActor()->GetName() == CollidingObjects[j].GetActor()->GetName())
-					{
-						// Terminate the loop [j] 
-						break;
-					}
-					// If camera view is not blocked and all posibilities were checked, change object material from translucent back to original
-					else if (j == CollidingObjects.Num() - 1)
-					{
-						ObjectsWithChangedMaterial[i].Object.GetComponent()->SetMaterial(0, ObjectsWithChangedMaterial[i].OriginalMaterial);				
-
-						// remove element from array 
-						ObjectsWithChangedMaterial.RemoveAt(i);							
-					}
-				}
-			}
+			// Navmesh is not exactly at floor height, mesh slides to the new capsule location instead of popping
+			MeshSmoothingOffsetZ += NavWalkingZ - GetActorLocation().Z;
+			UpdateMeshSmoothing(0.f);
+			UpdateTickEnabled();
 		}
 	}
 }
 
-void ANoxCharacter::GetCollisionUnderCharacter(FHitResult& OutHit)
+bool ANoxCharacter::IsNavWalking() const
 {
-	// Find Character Location
-	const FVector StartLocation = GetActorLocation();
-	// Find LineTrace EndLocation, object under character
-	const FVector EndLocation = (StartLocation + ((GetActorForwardVector() + FVector(0.f, 0.f, -90.f)) * 1.25f));
-
-	// Collisions for subcalsses of APawn are ignored by default in DefaultEngine.ini for ECC_Ground channel. Default ECC_Ground response is block  
-	GetWorld()->LineTraceSingleByChannel(OutHit, StartLocation, EndLocation, ECollisionChannel::ECC_Ground);	
+	return GetCharacterMovement()->MovementMode == MOVE_NavWalking;
 }
 
-void ANoxCharacter::ChangeChannelCollisionResponseWhileColliding(const FHitResult& InHit, const ECollisionChannel&& InChannel, const ECollisionResponse&& NewResponseDuringCollision)
-{	
-	if (LastHit.GetActor() != NULL)
+void ANoxCharacter::UpdateMeshSmoothing(const float DeltaSeconds)
+{
+	MeshSmoothingOffsetZ = FMath::FInterpTo(MeshSmoothingOffsetZ, 0.f, DeltaSeconds, MeshSmoothingSpeed);
+	if (FMath::Abs(MeshSmoothingOffsetZ) < 0.1f)
 	{
-		if (InHit.GetActor() != LastHit.GetActor())
-		{				
-				LastHit.GetComponent()->SetCollisionResponseToChannel(InChannel, LastHitOriginalCollisionResponse);
-		}
-	}		
+		MeshSmoothingOffsetZ = 0.f;
+		UpdateTickEnabled();
+	}
 
-	if (InHit.bBlockingHit)
-	{
-		if (InHit.GetComponent()->GetCollisionResponseToChannel(InChannel) != NewResponseDuringCollision)
-		{
-			LastHit = InHit;			
-			LastHitOriginalCollisionResponse = InHit.GetComponent()->GetCollisionResponseToChannel(InChannel);
-			InHit.GetComponent()->SetCollisionResponseToChannel(InChannel, NewResponseDuringCollision);			
-		}
-	}		
+	GetMesh()->SetRelativeLocation(GetBaseTranslationOffset() + FVector(0.f, 0.f, MeshSmoothingOffsetZ));
 }
 
 float ANoxCharacter::CalculatePercentage(const float CurrentValue, const float MaxValue)
@@ -293,6 +348,12 @@ void ANoxCharacter::Ragdoll()
 
 float ANoxCharacter::TakeDamage(float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	// Health is owned by server, clients get it replicated
+	if (!HasAuthority())
+	{
+		return 0.f;
+	}
+
 	// Call the base class - this will tell us how much damage to apply  
 	const float ActualDamage = Super::TakeDamage(Damage, DamageEvent, EventInstigator, DamageCauser);
 	
@@ -301,60 +362,28 @@ float ANoxCharacter::TakeDamage(float Damage, FDamageEvent const& DamageEvent, A
 		if (ActualDamage > 0.f && Health > 0.f)
 		{
 			// Specify variable for health and apply damage.
-			Health -= ActualDamage;
+			SetHealth(Health - ActualDamage);
 
-			// Update health procentage for correct operation of widgets.
-			HealthPercentage = CalculatePercentage(Health, MaxHealth);			
+			FVector HitLocation = GetActorLocation();
+			if (DamageEvent.IsOfType(FPointDamageEvent::ClassID))
+			{
+				HitLocation = static_cast<const FPointDamageEvent&>(DamageEvent).HitInfo.ImpactPoint;
+			}
+			QueueCombatEvent(ENoxCombatEventType::CE_Hit, DamageCauser, HitLocation, ActualDamage);
+			UNoxReplaySubsystem::RecordEvent(ENoxReplayEvent::RE_Damage, this, DamageCauser, FVector(ActualDamage, 0.f, 0.f));
 
 			// If the damage depletes our health set our lifespan to zero - which will destroy the actor  
 			if (Health <= 0.f)
 			{
 				bIsAlive = false;
 
-				// Change team to neutral when dead to stop attacking 
-				auto igtaiController = Cast<IGenericTeamAgentInterface>(GetController()); // ActorBot
-				igtaiController->SetGenericTeamId(255);
-
-				// Turn off attack ability for dead character
-				bCanAttack = false;
-
-				GetInformationBar()->bHiddenInGame = true;				
-								
-				GetCursorToWorld()->DetachFromComponent(FDetachmentTransformRules::KeepRelativeTransform);
-				GetCursorToWorld()->SetLifeSpan(0.1f);
-
-				GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-				GetMovementComponent()->Deactivate();	
-				
-				GetAIPerceptionStimuliSource()->ToggleActive();
-
-				
-
-				// Check if array is not empty
-				if (DeathAnimMontages.Num() != NULL)
-				{
-					// Check if specified slot for montage is not null
-					if (DeathAnimMontages[DeathMontageToUse] != NULL)
-					{
-						float MontageLength = DeathAnimMontages[DeathMontageToUse]->GetPlayLength();											
-
-						// Call ragdoll at the end of animation						
-						PlayMontageWithSpecificEffect(this, DeathAnimMontages[DeathMontageToUse], MontageLength, TEXT("Ragdoll"));
-						
-					}
-					else // If montages are empty call Ragdoll
-					{
-						Ragdoll();						
-					}
-				}
-				else  // If there are no montages call Ragdoll
-				{
-					Ragdoll();
-				}
+				HandleDeath();
+
+				QueueCombatEvent(ENoxCombatEventType::CE_Death, DamageCauser, GetActorLocation());
 			}
+
+			ForceNetUpdate();
 		}
-		UE_LOG(LogTemp, Warning, TEXT("Take Damage"));
 
 		return ActualDamage;
 	}
@@ -367,6 +396,161 @@ float ANoxCharacter::TakeDamage(float Damage, FDamageEvent const& DamageEvent, A
 	}	
 }
 
+void ANoxCharacter::HandleDeath()
+{
+	// Change team to neutral when dead to stop attacking. Controller is changed too.
+	SetGenericTeamId(FGenericTeamId::NoTeam);
+
+	// Turn off attack ability for dead character
+	bCanAttack = false;
+
+	if (GetInformationBar() != NULL)
+	{
+		GetInformationBar()->bHiddenInGame = true;
+	}
+					
+	if (UNoxPlayerViewComponent* PlayerView = FindComponentByClass<UNoxPlayerViewComponent>())
+	{
+		PlayerView->RemoveCursor();
+	}
+
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	GetMovementComponent()->Deactivate();	
+	
+	// Dead characters are not seen by AI
+	if (UNoxSightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UNoxSightSubsystem>())
+	{
+		SightSubsystem->UnregisterSource(this);
+	}
+	GetAIPerceptionStimuliSource()->UnregisterFromPerceptionSystem();
+
+	// Deaths within the window are written to hitch captures
+	if (UNoxHitchWatchdogSubsystem* Watchdog = GetWorld()->GetSubsystem<UNoxHitchWatchdogSubsystem>())
+	{
+		Watchdog->NoteDeath(this);
+	}
+
+	if (HasAuthority())
+	{
+		GetWorldTimerManager().SetTimer(DeadDormancyTimerHandle, this, &ANoxCharacter::EnterDeadDormancy, DeadDormancyDelay, false);
+	}
+
+	// Death montage and ragdoll are only for the eyes
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// Check if array is not empty
+	if (DeathAnimMontages.Num() != NULL)
+	{
+		// Check if specified slot for montage is not null (or not loaded yet)
+		UAnimMontage* DeathAnimMontage = GetLoadedMontage(DeathAnimMontages[DeathMontageToUse]);
+		if (DeathAnimMontage != NULL)
+		{
+			float MontageLength = DeathAnimMontage->GetPlayLength();											
+
+			// Call ragdoll at the end of animation						
+			PlayMontageWithSpecificEffect(this, DeathAnimMontage, MontageLength, TEXT("Ragdoll"));
+			
+		}
+		else // If montages are empty call Ragdoll
+		{
+			Ragdoll();						
+		}
+	}
+	else  // If there are no montages call Ragdoll
+	{
+		Ragdoll();
+	}
+}
+
+void ANoxCharacter::EnterDeadDormancy()
+{
+	SetNetDormancy(DORM_DormantAll);
+
+	// Weapons replicate together with their owner, they would keep their channels open otherwise
+	if (EquippedWeapon != NULL)
+	{
+		EquippedWeapon->SetNetDormancy(DORM_DormantAll);
+	}
+
+	for (const auto& PooledWeapon : WeaponPool)
+	{
+		if (PooledWeapon.Value != NULL)
+		{
+			PooledWeapon.Value->SetNetDormancy(DORM_DormantAll);
+		}
+	}
+}
+
+void ANoxCharacter::SetHealth(const float NewHealth)
+{
+	Health = NewHealth;
+
+	// Update health procentage for correct operation of widgets.
+	HealthPercentage = CalculatePercentage(Health, MaxHealth);
+
+	ReplicatedHealth = (uint16)FMath::RoundToInt(FMath::Clamp(HealthPercentage, 0.f, 1.f) * MAX_uint16);
+}
+
+void ANoxCharacter::OnRep_ReplicatedHealth()
+{
+	HealthPercentage = (float)ReplicatedHealth / MAX_uint16;
+	Health = HealthPercentage * MaxHealth;
+}
+
+void ANoxCharacter::OnRep_ReplicatedMana()
+{
+	ManaPercentage = (float)ReplicatedMana / MAX_uint16;
+	Mana = ManaPercentage * MaxMana;
+}
+
+void ANoxCharacter::OnRep_IsAlive()
+{
+	if (!bIsAlive)
+	{
+		HandleDeath();
+	}
+}
+
+void ANoxCharacter::QueueCombatEvent(const ENoxCombatEventType Type, AActor* EventInstigator, const FVector& Location, const float Damage)
+{
+	ANoxGameState* GameState = GetWorld()->GetGameState<ANoxGameState>();
+	if (GameState == NULL)
+	{
+		return;
+	}
+
+	FNoxCombatEvent CombatEvent;
+	CombatEvent.Type = Type;
+	CombatEvent.Target = this;
+	CombatEvent.Instigator = EventInstigator;
+	CombatEvent.Location = Location;
+	CombatEvent.DamagePercent = (uint8)FMath::Clamp(FMath::RoundToInt(Damage / MaxHealth * 100.f), 0, 255);
+
+	GameState->QueueCombatEvent(CombatEvent);
+}
+
+void ANoxCharacter::OnCombatEvent(const FNoxCombatEvent& CombatEvent)
+{
+	// Server already played equip montages, clients only see the result
+	if (!HasAuthority())
+	{
+		if (CombatEvent.Type == ENoxCombatEventType::CE_EquipWeapon)
+		{
+			PlayAnimMontage(GetLoadedMontage(EquipWeaponAnimMontage));
+		}
+		else if (CombatEvent.Type == ENoxCombatEventType::CE_UnequipWeapon)
+		{
+			PlayAnimMontage(GetLoadedMontage(UnequipWeaponAnimMontage));
+		}
+	}
+
+	ReceiveCombatEvent(CombatEvent);
+}
+
 void ANoxCharacter::GetActorSingleFrontCollision(FHitResult& OutHitResult, const float RaycastRange, const ECollisionChannel CollisionChannel, const bool InbDrawRange)
 {
 	// Find Character's Character StartLocation
@@ -381,10 +565,12 @@ void ANoxCharacter::GetActorSingleFrontCollision(FHitResult& OutHitResult, const
 	// Line trace for collision  
 	GetWorld()->LineTraceSingleByChannel(OutHitResult, StartLocation, EndLocation, CollisionChannel, QueryParams);
 
+#if NOX_DRAW_DEBUG
 	if (InbDrawRange)
 	{
 		DrawDebugLine(GetWorld(), StartLocation, EndLocation, FColor::Red, false, 200, 1, 3);
 	}	
+#endif
 }
 
 template <typename UObjectTemplate, typename... VarTypes>
@@ -425,97 +611,271 @@ void ANoxCharacter::PlayMontageWithSpecificEffect(UObjectTemplate* InUserObject,
 	}
 }
 
-TArray<FName> ANoxCharacter::GetSocketsByECollisionPart(const ECollisionPart& CollisionPart)
+const TArray<FName>& ANoxCharacter::GetSocketsByECollisionPart(const ECollisionPart& CollisionPart) const
 {
-	TArray<FName> HandCollisionSockets;	
+	static const TArray<FName> NoCollisionSockets;
 
 	// Choose an array on whitch we will be working on 
 	switch (CollisionPart)
 	{
 	case ECollisionPart::CP_RightHand:
 	{
-		HandCollisionSockets = RightHandCollisionSockets;
-		break;
+		return RightHandCollisionSockets;
 	}
 	case ECollisionPart::CP_LeftHand:
 	{
-		HandCollisionSockets = LeftHandCollisionSockets;
-		break;
+		return LeftHandCollisionSockets;
 	}
 	default:
-		UE_LOG(LogTemp, Warning, TEXT("HitBoxNotify Collision Part is set to 'None'"));
-		break;
+		return NoCollisionSockets;
 	}
-	
-	return HandCollisionSockets;
 }
-		
 
-void ANoxCharacter::Attack()
+const FNoxAttackDefinition* ANoxCharacter::GetCurrentAttack() const
 {
-	if (bCanAttack)
+	if (AttackCatalog != NULL && AttackCatalog->IsValidAttackIndex(CurrentAttackIndex))
 	{
-		if (!bIsWeaponEquiped)
-		{
-			// Unarmed strike
-			UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(GetMesh()->GetAnimInstance());
-			if (NoxAnimInstance != NULL)
-			{
-				if (!NoxAnimInstance->IsAnyMontagePlaying())
-				{
-					CurrentUnarmedAttack = UnarmedAttacks[UnarmedAttackToUse];
+		return &AttackCatalog->GetAttack(CurrentAttackIndex);
+	}
 
-					PlayAnimMontage(UnarmedAttacks[UnarmedAttackToUse].Montage);
-				}
-			}
+	return NULL;
+}
+
+bool ANoxCharacter::CanStartMontageAction(const float EndTolerance) const
+{
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (AnimInstance == NULL)
+	{
+		return false;
+	}
+
+	// Check if any montage is currently playing (To prevent overlaping animation)
+	if (!AnimInstance->IsAnyMontagePlaying())
+	{
+		return true;
+	}
+
+	// Montage that is blending out or about to end does not block action predicted by client
+	const FAnimMontageInstance* MontageInstance = AnimInstance->GetActiveMontageInstance();
+	if (EndTolerance > 0.f && MontageInstance != NULL && MontageInstance->Montage != NULL)
+	{
+		return MontageInstance->IsStopped() || MontageInstance->Montage->GetPlayLength() - MontageInstance->GetPosition() <= EndTolerance;
+	}
+
+	return false;
+}
+
+int32 ANoxCharacter::FindAttackToStart(const float MontageEndTolerance, UAnimMontage*& OutAttackMontage) const
+{
+	OutAttackMontage = NULL;
+
+	if (!bCanAttack || AttackCatalog == NULL || !CanStartMontageAction(MontageEndTolerance))
+	{
+		return INDEX_NONE;
+	}
+
+	int32 AttackIndex = INDEX_NONE;
+
+	if (!bIsWeaponEquiped)
+	{
+		// Unarmed strike
+		AttackIndex = AttackCatalog->GetUnarmedAttackIndex(UnarmedAttackToUse);
+	}
+	else if (EquippedWeapon != NULL)
+	{
+		// Attack with weapon
+		// Get Tag of equipped weapon
+		const FGameplayTag& EquippedWeaponTag = EquippedWeapon->WeaponTag;
+		if (EquippedWeaponTag.IsValid())
+		{
+			// Find animation by tag for this type of weapon 		
+			AttackIndex = AttackCatalog->FindWeaponAttackIndex(EquippedWeaponTag);
 		}
-		else if (EquippedWeapon != NULL)
+		else
 		{
-			// Attack with weapon
-			// Get Tag of equipped weapon
-			FGameplayTag EquippedWeaponTag = EquippedWeapon->WeaponTag;
-			if (EquippedWeaponTag.IsValid())
-			{
-				// Find animation by tag for this type of weapon 		
-				for (const auto& WeaponAttack : WeaponAttacks)
-				{
-					if (EquippedWeaponTag.MatchesTagExact(WeaponAttack.Tag))
-					{
-						if (WeaponAttack.Montage != NULL)
-						{
-							UNoxAnimInstance* NoxAnimInstance = Cast<UNoxAnimInstance>(GetMesh()->GetAnimInstance());
-							if (NoxAnimInstance != NULL)
-							{
-								if (!NoxAnimInstance->IsAnyMontagePlaying())
-								{
-									CurrentWeaponAttack = WeaponAttack;
-
-									// Pass params of current attack to weapon class
-									EquippedWeapon->MeleeCollisionParams = WeaponAttack.MeleeCollisionParams;
-									EquippedWeapon->AttackDamageParams = WeaponAttack.AttackDamageParams;
-
-									PlayAnimMontage(WeaponAttack.Montage);
-								}
-							}
-						}
-					}
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("Invalid Tag in Equipped Weapon"))
-			}
+			UE_LOG(LogTemp, Warning, TEXT("Invalid Tag in Equipped Weapon"))
 		}
-	}	
+	}
+
+	if (AttackIndex != INDEX_NONE)
+	{
+		OutAttackMontage = GetLoadedMontage(AttackCatalog->GetAttack(AttackIndex).Montage);
+	}
+
+	return OutAttackMontage != NULL ? AttackIndex : INDEX_NONE;
+}
+
+void ANoxCharacter::Attack()
+{
+	UNoxReplaySubsystem::RecordEvent(ENoxReplayEvent::RE_Attack, this);
+
+	if (!HasAuthority())
+	{
+		// Owning client plays attack right away, server confirms it or rolls it back
+		UAnimMontage* AttackMontage = NULL;
+		const int32 AttackIndex = IsLocallyControlled() ? FindAttackToStart(0.f, AttackMontage) : INDEX_NONE;
+		if (AttackIndex != INDEX_NONE)
+		{
+			const uint8 PredictionKey = StartPrediction(ENoxPredictedAction::PA_Attack, AttackMontage);
+			LastPredictedAttackKey = PredictionKey;
+			CurrentAttackIndex = AttackIndex;
+
+			PlayAnimMontage(AttackMontage);
+
+			ServerAttack(PredictionKey);
+		}
+		return;
+	}
+
+	UAnimMontage* AttackMontage = NULL;
+	const int32 AttackIndex = FindAttackToStart(0.f, AttackMontage);
+	if (AttackIndex != INDEX_NONE)
+	{
+		StartAttack(AttackIndex, AttackMontage, 0);
+	}
+}
+
+void ANoxCharacter::StartAttack(const int32 AttackIndex, UAnimMontage* AttackMontage, const uint8 PredictionKey)
+{
+	CurrentAttackIndex = AttackIndex;
+
+	if (bIsWeaponEquiped && EquippedWeapon != NULL)
+	{
+		// Pass current attack to weapon class
+		EquippedWeapon->SetActiveAttack(AttackCatalog, AttackIndex);
+	}
+
+	PlayAnimMontage(AttackMontage);
+
+	if (UNoxHitchWatchdogSubsystem* Watchdog = GetWorld()->GetSubsystem<UNoxHitchWatchdogSubsystem>())
+	{
+		Watchdog->NoteAttack();
+	}
+
+	ReplicatedAttack.AttackIndex = (int16)AttackIndex;
+	ReplicatedAttack.Serial++;
+	ReplicatedAttack.PredictionKey = PredictionKey;
+	ReplicatedAttack.StartTime = GetServerWorldTime();
+
+	// Attack has to reach clients before its hit window
+	ForceNetUpdate();
+}
+
+bool ANoxCharacter::ServerAttack_Validate(uint8 PredictionKey)
+{
+	return PredictionKey != 0;
+}
+
+void ANoxCharacter::ServerAttack_Implementation(uint8 PredictionKey)
+{
+	// Same checks as on the client. Montage of the previous action may end here a bit later than on the client.
+	UAnimMontage* AttackMontage = NULL;
+	const int32 AttackIndex = FindAttackToStart(PredictionEndTolerance, AttackMontage);
+	if (AttackIndex != INDEX_NONE)
+	{
+		StartAttack(AttackIndex, AttackMontage, PredictionKey);
+	}
+
+	ClientAckPrediction(PredictionKey, AttackIndex != INDEX_NONE);
+}
+
+float ANoxCharacter::GetServerWorldTime() const
+{
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+
+	return GameState != NULL ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+void ANoxCharacter::OnRep_ReplicatedAttack()
+{
+	// Owner already plays attack it predicted
+	if (ReplicatedAttack.PredictionKey != 0 && ReplicatedAttack.PredictionKey == LastPredictedAttackKey && IsLocallyControlled())
+	{
+		return;
+	}
+
+	if (AttackCatalog == NULL || !AttackCatalog->IsValidAttackIndex(ReplicatedAttack.AttackIndex))
+	{
+		return;
+	}
+
+	UAnimMontage* AttackMontage = GetLoadedMontage(AttackCatalog->GetAttack(ReplicatedAttack.AttackIndex).Montage);
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (AttackMontage == NULL || AnimInstance == NULL)
+	{
+		return;
+	}
+
+	// Start from the point server is at now. Attack that already ended (e.g. when character becomes relevant) is not played.
+	const float Position = FMath::Max(GetServerWorldTime() - ReplicatedAttack.StartTime, 0.f);
+	if (Position < AttackMontage->GetPlayLength())
+	{
+		CurrentAttackIndex = ReplicatedAttack.AttackIndex;
+
+		AnimInstance->Montage_Play(AttackMontage, 1.f, EMontagePlayReturnType::MontageLength, Position);
+	}
+}
+
+uint8 ANoxCharacter::StartPrediction(const ENoxPredictedAction Action, UAnimMontage* Montage)
+{
+	// 0 means not predicted
+	NextPredictionKey = NextPredictionKey == MAX_uint8 ? 1 : NextPredictionKey + 1;
+
+	FNoxPredictedAction& PredictedAction = PendingPredictions.AddDefaulted_GetRef();
+	PredictedAction.Key = NextPredictionKey;
+	PredictedAction.Action = Action;
+	PredictedAction.Montage = Montage;
+	PredictedAction.StartTime = FPlatformTime::Seconds();
+
+	return NextPredictionKey;
+}
+
+void ANoxCharacter::ClientAckPrediction_Implementation(uint8 PredictionKey, bool bAccepted)
+{
+	const int32 ActionIndex = PendingPredictions.IndexOfByPredicate([PredictionKey](const FNoxPredictedAction& PredictedAction) { return PredictedAction.Key == PredictionKey; });
+	if (ActionIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FNoxPredictedAction PredictedAction = PendingPredictions[ActionIndex];
+	PendingPredictions.RemoveAt(ActionIndex);
+
+	SET_FLOAT_STAT(STAT_NoxPredictionRoundTripMs, (FPlatformTime::Seconds() - PredictedAction.StartTime) * 1000.0);
+
+	if (bAccepted)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_NoxRejectedPredictions);
+	UE_LOG(LogTemp, Log, TEXT("Server rejected predicted action %d of %s"), (int32)PredictedAction.Action, *GetName());
+
+	// Roll back to the state server has
+	if (PredictedAction.Montage.IsValid())
+	{
+		StopAnimMontage(PredictedAction.Montage.Get());
+	}
+
+	if (PredictedAction.Action == ENoxPredictedAction::PA_EquipWeapon || PredictedAction.Action == ENoxPredictedAction::PA_UnequipWeapon)
+	{
+		RestoreEquippedWeapon();
+	}
 }
 
 void ANoxCharacter::UnarmedAttack()
 {
+	const FNoxAttackDefinition* CurrentAttack = GetCurrentAttack();
+	if (CurrentAttack == NULL)
+	{
+		return;
+	}
+
 	TArray<FHitResult> HitResults;
 
 	// Create array that contain sockets locations
 	TArray<FVector> HandCollisionSocketsLocations;
-	for (const auto& HandCollisionSocket : CurrentHandCollisionSockets)
+	for (const auto& HandCollisionSocket : *CurrentHandCollisionSockets)
 	{
 		if (GetMesh()->DoesSocketExist(HandCollisionSocket))
 		{
@@ -524,9 +884,9 @@ void ANoxCharacter::UnarmedAttack()
 		}
 	}
 
-	ABaseWeapon::CreateCollisionByPointLocation<AActor>(this, OUT HitResults, CurrentUnarmedAttack.MeleeCollisionParams, ObjectTypesToCollideWithHands, AttackedActors, HandCollisionSocketsLocations);
+	ABaseWeapon::CreateCollisionByPointLocation<AActor>(this, OUT HitResults, CurrentAttack->MeleeCollisionParams, ObjectTypesToCollideWithHands, AttackedActors, HandCollisionSocketsLocations);
 
-	float FinalDamage = ABaseWeapon::CalculateFinalDamage(UnarmedDamage, CurrentUnarmedAttack.AttackDamageParams);
+	float FinalDamage = ABaseWeapon::CalculateFinalDamage(UnarmedDamage, CurrentAttack->AttackDamageParams);
 
 	FDamageEvent DamageEvent;
 	for (const auto& Hit : HitResults)
@@ -540,47 +900,82 @@ void ANoxCharacter::UnarmedAttack()
 	}
 }
 
+void ANoxCharacter::SetGenericTeamId(const FGenericTeamId& NewTeamId)
+{
+	if (TeamId == NewTeamId)
+	{
+		return;
+	}
+
+	TeamId = NewTeamId;
+
+	// Keep controller in sync, it calls back here and stops on the check above
+	if (IGenericTeamAgentInterface* ControllerTeamAgent = Cast<IGenericTeamAgentInterface>(GetController()))
+	{
+		ControllerTeamAgent->SetGenericTeamId(NewTeamId);
+	}
+}
+
+ETeamAttitude::Type ANoxCharacter::GetTeamAttitudeTowards(const AActor& Other) const
+{
+	return FNoxTeamAttitude::GetAttitudeTowards(TeamId, Other);
+}
+
+void ANoxCharacter::OnHitBoxNotifyBegin(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	// Only server deals damage, clients play replicated attacks for the look
+	if (HasAuthority())
+	{
+		OnDealDamageBegin(CollisionPart);
+	}
+}
+
+void ANoxCharacter::OnHitBoxNotifyEnd(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	if (HasAuthority())
+	{
+		OnDealDamageEnd(CollisionPart);
+	}
+}
+
 void ANoxCharacter::OnDealDamageBegin(const ECollisionPart& CollisionPart)
 {
 	// Set Flag to true at the start of an attack
 	bIsAttacking = true;
 
+	if (CollisionPart == ECollisionPart::CP_None)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("HitBoxNotify Collision Part is set to 'None'"));
+	}
+
 	// Get locations used to create collision line 	
-	CurrentHandCollisionSockets = GetSocketsByECollisionPart(CollisionPart);
+	CurrentHandCollisionSockets = &GetSocketsByECollisionPart(CollisionPart);
+
+	UpdateServerAnimTickOption();
 
 	if (!bIsWeaponEquiped)
 	{
 		// Enable Function UnarmedAttack() in tick;
 		bIsAttackingWithHands = true;		
+		UpdateTickEnabled();
 	}	
 	else if (EquippedWeapon != NULL)
 	{
-		if (CurrentWeaponAttack.bOverrideMeleeCollisionParams)
+		const FNoxAttackDefinition* CurrentAttack = GetCurrentAttack();
+
+		if (CurrentAttack != NULL && CurrentAttack->bOverrideMeleeCollisionParams)
 		{
-			// Empty array with hand sockets locations
-			if (!CurrentWeaponAttack.bUseHandCollisionWithWeaponAttack)
+			// Use no hand sockets
+			if (!CurrentAttack->bUseHandCollisionWithWeaponAttack)
 			{
-				CurrentHandCollisionSockets.Empty();
+				CurrentHandCollisionSockets = &GetSocketsByECollisionPart(ECollisionPart::CP_None);
 			}
 
-			if (EquippedWeapon->MeleeWeaponCollision.MeleeCollisionType == EMeleeCollisionType::MCT_CollisionByObject)
-			{
-				// If attack, change weapon collision type, then weapon additional range is always 0
-				EquippedWeapon->MeleeWeaponCollision.AdditionalWeaponRange = 0.f;
-
-				// Change method of geting collisions
-				EquippedWeapon->MeleeWeaponCollision.MeleeCollisionType = EMeleeCollisionType::MCT_CollisionBySocketsLocations;
-			}			
-		}
-		else if(CurrentWeaponAttack.MeleeCollisionParams.DrawDebugTrace != EDrawDebugTrace::None)
-		{
-			// if weapon attack does not override params then change DrawDebugTrace to None so that unusable(greyed out) varibable will not work on function.
-			CurrentWeaponAttack.MeleeCollisionParams.DrawDebugTrace = EDrawDebugTrace::None;
+			// Weapon reads collision type and range of this attack from the attack set by SetActiveAttack(), see ABaseWeapon::GetActiveMeleeCollisionType()
 		}
 
 		// Pass hands collision sockets to weapon for future use  
-		EquippedWeapon->MeleeCollisionParams.OwnerMesh = GetMesh();		
-		EquippedWeapon->MeleeCollisionParams.CollisionSockets = CurrentHandCollisionSockets;
+		EquippedWeapon->SetOwnerCollisionSockets(GetMesh(), CurrentHandCollisionSockets);
 
 		EquippedWeapon->OnWeaponAttackBegin();
 	}	
@@ -599,49 +994,361 @@ void ANoxCharacter::OnDealDamageEnd(const ECollisionPart& CollisionPart)
 
 	bIsAttacking = false;
 	bIsAttackingWithHands = false;
+	UpdateTickEnabled();
+	UpdateServerAnimTickOption();
 }
 
-void ANoxCharacter::CreateWeapon()
+void ANoxCharacter::UpdateServerAnimTickOption()
+{
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// Sockets used by hit traces move only when bones are refreshed
+	GetMesh()->VisibilityBasedAnimTickOption = bIsAttacking ? EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones : GetDefault<UNoxSignificanceSettings>()->DedicatedServerAnimTickOption.GetValue();
+}
+
+void ANoxCharacter::GetCombatAssetsToPreload(TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (bCanWieldWeapon)
+	{
+		OutAssets.Add(WeaponClassToEquip.ToSoftObjectPath());
+		OutAssets.Add(EquipWeaponAnimMontage.ToSoftObjectPath());
+		OutAssets.Add(UnequipWeaponAnimMontage.ToSoftObjectPath());
+	}
+
+	for (const auto& DeathAnimMontage : DeathAnimMontages)
+	{
+		OutAssets.Add(DeathAnimMontage.ToSoftObjectPath());
+	}
+
+	OutAssets.RemoveAll([](const FSoftObjectPath& Asset) { return Asset.IsNull(); });
+}
+
+void ANoxCharacter::RequestCombatAssets()
+{
+	UAssetManager& AssetManager = UAssetManager::Get();
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+	GetCombatAssetsToPreload(AssetsToLoad);
+
+	// Unarmed attacks are used by every character of the archetype. Asset Manager keeps bundle loaded for all of them.
+	if (AttackCatalog != NULL)
+	{
+		if (AttackCatalog->GetPrimaryAssetId().IsValid())
+		{
+			AssetManager.LoadPrimaryAsset(AttackCatalog->GetPrimaryAssetId(), { UNoxAttackCatalog::UnarmedBundle });
+		}
+		else
+		{
+			// Catalog converted from old character data is not known to Asset Manager
+			AttackCatalog->GetUnarmedAttackAssets(AssetsToLoad);
+		}
+	}
+
+	if (AssetsToLoad.Num() > 0)
+	{
+		CombatAssetsHandle = AssetManager.GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate::CreateUObject(this, &ANoxCharacter::OnCombatAssetsLoaded));
+	}
+}
+
+void ANoxCharacter::OnCombatAssetsLoaded()
+{
+	// Spawn weapon up front, so equipping later does not create any actor. Clients get weapons replicated.
+	if (bCanWieldWeapon && WeaponClassToEquip.Get() != NULL && HasAuthority())
+	{
+		if (ABaseWeapon* Weapon = AcquireWeaponFromPool(WeaponClassToEquip.Get()))
+		{
+			// Lets owning client predict equip
+			WeaponToEquip = Weapon;
+
+			// Only attacks of the weapon type that is in inventory are needed
+			RequestWeaponAttackAssets(Weapon->WeaponTag);
+		}
+	}
+}
+
+void ANoxCharacter::RequestWeaponAttackAssets(const FGameplayTag& WeaponTag)
+{
+	// Server and clients can ask for the same weapon more than once
+	if (AttackCatalog == NULL || (WeaponTag == LoadedWeaponAttackTag && WeaponAttackAssetsHandle.IsValid()))
+	{
+		return;
+	}
+	LoadedWeaponAttackTag = WeaponTag;
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+	AttackCatalog->GetWeaponAttackAssets(WeaponTag, AssetsToLoad);
+
+	if (AssetsToLoad.Num() > 0)
+	{
+		WeaponAttackAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad);
+	}
+}
+
+UAnimMontage* ANoxCharacter::GetLoadedMontage(const TSoftObjectPtr<UAnimMontage>& Montage) const
+{
+	UAnimMontage* LoadedMontage = Montage.Get();
+
+	// Already requested montage is still on its way
+	if (LoadedMontage == NULL && !Montage.IsNull() && !LateMontageHandles.Contains(Montage.ToSoftObjectPath()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Montage %s was not preloaded, loading it in the background"), *Montage.ToString());
+
+		// Handle keeps montage loaded after it arrives
+		LateMontageHandles.Add(Montage.ToSoftObjectPath(), UAssetManager::GetStreamableManager().RequestAsyncLoad(Montage.ToSoftObjectPath()));
+	}
+
+	return LoadedMontage;
+}
+
+ABaseWeapon* ANoxCharacter::AcquireWeaponFromPool(TSubclassOf<ABaseWeapon> WeaponClass)
 {
+	if (ABaseWeapon** PooledWeapon = WeaponPool.Find(WeaponClass))
+	{
+		if (*PooledWeapon != NULL && !(*PooledWeapon)->IsPendingKill())
+		{
+			return *PooledWeapon;
+		}
+	}
+
 	// Set SpawnParams
 	FActorSpawnParameters SpawnParams;
 	SpawnParams.Instigator = GetInstigator();
-	SpawnParams.Owner = GetOwner();
+	// Weapon is relevant to clients together with this character
+	SpawnParams.Owner = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ABaseWeapon* NewWeapon = GetWorld()->SpawnActor<ABaseWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+	if (NewWeapon != NULL)
+	{
+		// New weapon starts parked, same as weapon that was returned to the pool
+		NewWeapon->DeactivateWeapon();
+		WeaponPool.Add(WeaponClass, NewWeapon);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to spawn weapon for pool of %s"), *GetName());
+	}
+
+	return NewWeapon;
+}
+
+void ANoxCharacter::ReleaseWeaponToPool(ABaseWeapon* Weapon)
+{
+	Weapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Weapon->DeactivateWeapon();
+
+	MoveIgnoreActorRemove(Weapon);
+}
+
+void ANoxCharacter::CreateWeapon()
+{
+	EquippedWeapon = AcquireWeaponFromPool(WeaponClassToEquip.Get());
+	if (EquippedWeapon == NULL)
+	{
+		return;
+	}
+	WeaponToEquip = EquippedWeapon;
 
-	EquippedWeapon = GetWorld()->SpawnActor<ABaseWeapon>(WeaponClassToEquip, SpawnParams);
 	EquippedWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, WeaponGripPointSocket);
+	EquippedWeapon->ActivateWeapon();
 
 	// Ignore physical collision while moving?
 	MoveIgnoreActorAdd(EquippedWeapon);
 
 	bIsWeaponEquiped = true;
+	ForceNetUpdate();
 }
 
 void ANoxCharacter::DestroyWeapon()
 {	
-	EquippedWeapon->DetachFromActor(FDetachmentTransformRules::KeepRelativeTransform);
-		
-	EquippedWeapon->Destroy();	
+	// Weapon is not destroyed, only parked in the pool for the next equip
+	ReleaseWeaponToPool(EquippedWeapon);
+	EquippedWeapon = NULL;
 
 	bIsWeaponEquiped = false;
+	ForceNetUpdate();
+}
+
+void ANoxCharacter::OnRep_EquippedWeapon(ABaseWeapon* PreviousWeapon)
+{
+	if (PreviousWeapon != NULL)
+	{
+		PreviousWeapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		MoveIgnoreActorRemove(PreviousWeapon);
+	}
+
+	// Attachment is replicated too, attaching here only avoids waiting for it
+	if (EquippedWeapon != NULL)
+	{
+		EquippedWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, WeaponGripPointSocket);
+		MoveIgnoreActorAdd(EquippedWeapon);
+
+		// Clients select attacks of other characters too, they have to load them themselves
+		RequestWeaponAttackAssets(EquippedWeapon->WeaponTag);
+	}
+
+	bIsWeaponEquiped = EquippedWeapon != NULL;
+}
+
+void ANoxCharacter::OnRep_WeaponToEquip()
+{
+	// Owning client predicts attacks with the weapon, load them before it is equipped
+	if (WeaponToEquip != NULL)
+	{
+		RequestWeaponAttackAssets(WeaponToEquip->WeaponTag);
+	}
+}
+
+bool ANoxCharacter::ServerEquipWeapon_Validate(uint8 PredictionKey, bool bEquip)
+{
+	return PredictionKey != 0;
+}
+
+void ANoxCharacter::ServerEquipWeapon_Implementation(uint8 PredictionKey, bool bEquip)
+{
+	// Client predicted from a different weapon state than server has
+	const bool bAccepted = bEquip != bIsWeaponEquiped && StartEquipAction(PredictionEndTolerance);
+
+	ClientAckPrediction(PredictionKey, bAccepted);
 }
 
 void ANoxCharacter::EquipWeapon()
-{	
-	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+{
+	UNoxReplaySubsystem::RecordEvent(ENoxReplayEvent::RE_EquipWeapon, this);
 
-	// Check if any montage is currently playing (To prevent overlaping animation)
-	if (!AnimInstance->IsAnyMontagePlaying())
+	if (!HasAuthority())
+	{
+		if (IsLocallyControlled())
+		{
+			PredictEquipWeapon();
+		}
+		return;
+	}
+
+	StartEquipAction(0.f);
+}
+
+bool ANoxCharacter::StartEquipAction(const float MontageEndTolerance)
+{
+	if (!CanStartMontageAction(MontageEndTolerance))
+	{
+		return false;
+	}
+
+	if (!bIsWeaponEquiped)
 	{
-		if (!bIsWeaponEquiped)
+		// Weapon can't be equipped until its class is streamed in
+		if (WeaponClassToEquip.Get() == NULL)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Weapon class of %s is not loaded yet"), *GetName());
+			return false;
+		}
+
+		UAnimMontage* EquipMontage = GetLoadedMontage(EquipWeaponAnimMontage);
+		if (EquipMontage == NULL)
 		{
-			PlayMontageWithSpecificEffect(this, EquipWeaponAnimMontage, DelayTimeToEquipWeapon, FName("CreateWeapon"));
+			return false;
 		}
-		else if (EquippedWeapon != NULL)
+
+		PlayMontageWithSpecificEffect(this, EquipMontage, DelayTimeToEquipWeapon, FName("CreateWeapon"));
+		QueueCombatEvent(ENoxCombatEventType::CE_EquipWeapon, this, GetActorLocation());
+
+		return true;
+	}
+	else if (EquippedWeapon != NULL)
+	{
+		UAnimMontage* UnequipMontage = GetLoadedMontage(UnequipWeaponAnimMontage);
+		if (UnequipMontage == NULL)
 		{
-			PlayMontageWithSpecificEffect(this, UnequipWeaponAnimMontage, DelayTimeToUnequipWeapon, FName("DestroyWeapon"));
+			return false;
 		}
+
+		PlayMontageWithSpecificEffect(this, UnequipMontage, DelayTimeToUnequipWeapon, FName("DestroyWeapon"));
+		QueueCombatEvent(ENoxCombatEventType::CE_UnequipWeapon, this, GetActorLocation());
+
+		return true;
 	}
+
+	return false;
+}
+
+void ANoxCharacter::PredictEquipWeapon()
+{
+	if (!CanStartMontageAction(0.f))
+	{
+		return;
+	}
+
+	const bool bEquip = !bIsWeaponEquiped;
+
+	// Pooled weapon is replicated to owner once server has spawned it
+	if ((bEquip && WeaponToEquip == NULL) || (!bEquip && EquippedWeapon == NULL))
+	{
+		return;
+	}
+
+	UAnimMontage* Montage = GetLoadedMontage(bEquip ? EquipWeaponAnimMontage : UnequipWeaponAnimMontage);
+	if (Montage == NULL)
+	{
+		return;
+	}
+
+	const uint8 PredictionKey = StartPrediction(bEquip ? ENoxPredictedAction::PA_EquipWeapon : ENoxPredictedAction::PA_UnequipWeapon, Montage);
+	PredictedEquipKey = PredictionKey;
+
+	PlayMontageWithSpecificEffect(this, Montage, bEquip ? DelayTimeToEquipWeapon : DelayTimeToUnequipWeapon, FName("ApplyPredictedEquip"), PredictionKey);
+
+	ServerEquipWeapon(PredictionKey, bEquip);
+}
+
+void ANoxCharacter::ApplyPredictedEquip(uint8 PredictionKey)
+{
+	// Rolled back before montage got here
+	if (PredictedEquipKey != PredictionKey)
+	{
+		return;
+	}
+
+	// Server state replaces this when EquippedWeapon is replicated, see OnRep_EquippedWeapon()
+	if (!bIsWeaponEquiped && WeaponToEquip != NULL)
+	{
+		WeaponToEquip->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, WeaponGripPointSocket);
+		WeaponToEquip->SetActorHiddenInGame(false);
+		MoveIgnoreActorAdd(WeaponToEquip);
+		bIsWeaponEquiped = true;
+	}
+	else if (bIsWeaponEquiped && EquippedWeapon != NULL)
+	{
+		EquippedWeapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		EquippedWeapon->SetActorHiddenInGame(true);
+		MoveIgnoreActorRemove(EquippedWeapon);
+		bIsWeaponEquiped = false;
+	}
+}
+
+void ANoxCharacter::RestoreEquippedWeapon()
+{
+	PredictedEquipKey = 0;
+
+	// Put weapon back the way server has it
+	if (WeaponToEquip != NULL && WeaponToEquip != EquippedWeapon)
+	{
+		WeaponToEquip->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		WeaponToEquip->SetActorHiddenInGame(true);
+		MoveIgnoreActorRemove(WeaponToEquip);
+	}
+
+	if (EquippedWeapon != NULL)
+	{
+		EquippedWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, WeaponGripPointSocket);
+		EquippedWeapon->SetActorHiddenInGame(false);
+		MoveIgnoreActorAdd(EquippedWeapon);
+	}
+
+	bIsWeaponEquiped = EquippedWeapon != NULL;
 }
 
 
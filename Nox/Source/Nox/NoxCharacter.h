@@ -5,80 +5,75 @@
 #include "CoreMinimal.h"
 #include "GameplayTagAssetInterface.h"
 #include "GameFramework/Character.h"
+#include "GenericTeamAgentInterface.h"
 #include "Weapons/BaseWeapon.h"
+#include "Combat/NoxAttackCatalog.h"
+#include "Significance/NoxSignificance.h"
+#include "Anim/NoxAnimInstance.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "NoxGameState.h"
 #include "NoxCharacter.generated.h"
 
-USTRUCT(BlueprintType)
-struct FUnarmedAttack
+/** Attack replicated to clients as catalog index and start time, clients play montage from the point server is at. */
+USTRUCT()
+struct FNoxReplicatedAttack
 {
 	GENERATED_BODY()
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-		UAnimMontage* Montage;
+	// Index in attack catalog, INDEX_NONE until first attack
+	UPROPERTY()
+		int16 AttackIndex = INDEX_NONE;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-		FAttackDamageParams AttackDamageParams;
+	// Changed by every attack, so the same attack started twice is replicated twice
+	UPROPERTY()
+		uint8 Serial = 0;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-		FMeleeCollisionParams MeleeCollisionParams;
+	// Key of owning client prediction that started this attack, 0 if attack was not predicted
+	UPROPERTY()
+		uint8 PredictionKey = 0;
+
+	// Server world time when attack started
+	UPROPERTY()
+		float StartTime = 0.f;
 };
 
-USTRUCT(BlueprintType)
-struct FWeaponAttack
+enum class ENoxPredictedAction : uint8
 {
-	GENERATED_BODY()
-
-	// Montage tag used to determine for which weapon this animation should be played.
-	//	e.g. Weapon have tag Sword.HeavyAttack. Montage with that tag will be played when character attack with a weapon.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-		FGameplayTag Tag;	 
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-		UAnimMontage* Montage;
+	PA_None,
+	PA_Attack,
+	PA_EquipWeapon,
+	PA_UnequipWeapon
+};
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-		FAttackDamageParams AttackDamageParams;
+/** Action that owning client started before server answered. Removed when server confirms or rejects its key. */
+struct FNoxPredictedAction
+{
+	uint8 Key = 0;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta =(InlineEditConditionToggle))
-		bool bOverrideMeleeCollisionParams;
+	ENoxPredictedAction Action = ENoxPredictedAction::PA_None;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (DisplayName = "Override Melee Collision Params", EditCondition = "bOverrideMeleeCollisionParams"))
-		FMeleeCollisionParams MeleeCollisionParams;
+	// Stopped when server rejects the action
+	TWeakObjectPtr<UAnimMontage> Montage;
 
-	// Turn on collision for hands when attacking with weapon (only usable with weapon that use Trace Socket Collision)
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (DisplayAfter = "MeleeCollisionParams", EditCondition = "bOverrideMeleeCollisionParams"))
-		bool bUseHandCollisionWithWeaponAttack;
+	// Platform time when action was predicted, used to measure round trip
+	double StartTime = 0.0;
 };
 
-
 ///////////////////////////////////////////////////////////////////////////////////
 /// ANoxCharacter CLASS
 ///////////////////////////////////////////////////////////////////////////////////
 
 
 UCLASS(Blueprintable)
-class ANoxCharacter : public ACharacter
+class ANoxCharacter : public ACharacter, public IGenericTeamAgentInterface, public INoxHitBoxListener
 {
 	GENERATED_BODY()
 
-		/** Top down camera */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-		class UCameraComponent* TopDownCameraComponent;
-
-	/** Camera boom positioning the camera above the character */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-		class USpringArmComponent* CameraBoom;
-
-	/** A decal that projects to the cursor location. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-		class UDecalComponent* CursorToWorld;
-
 	/** Widget that contain information about character. Bar is floating above character. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Floating Bar", meta = (AllowPrivateAccess = "true"))
 		class UWidgetComponent* InformationBar;
 
-	/** Perception stimuli for AI */
+	/** Perception stimuli for AI controllers that still use perception sight, see ANoxAIController::UsesPerceptionSight() */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI Perception Stimuli", meta = (AllowPrivateAccess = "true"))
 		class UAIPerceptionStimuliSourceComponent* AIPerceptionStimuliSource;
 
@@ -90,12 +85,35 @@ public:
 
 protected:
 	// APawn interface	
+	virtual void PostLoad() override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaSeconds) override;
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void UnPossessed() override;
+	virtual void OnRep_Controller() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// IGenericTeamAgentInterface interface
+	virtual void SetGenericTeamId(const FGenericTeamId& NewTeamId) override;
+	virtual FGenericTeamId GetGenericTeamId() const override { return TeamId; }
+	virtual ETeamAttitude::Type GetTeamAttitudeTowards(const AActor& Other) const override;
+	// End IGenericTeamAgentInterface interface
+
+	// INoxHitBoxListener interface
+	virtual void OnHitBoxNotifyBegin(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload) override;
+	virtual void OnHitBoxNotifyEnd(const ECollisionPart CollisionPart, const FBranchingPointNotifyPayload& BranchingPointPayload) override;
+	// End INoxHitBoxListener interface
 	// End of APawn interface
 
-	/**Material is used to change opaque material of static meshes blocking view on pawn.
+	// Tick is needed only during unarmed hit window and mesh smoothing. Camera view of player is updated by UNoxPlayerViewComponent.
+	void UpdateTickEnabled();
+
+	// Dedicated server ticks only montages of the mesh, except inside hit windows. Does nothing on clients and listen server.
+	void UpdateServerAnimTickOption();
+
+	/**Material is used to change opaque material of static meshes blocking view on pawn. Used by UNoxPlayerViewComponent while player controls this character.
 	*@note - Set material reference in BP. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera Visibility")
 		UMaterialInterface* TranslucentMaterial;
@@ -107,6 +125,13 @@ protected:
 	//UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Attributes")
 	float Mana;
 
+	// Health and Mana replicated as fraction of their maximum, 65535 is full
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedHealth)
+		uint16 ReplicatedHealth;
+
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedMana)
+		uint16 ReplicatedMana;
+
 	// Maximum Health and Mana values
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attributes")
 		float MaxHealth;
@@ -130,22 +155,27 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Melee Collision Sockets", AdvancedDisplay)
 		TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToCollideWithHands;
 
+	// Unarmed and weapon attacks of this character archetype. Shared by all characters using the same catalog.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attack")
+		class UNoxAttackCatalog* AttackCatalog;
+
+	// Attacks saved before AttackCatalog existed. PostLoad() moves them into a catalog stored inside the character, so old Blueprints keep attacking until they get a shared catalog asset.
+	UPROPERTY()
+		TArray<FUnarmedAttack> UnarmedAttacks_DEPRECATED;
+
+	UPROPERTY()
+		TArray<FWeaponAttack> WeaponAttacks_DEPRECATED;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unarmed Attack")
 		float UnarmedDamage;
 
-	// Chose iterator of array as a new default. If not specified first animation in array will be used (iterator 0)
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unarmed Attack", meta = (ArrayClamp = "UnarmedAttacks", DisplayAfter = "UnarmedDamage"))
+	// Chose iterator of catalog UnarmedAttacks array as a new default. If not specified first animation in array will be used (iterator 0)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Unarmed Attack", meta = (ClampMin = "0", DisplayAfter = "UnarmedDamage"))
 		int UnarmedAttackToUse;
 
-	// Animation montages to play when attack without a weapon is done 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Unarmed Attack")
-		TArray<FUnarmedAttack> UnarmedAttacks;
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Attack")
-		TArray<FWeaponAttack> WeaponAttacks;
-
+	// Streamed in on BeginPlay, weapon can't be equipped before it is loaded
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Equip Weapon")
-		TSubclassOf<class ABaseWeapon> WeaponClassToEquip;
+		TSoftClassPtr<class ABaseWeapon> WeaponClassToEquip;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Equip Weapon")
 		bool bCanWieldWeapon;
@@ -155,13 +185,13 @@ protected:
 		FName WeaponGripPointSocket;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Equip Weapon", Meta = (EditCondition = "bCanWieldWeapon"))
-		class UAnimMontage* EquipWeaponAnimMontage;
+		TSoftObjectPtr<class UAnimMontage> EquipWeaponAnimMontage;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Equip Weapon", Meta = (EditCondition = "bCanWieldWeapon"))
 		float DelayTimeToEquipWeapon;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Equip Weapon", Meta = (EditCondition = "bCanWieldWeapon"))
-		class UAnimMontage* UnequipWeaponAnimMontage;
+		TSoftObjectPtr<class UAnimMontage> UnequipWeaponAnimMontage;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Equip Weapon", Meta = (EditCondition = "bCanWieldWeapon"))
 		float DelayTimeToUnequipWeapon;
@@ -171,7 +201,7 @@ protected:
 		int DeathMontageToUse;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Death")
-		TArray<class UAnimMontage*> DeathAnimMontages;				
+		TArray<TSoftObjectPtr<class UAnimMontage>> DeathAnimMontages;				
 
 	UPROPERTY(BlueprintReadOnly)
 		bool bIsAttacking;
@@ -185,44 +215,169 @@ protected:
 	UPROPERTY(BlueprintReadOnly)
 		bool bCanAttack;
 
-	UPROPERTY(BlueprintReadOnly)
+	UPROPERTY(ReplicatedUsing = OnRep_IsAlive, BlueprintReadOnly)
 		bool bIsAlive;
 
-private:
-	ABaseWeapon* EquippedWeapon;	
+	// Team of the controller, cached so attitude queries do not have to go through the controller
+	FGenericTeamId TeamId;
 
-public:
+	// Current level of detail tier assigned by FNoxSignificance
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Significance")
+		ENoxSignificanceTier SignificanceTier;
+
+	// Server accepts predicted action when current montage ends within this time. Covers jitter of client packets.
+	UPROPERTY(EditDefaultsOnly, Category = "Network")
+		float PredictionEndTolerance;
+
+	// Dead character stops replicating after this time. Gives last state changes time to reach clients, ragdoll runs on clients only.
+	UPROPERTY(EditDefaultsOnly, Category = "Network")
+		float DeadDormancyDelay;
+
+	FTimerHandle DeadDormancyTimerHandle;
 
+	// Server only. Put dead character and its weapons to sleep, replication graph moves it to static grid list.
+	void EnterDeadDormancy();
 
+	// How fast mesh catches up with capsule after character leaves nav walking
+	UPROPERTY(EditDefaultsOnly, Category = "Significance")
+		float MeshSmoothingSpeed;
+
+	// Height difference between mesh and capsule that is left to smooth out
+	float MeshSmoothingOffsetZ;
+
+	void UpdateMeshSmoothing(const float DeltaSeconds);
 
 private:
-	// Return objects that cover camera view on pawn 
-	void GetCameraViewPointCollisions(TArray<FHitResult>& OutHits);
-
-	/** define new structure that stores object reference and its original material.
-   *@note We need pointer to original material, because HitResult uses r-value. Using only HitResult to store original material, would lead to change of material reference from original to NewMaterial whenever material is changed, which is pointes for our needs.*/
-	struct FObjectAndOriginalMaterial
-	{
-		const FHitResult Object;
-		UMaterialInterface* OriginalMaterial; // pointer to original material		
-	};
-	// Internal array for ChangeMaterialOfCollidingObjects function. Array of colliding objects with changed material and pointer to original material 
-	TArray<FObjectAndOriginalMaterial> ObjectsWithChangedMaterial;
-
-	/**
-	*@param CollidingObjects - Array of colliding objects that new material should be set to
-	*@param NewMaterial - Pointer to material that colliding object should be changed to
-	*@param bRestoreOriginalMaterial - Should restore original material if collision with object stop
+	// Weapons are spawned by server, clients attach the replicated one in OnRep_EquippedWeapon()
+	UPROPERTY(ReplicatedUsing = OnRep_EquippedWeapon)
+		ABaseWeapon* EquippedWeapon;	
+
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedAttack)
+		FNoxReplicatedAttack ReplicatedAttack;
+
+	// Pooled weapon that EquipWeapon() would equip, replicated to owner so equip can be predicted
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponToEquip)
+		ABaseWeapon* WeaponToEquip;
+
+	UFUNCTION()
+		void OnRep_ReplicatedHealth();
+
+	UFUNCTION()
+		void OnRep_ReplicatedMana();
+
+	UFUNCTION()
+		void OnRep_IsAlive();
+
+	UFUNCTION()
+		void OnRep_EquippedWeapon(ABaseWeapon* PreviousWeapon);
+
+	UFUNCTION()
+		void OnRep_WeaponToEquip();
+
+	UFUNCTION()
+		void OnRep_ReplicatedAttack();
+
+	// Owning client plays its actions right away and sends them with prediction key. Server answers with ClientAckPrediction().
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerAttack(uint8 PredictionKey);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerEquipWeapon(uint8 PredictionKey, bool bEquip);
+
+	// Rejected action is rolled back. Accepted attack is not replayed from ReplicatedAttack.
+	UFUNCTION(Client, Reliable)
+		void ClientAckPrediction(uint8 PredictionKey, bool bAccepted);
+
+	uint8 NextPredictionKey;
+
+	uint8 LastPredictedAttackKey;
+
+	// Key of predicted equip or unequip that was not rolled back yet
+	uint8 PredictedEquipKey;
+
+	TArray<FNoxPredictedAction> PendingPredictions;
+
+	/** Add action waiting for server answer
+	*@return - New prediction key, never 0
 	*/
-	void ChangeMaterialOfCollidingObjects(const TArray<FHitResult>& CollidingObjects, UMaterialInterface* NewMaterial, bool bRestoreOriginalMaterial = false);
-		
-	void GetCollisionUnderCharacter(FHitResult& OutHit);
+	uint8 StartPrediction(const ENoxPredictedAction Action, UAnimMontage* Montage);
+
+	/** Montage of a new action can start only when no other montage is playing.
+	*@param EndTolerance - Montage that ends within this time does not block (used by server for predicted actions)
+	*/
+	bool CanStartMontageAction(const float EndTolerance) const;
+
+	/** Same checks on client and server
+	*@return - Attack catalog index of attack that can start now or INDEX_NONE
+	*/
+	int32 FindAttackToStart(const float MontageEndTolerance, UAnimMontage*& OutAttackMontage) const;
+
+	// Server only. Play attack montage and replicate the attack.
+	void StartAttack(const int32 AttackIndex, UAnimMontage* AttackMontage, const uint8 PredictionKey);
+
+	// Server only. Play equip or unequip montage, weapon is changed in the middle of it.
+	bool StartEquipAction(const float MontageEndTolerance);
+
+	void PredictEquipWeapon();
+
+	// Called in the middle of predicted equip montage, same moment as CreateWeapon() or DestroyWeapon() on server
+	UFUNCTION()
+		void ApplyPredictedEquip(uint8 PredictionKey);
+
+	// Undo predicted equip or unequip
+	void RestoreEquippedWeapon();
+
+	// Server only. Set Health and its replicated fraction.
+	void SetHealth(const float NewHealth);
+
+	// Server time shared by server and clients, used by replicated attacks
+	float GetServerWorldTime() const;
+
+	// Server only. Send cosmetic event with the next batch of ANoxGameState.
+	void QueueCombatEvent(const ENoxCombatEventType Type, AActor* EventInstigator, const FVector& Location, const float Damage = 0.f);
+
+	// Turn dead character off. Runs on server when health is depleted and on clients when bIsAlive is replicated.
+	void HandleDeath();
+
+	// Weapons spawned once per class and reused between equips. Unequipped weapons stay here hidden, without collision and tick.
+	UPROPERTY()
+		TMap<TSubclassOf<ABaseWeapon>, ABaseWeapon*> WeaponPool;
+
+	/** Take weapon of given class from the pool, spawning it only if pool does not have one yet.
+	*@return - Parked (inactive) weapon or NULL if it could not be spawned
+	*/
+	ABaseWeapon* AcquireWeaponFromPool(TSubclassOf<ABaseWeapon> WeaponClass);
+
+	// Detach weapon from the character and park it in the pool
+	void ReleaseWeaponToPool(ABaseWeapon* Weapon);
+
+	// Keep streamed combat assets of this character loaded
+	TSharedPtr<struct FStreamableHandle> CombatAssetsHandle;
+	TSharedPtr<struct FStreamableHandle> WeaponAttackAssetsHandle;
+
+	// Weapon tag of WeaponAttackAssetsHandle
+	FGameplayTag LoadedWeaponAttackTag;
+
+	// Montages that were not preloaded, one load per montage however often it is asked for
+	mutable TMap<FSoftObjectPath, TSharedPtr<struct FStreamableHandle>> LateMontageHandles;
+
+	// Start async loading of attack catalog bundles, montages and weapon class
+	void RequestCombatAssets();
+
+	// Called when assets from GetCombatAssetsToPreload() are loaded
+	void OnCombatAssetsLoaded();
+
+	// Start async loading of attacks used with weapon of given tag
+	void RequestWeaponAttackAssets(const FGameplayTag& WeaponTag);
+
+	/** Return montage if it is already loaded. Otherwise start loading it in the background and return NULL, so game thread never waits for it. */
+	UAnimMontage* GetLoadedMontage(const TSoftObjectPtr<UAnimMontage>& Montage) const;
+
+public:
 
-	// Variables needed in function ChangeChannelCollisionResponseWhileColliding()
-	FHitResult LastHit;
-	ECollisionResponse LastHitOriginalCollisionResponse;
-	void ChangeChannelCollisionResponseWhileColliding(const FHitResult& InHit, const ECollisionChannel&& InChannel, const ECollisionResponse&& NewResponseDuringCollision);
 
+
+private:
 	/** Calculate percentage based on current value and max value
    *@return - Value between 0 and 1
    */
@@ -249,25 +404,28 @@ private:
 	void PlayMontageWithSpecificEffect(UObjectTemplate* InUserObject, UAnimMontage* AnimMontageToPlay, const float DelayTimeToTriggerFunction, const FName& InFunctionName, VarTypes... Vars);	
 	
 	TArray<AActor*> AttackedActors;		
-	FUnarmedAttack CurrentUnarmedAttack;
-	FWeaponAttack CurrentWeaponAttack;
+
+	// Index of current attack in AttackCatalog
+	int32 CurrentAttackIndex;
+
+	/** @return - Current attack from AttackCatalog or NULL */
+	const struct FNoxAttackDefinition* GetCurrentAttack() const;
+
 	/*
-	* @return TArray<FVector> - Array of socket locations (sockets are in "Melee Collision Sockets" category)
+	* @return TArray<FName> - Array of socket names (sockets are in "Melee Collision Sockets" category)
 	*/
-	UFUNCTION()
-	TArray<FName> GetSocketsByECollisionPart(const ECollisionPart& CollisionPart);	
+	const TArray<FName>& GetSocketsByECollisionPart(const ECollisionPart& CollisionPart) const;	
 
-	TArray<FName> CurrentHandCollisionSockets;
-	UFUNCTION(BlueprintCallable)
-		void Attack();
+	// Points to RightHandCollisionSockets or LeftHandCollisionSockets. Never NULL.
+	const TArray<FName>* CurrentHandCollisionSockets;
 
 	void UnarmedAttack();
 
-	// Function bind to HitBoxNotify
+	// Called by HitBoxNotify through OnHitBoxNotifyBegin()
 	UFUNCTION()
 	void OnDealDamageBegin(const ECollisionPart& CollisionPart = ECollisionPart::CP_None);
 	
-	// Function bind to HitBoxNotify
+	// Called by HitBoxNotify through OnHitBoxNotifyEnd()
 	UFUNCTION()
 		void OnDealDamageEnd(const ECollisionPart& CollisionPart = ECollisionPart::CP_None);
 
@@ -278,16 +436,37 @@ private:
 	UFUNCTION()
 		void DestroyWeapon();
 
+public:
+	// Equip weapon from the pool or put it away. Used by player input and by replay.
 	UFUNCTION(BlueprintCallable)
 		void EquipWeapon();
 
-public:
-	/** Returns TopDownCameraComponent subobject **/
-	FORCEINLINE class UCameraComponent* GetTopDownCameraComponent() const { return TopDownCameraComponent; }
-	/** Returns CameraBoom subobject **/
-	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
-	/** Returns CursorToWorld subobject **/
-	FORCEINLINE class UDecalComponent* GetCursorToWorld() { return CursorToWorld; }
+	// Play attack montage of equipped weapon or unarmed attack. Used by player input and by AI.
+	UFUNCTION(BlueprintCallable)
+		void Attack();
+
+	// Path followed by native patrol tasks when AI has nothing else to do. Blueprint NPCs keep their own PatrolPath variable for the blueprint patrol tasks.
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category = "AI")
+		class ANoxPatrolPath* NativePatrolPath;
+
+	// Add soft references of this character (death and equip montages, weapon class) that should be streamed in before character needs them
+	void GetCombatAssetsToPreload(TArray<FSoftObjectPath>& OutAssets) const;
+
+	FORCEINLINE class UNoxAttackCatalog* GetAttackCatalog() const { return AttackCatalog; }
+
+	// Called by ANoxGameState for every cosmetic event about this character
+	void OnCombatEvent(const FNoxCombatEvent& CombatEvent);
+
+	// Hook for hit and death effects. Not called on dedicated server.
+	UFUNCTION(BlueprintImplementableEvent, Category = "Combat", meta = (DisplayName = "On Combat Event"))
+		void ReceiveCombatEvent(const FNoxCombatEvent& CombatEvent);
+
+	FORCEINLINE bool IsAttacking() const { return bIsAttacking; }
+	FORCEINLINE bool IsWeaponEquipped() const { return bIsWeaponEquiped; }
+	FORCEINLINE bool IsAlive() const { return bIsAlive; }
+	FORCEINLINE bool CanAttack() const { return bCanAttack; }
+
+	FORCEINLINE UMaterialInterface* GetTranslucentMaterial() const { return TranslucentMaterial; }
 	/** Returns InformationBar subobject **/
 	FORCEINLINE class UWidgetComponent* GetInformationBar() const { return InformationBar; }
 	/** Returns AIPerceptionStimuliSource subobject **/
@@ -295,6 +474,17 @@ public:
 	/** Returns AISight subobject **/
 	FORCEINLINE class UAISense_Sight* GetAISight() const { return AISight; }
 
+	FORCEINLINE ENoxSignificanceTier GetSignificanceTier() const { return SignificanceTier; }
+	// Only stores the tier, settings of the tier are applied by FNoxSignificance::ApplyTier()
+	FORCEINLINE void SetSignificanceTier(ENoxSignificanceTier NewTier) { SignificanceTier = NewTier; }
+
+	/** Switch between walking and nav walking (projected on navmesh, no floor sweeps). Only walking character can start nav walking.
+	*@note Leaving nav walking moves capsule to the real floor, mesh is smoothed to hide height difference
+	*/
+	void SetNavWalkingEnabled(const bool bEnabled);
+
+	bool IsNavWalking() const;
+
 
 };
 
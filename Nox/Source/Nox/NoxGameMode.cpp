@@ -3,17 +3,102 @@
 #include "NoxGameMode.h"
 #include "NoxPlayerController.h"
 #include "NoxCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "NoxGameState.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "Significance/NoxSignificance.h"
 
 ANoxGameMode::ANoxGameMode()
 {
 	// use our custom PlayerController class
 	PlayerControllerClass = ANoxPlayerController::StaticClass();
 
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/TopDownCPP/Blueprints/TopDownCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// Sends cosmetic combat events to clients in batches
+	GameStateClass = ANoxGameState::StaticClass();
+
+	// set default pawn class to our Blueprinted character, loaded asynchronously in InitGame()
+	DefaultPawnSoftClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/TopDownCPP/Blueprints/TopDownCharacter.TopDownCharacter_C")));
+
+	// Needed only on dedicated server, see UpdateServerSignificance()
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void ANoxGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	if (!DefaultPawnSoftClass.IsNull())
+	{
+		UAssetManager::GetStreamableManager().RequestAsyncLoad(DefaultPawnSoftClass.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &ANoxGameMode::OnDefaultPawnClassLoaded), FStreamableManager::AsyncLoadHighPriority, true);
+	}
+}
+
+void ANoxGameMode::HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer)
+{
+	// Wait for pawn class instead of loading it on the game thread
+	if (!DefaultPawnSoftClass.IsNull() && DefaultPawnSoftClass.Get() == NULL)
+	{
+		PlayersWaitingForPawnClass.Add(NewPlayer);
+		return;
+	}
+
+	Super::HandleStartingNewPlayer_Implementation(NewPlayer);
+}
+
+void ANoxGameMode::OnDefaultPawnClassLoaded()
+{
+	if (DefaultPawnSoftClass.Get() != NULL)
+	{
+		DefaultPawnClass = DefaultPawnSoftClass.Get();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to load default pawn class %s"), *DefaultPawnSoftClass.ToString());
+
+		// Start waiting players with the fallback DefaultPawnClass
+		DefaultPawnSoftClass.Reset();
+	}
+
+	for (const auto& WaitingPlayer : PlayersWaitingForPawnClass)
+	{
+		if (WaitingPlayer.IsValid())
+		{
+			Super::HandleStartingNewPlayer_Implementation(WaitingPlayer.Get());
+		}
+	}
+	PlayersWaitingForPawnClass.Empty();
+}
+
+void ANoxGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Server scores NPCs from the views of all players, also on listen server where NPCs fight remote players.
+	// Game mode does not exist on clients, they update significance from the local player controller.
+	if (GetNetMode() != NM_Client)
+	{
+		UpdateServerSignificance();
+	}
+}
+
+void ANoxGameMode::UpdateServerSignificance()
+{
+	ServerViewpoints.Reset();
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController != NULL && PlayerController->GetPawn() != NULL)
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ServerViewpoints.Add(FTransform(ViewRotation, ViewLocation));
+		}
+	}
+
+	if (ServerViewpoints.Num() > 0)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		FNoxSignificance::Update(GetWorld(), ServerViewpoints);
 	}
-}
\ No newline at end of file
+}
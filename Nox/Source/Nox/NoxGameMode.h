@@ -13,6 +13,28 @@ class ANoxGameMode : public AGameModeBase
 
 public:
 	ANoxGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	virtual void HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer) override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	// Pawn class streamed in on InitGame. Players that join before it is loaded are started when it arrives.
+	UPROPERTY(EditDefaultsOnly, Category = Classes)
+		TSoftClassPtr<APawn> DefaultPawnSoftClass;
+
+private:
+	void OnDefaultPawnClassLoaded();
+
+	TArray<TWeakObjectPtr<APlayerController>> PlayersWaitingForPawnClass;
+
+	// Server (dedicated, listen or standalone) scores NPCs from views of all players
+	void UpdateServerSignificance();
+
+	// Reused every frame by UpdateServerSignificance()
+	TArray<FTransform> ServerViewpoints;
 };
 
 
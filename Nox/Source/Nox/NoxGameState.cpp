@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxGameState.h"
+#include "NoxCharacter.h"
+
+ANoxGameState::ANoxGameState()
+{
+	// Ticks only to flush combat events
+	PrimaryActorTick.bCanEverTick = true;
+
+	CombatEventFlushInterval = 0.1f;
+	MaxCombatEventsPerBatch = 32;
+	MaxPendingCombatEvents = 256;
+	TimeToNextFlush = 0.f;
+}
+
+void ANoxGameState::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	TimeToNextFlush -= DeltaSeconds;
+	if (TimeToNextFlush > 0.f || PendingCombatEvents.Num() == 0)
+	{
+		return;
+	}
+
+	TimeToNextFlush = CombatEventFlushInterval;
+
+	// Everything goes out now, events waiting for later flushes would arrive late and pile up in large fights
+	const int32 BatchSize = FMath::Max(MaxCombatEventsPerBatch, 1);
+	for (int32 FirstIndex = 0; FirstIndex < PendingCombatEvents.Num(); FirstIndex += BatchSize)
+	{
+		CombatEventBatch.Reset();
+		CombatEventBatch.Append(PendingCombatEvents.GetData() + FirstIndex, FMath::Min(PendingCombatEvents.Num() - FirstIndex, BatchSize));
+
+		MulticastCombatEvents(CombatEventBatch);
+	}
+
+	PendingCombatEvents.Reset();
+}
+
+void ANoxGameState::QueueCombatEvent(const FNoxCombatEvent& CombatEvent)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// Hits are only effects, too many of them in one interval would not be seen anyway
+	if (CombatEvent.Type == ENoxCombatEventType::CE_Hit && PendingCombatEvents.Num() >= MaxPendingCombatEvents)
+	{
+		return;
+	}
+
+	PendingCombatEvents.Add(CombatEvent);
+}
+
+void ANoxGameState::MulticastCombatEvents_Implementation(const TArray<FNoxCombatEvent>& CombatEvents)
+{
+	// Nobody watches dedicated server
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	for (const FNoxCombatEvent& CombatEvent : CombatEvents)
+	{
+		// Target was not relevant to this client
+		if (CombatEvent.Target == NULL)
+		{
+			continue;
+		}
+
+		if (ANoxCharacter* Character = Cast<ANoxCharacter>(CombatEvent.Target))
+		{
+			Character->OnCombatEvent(CombatEvent);
+		}
+
+		OnCombatEvent.Broadcast(CombatEvent);
+	}
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "Engine/NetSerialization.h"
+#include "NoxGameState.generated.h"
+
+UENUM(BlueprintType)
+enum class ENoxCombatEventType : uint8
+{
+	CE_Hit				UMETA(DisplayName = "Hit"),
+	CE_Death			UMETA(DisplayName = "Death"),
+	CE_EquipWeapon		UMETA(DisplayName = "Equip Weapon"),
+	CE_UnequipWeapon	UMETA(DisplayName = "Unequip Weapon")
+};
+
+/** Cosmetic combat event. Game state (health, alive, equipped weapon, attack) is replicated by ANoxCharacter, events only drive effects and UI. */
+USTRUCT(BlueprintType)
+struct FNoxCombatEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+		ENoxCombatEventType Type = ENoxCombatEventType::CE_Hit;
+
+	// Character that was hit, died or changed weapon. NULL on clients that do not have it replicated.
+	UPROPERTY(BlueprintReadOnly)
+		AActor* Target = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+		AActor* Instigator = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+		FVector_NetQuantize Location;
+
+	// Damage in percent of target max health, clamped to 255
+	UPROPERTY(BlueprintReadOnly)
+		uint8 DamagePercent = 0;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNoxCombatEventSignature, const FNoxCombatEvent&, CombatEvent);
+
+/**
+ * Collects cosmetic combat events on the server and sends them to clients in batches, as one unreliable multicast per flush.
+ * Lost batch only loses effects, never game state.
+ */
+UCLASS()
+class NOX_API ANoxGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	ANoxGameState();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Server only. Event is sent with the next batch.
+	void QueueCombatEvent(const FNoxCombatEvent& CombatEvent);
+
+	// Called on clients, listen server and standalone for every received event
+	UPROPERTY(BlueprintAssignable, Category = "Combat")
+		FNoxCombatEventSignature OnCombatEvent;
+
+protected:
+	// Time between batches
+	UPROPERTY(EditDefaultsOnly, Category = "Combat Events")
+		float CombatEventFlushInterval;
+
+	// Flush sends more multicasts if there are more events, keeps single multicast small
+	UPROPERTY(EditDefaultsOnly, Category = "Combat Events")
+		int32 MaxCombatEventsPerBatch;
+
+	// Hit events over this number within one flush interval are dropped. Deaths and weapon changes are always sent.
+	UPROPERTY(EditDefaultsOnly, Category = "Combat Events")
+		int32 MaxPendingCombatEvents;
+
+	UFUNCTION(NetMulticast, Unreliable)
+		void MulticastCombatEvents(const TArray<FNoxCombatEvent>& CombatEvents);
+
+private:
+	TArray<FNoxCombatEvent> PendingCombatEvents;
+
+	float TimeToNextFlush;
+
+	// Reused by every flush
+	TArray<FNoxCombatEvent> CombatEventBatch;
+};
@@ -7,6 +7,11 @@
 #include "NoxCharacter.h"
 #include "Animation/AnimInstance.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Significance/NoxSignificance.h"
+#include "Combat/NoxTeamAttitude.h"
+#include "Player/NoxPlayerViewComponent.h"
+#include "Diagnostics/NoxReplaySubsystem.h"
 
 #define ECC_CursorMovement ECC_GameTraceChannel1
 
@@ -19,14 +24,33 @@ ANoxPlayerController::ANoxPlayerController()
 	WalkingSpeedPercentage = 0.25f;	
 
 	TeamId = FGenericTeamId(0);
+
+	PlayerViewComponentClass = UNoxPlayerViewComponent::StaticClass();
+	PlayerView = NULL;
 }
 
 void ANoxPlayerController::PlayerTick(float DeltaTime)
 {
 	Super::PlayerTick(DeltaTime);
-	
-	// Find what is under cursor 
-	GetHitResultUnderCursor(ECollisionChannel::ECC_CursorMovement, true, OUT HitUnderCursor);
+
+#if !UE_SERVER
+	// Server ticks controllers of remote players too, they have no cursor or camera here
+	if (!IsLocalController())
+	{
+		return;
+	}
+
+	// Find what is under cursor, replay puts it where it was recorded
+	if (!UNoxReplaySubsystem::GetReplayedCursorHit(HitUnderCursor))
+	{
+		GetHitResultUnderCursor(ECollisionChannel::ECC_CursorMovement, true, OUT HitUnderCursor);
+		UNoxReplaySubsystem::RecordCursorHit(GetPawn(), HitUnderCursor.Location);
+	}
+
+	if (PlayerView != NULL)
+	{
+		PlayerView->UpdateCursor(HitUnderCursor);
+	}
 	
 	if (CanCharacterRotate())
 	{
@@ -34,7 +58,13 @@ void ANoxPlayerController::PlayerTick(float DeltaTime)
 		RotatePawnToCursor();
 	}	
 	
-	
+	// Score NPCs from the camera of this player. Server (also listen and standalone) does it in ANoxGameMode from all players.
+	if (PlayerCameraManager != NULL && GetNetMode() == NM_Client)
+	{
+		const FTransform Viewpoint(PlayerCameraManager->GetCameraRotation(), PlayerCameraManager->GetCameraLocation());
+		FNoxSignificance::Update(GetWorld(), TArrayView<const FTransform>(&Viewpoint, 1));
+	}
+#endif
 }
 
 void ANoxPlayerController::SetupInputComponent()
@@ -46,6 +76,53 @@ void ANoxPlayerController::SetupInputComponent()
 		
 }
 
+void ANoxPlayerController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	// Pawn caches team of its controller
+	if (ANoxCharacter* NoxCharacter = Cast<ANoxCharacter>(InPawn))
+	{
+		NoxCharacter->SetGenericTeamId(TeamId);
+	}
+}
+
+void ANoxPlayerController::SetPawn(APawn* InPawn)
+{
+	// Previous pawn goes back to having no camera
+	if (PlayerView != NULL && PlayerView->GetOwner() != InPawn)
+	{
+		PlayerView->DestroyComponent();
+		PlayerView = NULL;
+	}
+
+	Super::SetPawn(InPawn);
+
+#if !UE_SERVER
+	// Only local player needs the view, server does not create it for remote players
+	if (InPawn != NULL && PlayerView == NULL && IsLocalController() && PlayerViewComponentClass != NULL)
+	{
+		PlayerView = NewObject<UNoxPlayerViewComponent>(InPawn, PlayerViewComponentClass, MakeUniqueObjectName(InPawn, PlayerViewComponentClass, TEXT("PlayerView")));
+		PlayerView->RegisterComponent();
+	}
+#endif
+}
+
+void ANoxPlayerController::SetGenericTeamId(const FGenericTeamId& NewTeamId)
+{
+	TeamId = NewTeamId;
+
+	if (ANoxCharacter* NoxCharacter = GetPawn<ANoxCharacter>())
+	{
+		NoxCharacter->SetGenericTeamId(NewTeamId);
+	}
+}
+
+ETeamAttitude::Type ANoxPlayerController::GetTeamAttitudeTowards(const AActor& Other) const
+{
+	return FNoxTeamAttitude::GetAttitudeTowards(TeamId, Other);
+}
+
 void ANoxPlayerController::RotatePawnToCursor()
 {
 	// Find new pawn rotation based on start location and target location.
@@ -59,6 +136,8 @@ void ANoxPlayerController::MoveForward(float Value)
 {	
 	if (Value != 0.0f)
 	{
+		UNoxReplaySubsystem::RecordEvent(ENoxReplayEvent::RE_MoveForward, GetPawn(), NULL, FVector(Value, 0.f, 0.f));
+
 		// Find front of a pawn  
 		const FVector Direction = GetPawn()->GetActorForwardVector();		
 		
@@ -20,13 +20,28 @@ protected:
 	virtual void PlayerTick(float DeltaTime) override;
 	
 	virtual void SetupInputComponent() override;
+
+	virtual void OnPossess(APawn* InPawn) override;
+
+	// Called on server and on owning client, adds camera and cursor to the new pawn
+	virtual void SetPawn(APawn* InPawn) override;
 	// End PlayerController interface
 
+	// Camera, cursor and camera visibility of controlled pawn
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Camera")
+		TSubclassOf<class UNoxPlayerViewComponent> PlayerViewComponentClass;
+
+	UPROPERTY(Transient)
+		class UNoxPlayerViewComponent* PlayerView;
+
 private:
 	FGenericTeamId TeamId;
 
 public:
+	// Team is cached on the controlled ANoxCharacter too
+	virtual void SetGenericTeamId(const FGenericTeamId& NewTeamId) override;
 	virtual FGenericTeamId GetGenericTeamId() const override { return TeamId; }
+	virtual ETeamAttitude::Type GetTeamAttitudeTowards(const AActor& Other) const override;
 
 public:	
 
@@ -0,0 +1,259 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxPlayerViewComponent.h"
+#include "Camera/CameraComponent.h"
+#include "Components/DecalComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "Engine/World.h"
+#include "Nox/NoxCharacter.h"
+#include "UObject/ConstructorHelpers.h"
+
+#define ECC_CursorMovement ECC_GameTraceChannel1 
+#define ECC_CameraView ECC_GameTraceChannel2
+#define ECC_Ground ECC_GameTraceChannel3
+
+UNoxPlayerViewComponent::UNoxPlayerViewComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	bAutoActivate = true;
+
+	TargetArmLength = 800.f;
+	ArmRotation = FRotator(-60.f, 0.f, 0.f);
+	CursorDecalSize = FVector(16.0f, 32.0f, 32.0f);
+
+	// Same decal the character blueprints used before cursor moved here
+	static ConstructorHelpers::FObjectFinder<UMaterialInterface> CursorDecalMaterialAsset(TEXT("/Game/TopDownCPP/Blueprints/M_Cursor_Decal.M_Cursor_Decal"));
+	CursorDecalMaterial = CursorDecalMaterialAsset.Succeeded() ? CursorDecalMaterialAsset.Object : NULL;
+	TranslucentMaterial = NULL;
+
+	CameraBoom = NULL;
+	Camera = NULL;
+	CursorDecal = NULL;
+}
+
+void UNoxPlayerViewComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* Owner = GetOwner();
+	USceneComponent* OwnerRoot = Owner->GetRootComponent();
+
+	// Names are made unique, pawn can still hold destroyed components of previous possession
+
+	// Create a camera boom...
+	CameraBoom = NewObject<USpringArmComponent>(Owner, MakeUniqueObjectName(Owner, USpringArmComponent::StaticClass(), TEXT("CameraBoom")));
+	CameraBoom->SetupAttachment(OwnerRoot);
+	CameraBoom->SetUsingAbsoluteRotation(true); // Don't want arm to rotate when character does
+	CameraBoom->TargetArmLength = TargetArmLength;
+	CameraBoom->SetRelativeRotation(ArmRotation);
+	CameraBoom->bDoCollisionTest = false; // Don't want to pull camera in when it collides with level
+	CameraBoom->RegisterComponent();
+
+	// Create a camera...
+	Camera = NewObject<UCameraComponent>(Owner, MakeUniqueObjectName(Owner, UCameraComponent::StaticClass(), TEXT("TopDownCamera")));
+	Camera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+	Camera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm	
+	Camera->RegisterComponent();
+
+	// Create a decal in the world to show the cursor's location
+	CursorDecal = NewObject<UDecalComponent>(Owner, MakeUniqueObjectName(Owner, UDecalComponent::StaticClass(), TEXT("CursorToWorld")));
+	CursorDecal->SetupAttachment(OwnerRoot);
+	CursorDecal->DecalSize = CursorDecalSize;
+	CursorDecal->SetDecalMaterial(CursorDecalMaterial);
+	CursorDecal->SetRelativeRotation(FRotator(90.0f, 0.0f, 0.0f).Quaternion());
+	CursorDecal->RegisterComponent();
+
+	if (TranslucentMaterial == NULL)
+	{
+		if (ANoxCharacter* NoxCharacter = Cast<ANoxCharacter>(Owner))
+		{
+			TranslucentMaterial = NoxCharacter->GetTranslucentMaterial();
+		}
+	}
+}
+
+void UNoxPlayerViewComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	RestoreChangedObjects();
+
+	// Components were created for this player only, pawn does not keep them after it is unpossessed
+	if (CameraBoom != NULL)
+	{
+		CameraBoom->DestroyComponent();
+		CameraBoom = NULL;
+	}
+
+	if (Camera != NULL)
+	{
+		Camera->DestroyComponent();
+		Camera = NULL;
+	}
+
+	RemoveCursor();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UNoxPlayerViewComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Camera == NULL)
+	{
+		return;
+	}
+
+	TArray<FHitResult> CameraViewHits;
+	GetCameraViewPointCollisions(OUT CameraViewHits);
+	ChangeMaterialOfCollidingObjects(CameraViewHits, TranslucentMaterial, true);
+
+	FHitResult HitUnderCharacter;
+	GetCollisionUnderCharacter(OUT HitUnderCharacter);
+	ChangeChannelCollisionResponseWhileColliding(HitUnderCharacter, ECollisionChannel::ECC_CursorMovement, ECollisionResponse::ECR_Block);
+}
+
+void UNoxPlayerViewComponent::UpdateCursor(const FHitResult& HitUnderCursor)
+{
+	if (CursorDecal != NULL && HitUnderCursor.bBlockingHit)
+	{
+		CursorDecal->SetWorldLocationAndRotation(HitUnderCursor.Location, HitUnderCursor.ImpactNormal.Rotation());
+	}
+}
+
+void UNoxPlayerViewComponent::RemoveCursor()
+{
+	if (CursorDecal != NULL)
+	{
+		CursorDecal->DestroyComponent();
+		CursorDecal = NULL;
+	}
+}
+
+void UNoxPlayerViewComponent::RestoreChangedObjects()
+{
+	for (const FObjectAndOriginalMaterial& ObjectWithChangedMaterial : ObjectsWithChangedMaterial)
+	{
+		if (ObjectWithChangedMaterial.Object.GetComponent() != NULL)
+		{
+			ObjectWithChangedMaterial.Object.GetComponent()->SetMaterial(0, ObjectWithChangedMaterial.OriginalMaterial);
+		}
+	}
+	ObjectsWithChangedMaterial.Empty();
+
+	if (LastHit.GetComponent() != NULL)
+	{
+		LastHit.GetComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_CursorMovement, LastHitOriginalCollisionResponse);
+	}
+	LastHit.Reset();
+}
+
+void UNoxPlayerViewComponent::GetCameraViewPointCollisions(TArray<FHitResult>& OutHits)
+{	
+	// Find Character's CameraComponent StartLocation
+	const FVector StartLocation = Camera->GetComponentLocation();
+	// Find Character's CameraComponent EndLocation where lenght of ray corresponds to CameraBoom arm length
+	const FVector EndLocation = (StartLocation + (Camera->GetForwardVector() * CameraBoom->TargetArmLength));
+	
+	FCollisionQueryParams QueryParams;	
+
+	// Ignore all objects with non static/stationary mobility type (ignore movable mobility type) 
+	QueryParams.MobilityType = EQueryMobilityType::Static;
+
+	// Collisions for subcalsses of APawn are ignored by default in DefaultEngine.ini for ECC_CameraView channel. Default ECC_CameraView response is overlap  
+	GetWorld()->LineTraceMultiByChannel(OutHits, StartLocation, EndLocation, ECollisionChannel::ECC_CameraView, QueryParams);
+}
+
+void UNoxPlayerViewComponent::ChangeMaterialOfCollidingObjects(const TArray<FHitResult>& CollidingObjects, UMaterialInterface* NewMaterial, bool bRestoreOriginalMaterial)
+{
+/// Set new material, add elements to array
+
+	// For loop works only, if there are collisions.   
+	for (int i = 0; i < CollidingObjects.Num(); i++)
+	{			
+		if (NewMaterial != NULL)
+		{
+			UPrimitiveComponent* Component = CollidingObjects[i].GetComponent();
+			if (Component == NULL || Component->GetMaterial(0) == NULL)
+			{
+				continue;
+			}
+
+			// Change material only once
+			if (Component->GetMaterial(0)->GetName() != NewMaterial->GetName())
+			{
+				// Add elements to array only if Origin material should be restored.
+				if (bRestoreOriginalMaterial)
+				{
+					// Object with changed material and pointer to its original material 
+					FObjectAndOriginalMaterial TempObjectAndMaterial{ CollidingObjects[i], CollidingObjects[i].GetComponent()->GetMaterial(0) };
+					// Add element to array
+					ObjectsWithChangedMaterial.Push(TempObjectAndMaterial);
+				}
+				// Set new translucent material
+				CollidingObjects[i].GetComponent()->SetMaterial(0, NewMaterial);				
+			}
+		}
+		else
+		{
+			// Error code
+			UE_LOG(LogTemp, Warning, TEXT("(Function: ChangeMaterialWhileColliding) - Pointer to NewMaterial is not found!"));
+			return;
+		}			
+	}	
+
+/// Restore original material, remove elements from array
+
+	// Check every changed object, one object can stop colliding in the same frame another one starts. If bRestoreOriginalMaterial is false, array is always empty.
+	// Walked backwards, so removing an element does not skip the next one
+	for (int32 i = ObjectsWithChangedMaterial.Num() - 1; i >= 0; i--)
+	{
+		const AActor* ChangedActor = ObjectsWithChangedMaterial[i].Object.GetActor();
+
+		// Check if camera view is still blocked and object should stay translucent
+		const bool bIsStillColliding = CollidingObjects.ContainsByPredicate([ChangedActor](const FHitResult& Hit) { return Hit.GetActor() == ChangedActor; });
+		if (!bIsStillColliding)
+		{
+			// Change object material from translucent back to original
+			if (UPrimitiveComponent* Component = ObjectsWithChangedMaterial[i].Object.GetComponent())
+			{
+				Component->SetMaterial(0, ObjectsWithChangedMaterial[i].OriginalMaterial);
+			}
+
+			ObjectsWithChangedMaterial.RemoveAt(i);
+		}
+	}
+}
+
+void UNoxPlayerViewComponent::GetCollisionUnderCharacter(FHitResult& OutHit)
+{
+	// Find Character Location
+	const FVector StartLocation = GetOwner()->GetActorLocation();
+	// Find LineTrace EndLocation, object under character
+	const FVector EndLocation = (StartLocation + ((GetOwner()->GetActorForwardVector() + FVector(0.f, 0.f, -90.f)) * 1.25f));
+
+	// Collisions for subcalsses of APawn are ignored by default in DefaultEngine.ini for ECC_Ground channel. Default ECC_Ground response is block  
+	GetWorld()->LineTraceSingleByChannel(OutHit, StartLocation, EndLocation, ECollisionChannel::ECC_Ground);	
+}
+
+void UNoxPlayerViewComponent::ChangeChannelCollisionResponseWhileColliding(const FHitResult& InHit, const ECollisionChannel&& InChannel, const ECollisionResponse&& NewResponseDuringCollision)
+{	
+	if (LastHit.GetActor() != NULL)
+	{
+		if (InHit.GetActor() != LastHit.GetActor())
+		{				
+				LastHit.GetComponent()->SetCollisionResponseToChannel(InChannel, LastHitOriginalCollisionResponse);
+		}
+	}		
+
+	if (InHit.bBlockingHit)
+	{
+		if (InHit.GetComponent()->GetCollisionResponseToChannel(InChannel) != NewResponseDuringCollision)
+		{
+			LastHit = InHit;			
+			LastHitOriginalCollisionResponse = InHit.GetComponent()->GetCollisionResponseToChannel(InChannel);
+			InHit.GetComponent()->SetCollisionResponseToChannel(InChannel, NewResponseDuringCollision);			
+		}
+	}		
+}
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NoxPlayerViewComponent.generated.h"
+
+/**
+ * Camera, cursor decal and camera visibility logic of a pawn controlled by local player.
+ * Added by ANoxPlayerController when it gets a pawn and removed when it loses it, so NPCs never create these components.
+ */
+UCLASS(ClassGroup = (Nox), Blueprintable)
+class NOX_API UNoxPlayerViewComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UNoxPlayerViewComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera")
+		float TargetArmLength;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera")
+		FRotator ArmRotation;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cursor")
+		FVector CursorDecalSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cursor")
+		class UMaterialInterface* CursorDecalMaterial;
+
+	/**Material is used to change opaque material of static meshes blocking view on pawn.
+	*@note - If not set, TranslucentMaterial of ANoxCharacter is used. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera Visibility")
+		class UMaterialInterface* TranslucentMaterial;
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Move cursor decal to the hit under cursor. Hit is traced by player controller.
+	void UpdateCursor(const FHitResult& HitUnderCursor);
+
+	// Cursor is not shown anymore, e.g. when pawn dies
+	void RemoveCursor();
+
+	FORCEINLINE class UCameraComponent* GetCamera() const { return Camera; }
+	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
+	FORCEINLINE class UDecalComponent* GetCursorDecal() const { return CursorDecal; }
+
+private:
+	/** Camera boom positioning the camera above the pawn */
+	UPROPERTY(Transient)
+		class USpringArmComponent* CameraBoom;
+
+	/** Top down camera */
+	UPROPERTY(Transient)
+		class UCameraComponent* Camera;
+
+	/** A decal that projects to the cursor location. */
+	UPROPERTY(Transient)
+		class UDecalComponent* CursorDecal;
+
+	// Return objects that cover camera view on pawn 
+	void GetCameraViewPointCollisions(TArray<FHitResult>& OutHits);
+
+	/** define new structure that stores object reference and its original material.
+   *@note We need pointer to original material, because HitResult uses r-value. Using only HitResult to store original material, would lead to change of material reference from original to NewMaterial whenever material is changed, which is pointes for our needs.*/
+	struct FObjectAndOriginalMaterial
+	{
+		const FHitResult Object;
+		UMaterialInterface* OriginalMaterial; // pointer to original material		
+	};
+	// Internal array for ChangeMaterialOfCollidingObjects function. Array of colliding objects with changed material and pointer to original material 
+	TArray<FObjectAndOriginalMaterial> ObjectsWithChangedMaterial;
+
+	/**
+	*@param CollidingObjects - Array of colliding objects that new material should be set to
+	*@param NewMaterial - Pointer to material that colliding object should be changed to
+	*@param bRestoreOriginalMaterial - Should restore original material if collision with object stop
+	*/
+	void ChangeMaterialOfCollidingObjects(const TArray<FHitResult>& CollidingObjects, UMaterialInterface* NewMaterial, bool bRestoreOriginalMaterial = false);
+		
+	void GetCollisionUnderCharacter(FHitResult& OutHit);
+
+	// Variables needed in function ChangeChannelCollisionResponseWhileColliding()
+	FHitResult LastHit;
+	ECollisionResponse LastHitOriginalCollisionResponse;
+	void ChangeChannelCollisionResponseWhileColliding(const FHitResult& InHit, const ECollisionChannel&& InChannel, const ECollisionResponse&& NewResponseDuringCollision);
+
+	// Give back original materials and collision responses changed by this component
+	void RestoreChangedObjects();
+};
@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxSignificance.h"
+#include "Nox/Nox.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Nox/AI/NoxAIController.h"
+#include "Nox/Simulation/NoxSimulationSubsystem.h"
+#include "SignificanceManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/WidgetComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_NoxSignificanceUpdate, STATGROUP_Nox);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("NPCs in tier High"), STAT_NoxSignificanceTierHigh, STATGROUP_Nox);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("NPCs in tier Medium"), STAT_NoxSignificanceTierMedium, STATGROUP_Nox);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("NPCs in tier Low"), STAT_NoxSignificanceTierLow, STATGROUP_Nox);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("NPCs in tier Lowest"), STAT_NoxSignificanceTierLowest, STATGROUP_Nox);
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxSignificanceSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxSignificanceSettings::UNoxSignificanceSettings()
+{
+	Tiers.SetNum((int32)ENoxSignificanceTier::ST_MAX);
+
+	Tiers[(int32)ENoxSignificanceTier::ST_Medium].MaxDistance = 3500.f;
+	Tiers[(int32)ENoxSignificanceTier::ST_Medium].AnimFramesToSkip = 1;
+
+	Tiers[(int32)ENoxSignificanceTier::ST_Low].MaxDistance = 6000.f;
+	Tiers[(int32)ENoxSignificanceTier::ST_Low].AnimFramesToSkip = 3;
+	Tiers[(int32)ENoxSignificanceTier::ST_Low].MovementTickInterval = 0.05f;
+	Tiers[(int32)ENoxSignificanceTier::ST_Low].bShowInformationBar = false;
+	Tiers[(int32)ENoxSignificanceTier::ST_Low].bUseNavWalking = true;
+
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].MaxDistance = BIG_NUMBER;
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].AnimFramesToSkip = 8;
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].bInterpolateSkippedFrames = false;
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].bUpdatePerception = false;
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].MovementTickInterval = 0.1f;
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].bShowInformationBar = false;
+	Tiers[(int32)ENoxSignificanceTier::ST_Lowest].bUseNavWalking = true;
+
+	HysteresisDistance = 200.f;
+	NotRenderedDistanceScale = 2.f;
+	RecentlyRenderedTime = 0.5f;
+
+	DedicatedServerAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+}
+
+const FNoxSignificanceTierSettings& UNoxSignificanceSettings::GetTierSettings(ENoxSignificanceTier Tier) const
+{
+	static const FNoxSignificanceTierSettings DefaultTierSettings;
+
+	if (Tiers.Num() == 0)
+	{
+		return DefaultTierSettings;
+	}
+
+	// Missing tiers use settings of the last one specified
+	return Tiers[FMath::Min((int32)Tier, Tiers.Num() - 1)];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FNoxSignificance
+//////////////////////////////////////////////////////////////////////////
+
+const FName FNoxSignificance::CharacterTag = FName("NoxCharacter");
+
+namespace
+{
+	// Significance Manager sorts higher values as more significant, so distance is returned negated.
+	// Can be called from worker threads, reads only.
+	float CalculateSignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint)
+	{
+		const ANoxCharacter* Character = CastChecked<ANoxCharacter>(ObjectInfo->GetObject());
+		const UNoxSignificanceSettings* Settings = GetDefault<UNoxSignificanceSettings>();
+
+		float Distance = FVector::Dist(Character->GetActorLocation(), Viewpoint.GetLocation());
+
+		// Dedicated server renders nothing, every character would be pushed away
+		if (!IsRunningDedicatedServer() && !Character->WasRecentlyRendered(Settings->RecentlyRenderedTime))
+		{
+			Distance *= Settings->NotRenderedDistanceScale;
+		}
+
+		return -Distance;
+	}
+
+	ENoxSignificanceTier CalculateTier(const float Distance, const ENoxSignificanceTier CurrentTier)
+	{
+		const UNoxSignificanceSettings* Settings = GetDefault<UNoxSignificanceSettings>();
+		const int32 LastTier = (int32)ENoxSignificanceTier::ST_MAX - 1;
+
+		int32 NewTier = (int32)CurrentTier;
+
+		// Drop tier only after passing its border by hysteresis distance
+		while (NewTier < LastTier && Distance > Settings->GetTierSettings((ENoxSignificanceTier)NewTier).MaxDistance + Settings->HysteresisDistance)
+		{
+			NewTier++;
+		}
+
+		// Raise tier only after getting closer than border of the higher tier by hysteresis distance
+		while (NewTier > 0 && Distance < Settings->GetTierSettings((ENoxSignificanceTier)(NewTier - 1)).MaxDistance - Settings->HysteresisDistance)
+		{
+			NewTier--;
+		}
+
+		return (ENoxSignificanceTier)NewTier;
+	}
+
+	// Called on the game thread after significance of a character was updated
+	void OnSignificanceUpdated(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal)
+	{
+		ANoxCharacter* Character = CastChecked<ANoxCharacter>(ObjectInfo->GetObject());
+
+		const ENoxSignificanceTier NewTier = CalculateTier(-Significance, Character->GetSignificanceTier());
+		if (NewTier != Character->GetSignificanceTier())
+		{
+			FNoxSignificance::ApplyTier(Character, NewTier);
+		}
+	}
+}
+
+void FNoxSignificance::RegisterCharacter(ANoxCharacter* Character)
+{
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(Character->GetWorld());
+	if (SignificanceManager != NULL && SignificanceManager->GetManagedObject(Character) == NULL)
+	{
+		SignificanceManager->RegisterObject(Character, CharacterTag, &CalculateSignificance, USignificanceManager::EPostSignificanceType::Sequential, &OnSignificanceUpdated);
+	}
+}
+
+void FNoxSignificance::UnregisterCharacter(ANoxCharacter* Character)
+{
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(Character->GetWorld());
+	if (SignificanceManager != NULL && SignificanceManager->GetManagedObject(Character) != NULL)
+	{
+		SignificanceManager->UnregisterObject(Character);
+	}
+}
+
+void FNoxSignificance::Update(UWorld* World, TArrayView<const FTransform> Viewpoints)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxSignificanceUpdate);
+	NOX_HITCH_SCOPE(HS_Significance);
+
+	// Simulated battles are far from any camera, every character keeps full detail
+	if (UNoxSimulationSubsystem::IsSimulationRun())
+	{
+		return;
+	}
+
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(World);
+	if (SignificanceManager == NULL)
+	{
+		return;
+	}
+
+	SignificanceManager->Update(Viewpoints);
+
+#if STATS
+	uint32 CharactersInTier[(int32)ENoxSignificanceTier::ST_MAX] = {};
+	for (const USignificanceManager::FManagedObjectInfo* ObjectInfo : SignificanceManager->GetManagedObjects(CharacterTag))
+	{
+		CharactersInTier[(int32)CastChecked<ANoxCharacter>(ObjectInfo->GetObject())->GetSignificanceTier()]++;
+	}
+
+	SET_DWORD_STAT(STAT_NoxSignificanceTierHigh, CharactersInTier[(int32)ENoxSignificanceTier::ST_High]);
+	SET_DWORD_STAT(STAT_NoxSignificanceTierMedium, CharactersInTier[(int32)ENoxSignificanceTier::ST_Medium]);
+	SET_DWORD_STAT(STAT_NoxSignificanceTierLow, CharactersInTier[(int32)ENoxSignificanceTier::ST_Low]);
+	SET_DWORD_STAT(STAT_NoxSignificanceTierLowest, CharactersInTier[(int32)ENoxSignificanceTier::ST_Lowest]);
+#endif
+}
+
+void FNoxSignificance::ApplyTier(ANoxCharacter* Character, ENoxSignificanceTier Tier)
+{
+	const FNoxSignificanceTierSettings& TierSettings = GetDefault<UNoxSignificanceSettings>()->GetTierSettings(Tier);
+
+	Character->SetSignificanceTier(Tier);
+
+	// Animation update rate. Same frame skip is used for every LOD of the mesh.
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	if (Mesh->AnimUpdateRateParams != NULL)
+	{
+		FAnimUpdateRateParameters* AnimUpdateRateParams = Mesh->AnimUpdateRateParams;
+		AnimUpdateRateParams->bShouldUseLodMap = true;
+		AnimUpdateRateParams->LODToFrameSkipMap.Reset();
+		for (int32 LODIndex = 0; LODIndex < Mesh->GetNumLODs(); LODIndex++)
+		{
+			AnimUpdateRateParams->LODToFrameSkipMap.Add(LODIndex, TierSettings.AnimFramesToSkip);
+		}
+
+		// Skipped frames are interpolated only when evaluation rate is lower than this value
+		AnimUpdateRateParams->MaxEvalRateForInterpolation = TierSettings.bInterpolateSkippedFrames ? TierSettings.AnimFramesToSkip + 2 : 1;
+	}
+
+	Character->GetCharacterMovement()->SetComponentTickInterval(TierSettings.MovementTickInterval);
+	UpdateMovementMode(Character);
+
+	if (Character->GetInformationBar() != NULL)
+	{
+		Character->GetInformationBar()->SetVisibility(TierSettings.bShowInformationBar);
+	}
+
+	if (ANoxAIController* AIController = Cast<ANoxAIController>(Character->GetController()))
+	{
+		AIController->SetSightEnabled(TierSettings.bUpdatePerception);
+	}
+}
+
+void FNoxSignificance::UpdateMovementMode(ANoxCharacter* Character)
+{
+	// Movement mode is replicated, clients only change visual details of the tier
+	if (!Character->HasAuthority())
+	{
+		return;
+	}
+
+	const FNoxSignificanceTierSettings& TierSettings = GetDefault<UNoxSignificanceSettings>()->GetTierSettings(Character->GetSignificanceTier());
+
+	// Full movement is needed as soon as NPC fights, even if it is far from the camera
+	const ANoxAIController* AIController = Cast<ANoxAIController>(Character->GetController());
+	const bool bIsEngaged = AIController != NULL && AIController->IsEngaged();
+
+	Character->SetNavWalkingEnabled(TierSettings.bUseNavWalking && !bIsEngaged && !Character->IsPlayerControlled());
+}
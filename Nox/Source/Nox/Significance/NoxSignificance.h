@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "NoxSignificance.generated.h"
+
+
+UENUM(BlueprintType)
+enum class ENoxSignificanceTier : uint8
+{
+	ST_High		UMETA(DisplayName = "High"),
+	ST_Medium	UMETA(DisplayName = "Medium"),
+	ST_Low		UMETA(DisplayName = "Low"),
+	ST_Lowest	UMETA(DisplayName = "Lowest"),
+	ST_MAX		UMETA(Hidden)
+};
+
+USTRUCT(BlueprintType)
+struct FNoxSignificanceTierSettings
+{
+	GENERATED_BODY()
+
+	// Tier is used while distance to the camera is lower than this value
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		float MaxDistance = 1500.f;
+
+	// Number of frames skipped between animation updates (0 - update every frame)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		int32 AnimFramesToSkip = 0;
+
+	// Interpolate pose on skipped animation frames
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		bool bInterpolateSkippedFrames = true;
+
+	// Should AI controller of this character keep updating sight perception
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		bool bUpdatePerception = true;
+
+	// Character movement tick interval (0 - every frame)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		float MovementTickInterval = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		bool bShowInformationBar = true;
+
+	// Move NPC on navmesh without floor sweeps (MOVE_NavWalking). Not used while its AI controller is engaged in combat.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		bool bUseNavWalking = false;
+};
+
+/**
+ * Tiers used to scale down work of NPCs that are far from the camera or not visible.
+ * Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Significance"))
+class NOX_API UNoxSignificanceSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxSignificanceSettings();
+
+	// Settings for every ENoxSignificanceTier, ordered from High to Lowest
+	UPROPERTY(config, EditAnywhere, Category = "Tiers")
+		TArray<FNoxSignificanceTierSettings> Tiers;
+
+	// Distance past tier border that has to be crossed before tier changes. Stops characters on the border from switching every frame.
+	UPROPERTY(config, EditAnywhere, Category = "Tiers")
+		float HysteresisDistance;
+
+	// Character that was not rendered recently is treated as if it was this many times farther away
+	UPROPERTY(config, EditAnywhere, Category = "Visibility")
+		float NotRenderedDistanceScale;
+
+	// Time in seconds after last render during which character still counts as visible
+	UPROPERTY(config, EditAnywhere, Category = "Visibility")
+		float RecentlyRenderedTime;
+
+	// Nothing is rendered on dedicated server. Bones are still refreshed during hit windows, because attacks trace from sockets.
+	UPROPERTY(config, EditAnywhere, Category = "Dedicated Server")
+		TEnumAsByte<EVisibilityBasedAnimTickOption::Type> DedicatedServerAnimTickOption;
+
+	const FNoxSignificanceTierSettings& GetTierSettings(ENoxSignificanceTier Tier) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+/// FNoxSignificance
+///////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Glue between ANoxCharacter and the engine Significance Manager.
+ * NPCs are scored by distance and visibility from player viewpoints and sorted into ENoxSignificanceTier.
+ */
+class NOX_API FNoxSignificance
+{
+public:
+	static const FName CharacterTag;
+
+	static void RegisterCharacter(class ANoxCharacter* Character);
+
+	static void UnregisterCharacter(class ANoxCharacter* Character);
+
+	// Update significance of all registered characters. Called once per frame by local player controller on clients, or by game mode on server.
+	static void Update(UWorld* World, TArrayView<const FTransform> Viewpoints);
+
+	// Apply settings of given tier to character components and its AI controller
+	static void ApplyTier(class ANoxCharacter* Character, ENoxSignificanceTier Tier);
+
+	// Switch between full and navmesh movement based on tier and combat state. Called again by AI controller when it engages or disengages. Authority only.
+	static void UpdateMovementMode(class ANoxCharacter* Character);
+};
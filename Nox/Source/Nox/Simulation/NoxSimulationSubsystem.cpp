@@ -0,0 +1,511 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxSimulationSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/NoxCharacter.h"
+#include "Nox/Weapons/Projectiles/NoxProjectileSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/World.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/WidgetComponent.h"
+#include "EngineUtils.h"
+#include "NavigationSystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxSimulationSettings
+//////////////////////////////////////////////////////////////////////////
+
+UNoxSimulationSettings::UNoxSimulationSettings()
+{
+	NumMatches = 10;
+	MaxMatchTime = 300.f;
+	TeamSeparation = 2500.f;
+	TeamSpawnRadius = 500.f;
+	TickRate = 30.f;
+	DamageBucketSize = 5.f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxSimulationSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+bool UNoxSimulationSubsystem::IsSimulationRun()
+{
+	static const bool bIsSimulationRun = FParse::Param(FCommandLine::Get(), TEXT("NoxSim"));
+
+	return bIsSimulationRun;
+}
+
+void UNoxSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsRunning = false;
+
+	if (!IsSimulationRun() || GetWorld() == NULL || !GetWorld()->IsGameWorld())
+	{
+		return;
+	}
+
+	const UNoxSimulationSettings* Settings = GetDefault<UNoxSimulationSettings>();
+
+	Seed = 0;
+	FParse::Value(FCommandLine::Get(), TEXT("NoxSimSeed="), Seed);
+
+	NumMatches = Settings->NumMatches;
+	FParse::Value(FCommandLine::Get(), TEXT("NoxSimMatches="), NumMatches);
+	NumMatches = FMath::Max(NumMatches, 1);
+
+	// Every frame advances simulated time by the same step and nothing waits for the frame rate limit
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FMath::Max(Settings->TickRate, 1.f));
+	GEngine->bUseFixedFrameRate = false;
+	GEngine->bSmoothFrameRate = false;
+
+	// Nobody watches. -nullrhi already skips rendering, this covers runs with a window too.
+	if (GEngine->GameViewport != NULL)
+	{
+		GEngine->GameViewport->bDisableWorldRendering = true;
+	}
+
+	if (IConsoleVariable* OcclusionQueries = IConsoleManager::Get().FindConsoleVariable(TEXT("r.AllowOcclusionQueries")))
+	{
+		OcclusionQueries->Set(0, ECVF_SetByCode);
+	}
+
+	MatchIndex = 0;
+	bIsMatchRunning = false;
+	MatchTime = 0.f;
+	SimulatedSeconds = 0.0;
+	WallStartTime = FPlatformTime::Seconds();
+	NumDraws = 0;
+
+	// One set of files per seed, so parallel processes never write to the same file
+	OutputPrefix = FPaths::ProfilingDir() / TEXT("NoxSim") / FString::Printf(TEXT("Seed-%d"), Seed);
+	FFileHelper::SaveStringToFile(TEXT("Seed,Match,WinnerTeam,Duration,SurvivorsByTeam\n"), *(OutputPrefix + TEXT("-Matches.csv")));
+	FFileHelper::SaveStringToFile(TEXT("Seed,Match,Team,Class,DeathTime,TimeToKill,HitsTaken\n"), *(OutputPrefix + TEXT("-Kills.csv")));
+	FFileHelper::SaveStringToFile(TEXT("Seed,Match,Time,AttackerTeam,AttackerClass,VictimTeam,Damage\n"), *(OutputPrefix + TEXT("-Hits.csv")));
+
+	bIsRunning = true;
+
+	UE_LOG(LogTemp, Log, TEXT("Simulation started: seed %d, %d matches, %.0f steps per simulated second"), Seed, NumMatches, Settings->TickRate);
+}
+
+void UNoxSimulationSubsystem::Deinitialize()
+{
+	// Process closed before the last match ended
+	if (bIsRunning)
+	{
+		WriteRows();
+		LogSummary();
+		bIsRunning = false;
+	}
+
+	Super::Deinitialize();
+}
+
+bool UNoxSimulationSubsystem::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && bIsRunning;
+}
+
+TStatId UNoxSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxSimulationSubsystem, STATGROUP_Nox);
+}
+
+void UNoxSimulationSubsystem::Tick(float DeltaTime)
+{
+	// Match starts one frame after the previous one was cleared, so destroyed characters are gone
+	if (!bIsMatchRunning)
+	{
+		StartMatch();
+		return;
+	}
+
+	MatchTime += DeltaTime;
+	SimulatedSeconds += DeltaTime;
+
+	for (FSimFighter& Fighter : Fighters)
+	{
+		if (Fighter.DeathTime < 0.f && (!Fighter.Character.IsValid() || !Fighter.Character->IsAlive()))
+		{
+			Fighter.DeathTime = MatchTime;
+
+			const float TimeToKill = Fighter.FirstHitTime >= 0.f ? MatchTime - Fighter.FirstHitTime : 0.f;
+			TimesToKill.Add(TimeToKill);
+
+			KillRows += FString::Printf(TEXT("%d,%d,%d,%s,%.2f,%.2f,%d\n"), Seed, MatchIndex, Fighter.Team, *Fighter.ClassName.ToString(), Fighter.DeathTime, TimeToKill, Fighter.HitsTaken);
+		}
+	}
+
+	int32 NumTeamsAlive = 0;
+	const int32 WinnerTeam = FindWinnerTeam(NumTeamsAlive);
+
+	if (NumTeamsAlive <= 1)
+	{
+		EndMatch(WinnerTeam);
+	}
+	else if (MatchTime >= GetDefault<UNoxSimulationSettings>()->MaxMatchTime)
+	{
+		EndMatch(INDEX_NONE);
+	}
+}
+
+bool UNoxSimulationSubsystem::PrepareArena()
+{
+	const UNoxSimulationSettings* Settings = GetDefault<UNoxSimulationSettings>();
+
+	// NPC placed in the map gives default team class and center of the arena
+	ANoxCharacter* SourceNPC = NULL;
+	for (TActorIterator<ANoxCharacter> It(GetWorld()); It; ++It)
+	{
+		if (!It->IsPlayerControlled())
+		{
+			SourceNPC = *It;
+			break;
+		}
+	}
+
+	ArenaCenter = SourceNPC != NULL ? SourceNPC->GetActorLocation() : FVector::ZeroVector;
+
+	TArray<FNoxSimulationTeam> Teams = Settings->Teams;
+	if (Teams.Num() == 0)
+	{
+		Teams.AddDefaulted(2);
+	}
+
+	TeamClasses.Reset();
+	TeamSizes.Reset();
+
+	for (const FNoxSimulationTeam& Team : Teams)
+	{
+		// Loaded before the first match, hitches do not matter here
+		UClass* TeamClass = Team.CharacterClass.IsNull() ? (SourceNPC != NULL ? SourceNPC->GetClass() : NULL) : Team.CharacterClass.LoadSynchronous();
+		if (TeamClass == NULL)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Simulation can not resolve class of team %d. Set it in Nox Simulation settings or place an NPC in the map."), TeamClasses.Num());
+			return false;
+		}
+
+		TeamClasses.Add(TeamClass);
+		TeamSizes.Add(FMath::Max(Team.Size, 1));
+	}
+
+	// Characters placed in the map, player pawn included, would join the fight
+	for (TActorIterator<ANoxCharacter> It(GetWorld()); It; ++It)
+	{
+		AController* Controller = It->GetController();
+		It->Destroy();
+
+		if (Controller != NULL && !Controller->IsPlayerController())
+		{
+			Controller->Destroy();
+		}
+	}
+
+	WinsByTeam.Init(0, TeamClasses.Num());
+
+	return true;
+}
+
+void UNoxSimulationSubsystem::StartMatch()
+{
+	if (MatchIndex == 0 && !PrepareArena())
+	{
+		bIsRunning = false;
+		FPlatformMisc::RequestExit(false);
+		return;
+	}
+
+	// The same seed and match index give the same match, as far as async traces allow
+	const int32 MatchSeed = (int32)HashCombine(GetTypeHash(Seed), GetTypeHash(MatchIndex));
+	FMath::RandInit(MatchSeed);
+	FMath::SRandInit(MatchSeed);
+
+	// Team centers are placed on a circle, neighbouring teams are TeamSeparation apart
+	const int32 NumTeams = TeamClasses.Num();
+	const float CircleRadius = GetDefault<UNoxSimulationSettings>()->TeamSeparation / (2.f * FMath::Sin(PI / FMath::Max(NumTeams, 2)));
+
+	for (int32 Team = 0; Team < NumTeams; Team++)
+	{
+		const float Angle = 2.f * PI * Team / NumTeams;
+		SpawnTeam(Team, ArenaCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * CircleRadius);
+	}
+
+	MatchTime = 0.f;
+	bIsMatchRunning = true;
+
+	UE_LOG(LogTemp, Log, TEXT("Simulation match %d of %d started with %d characters"), MatchIndex + 1, NumMatches, Fighters.Num());
+}
+
+void UNoxSimulationSubsystem::SpawnTeam(const int32 Team, const FVector& TeamCenter)
+{
+	UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	UClass* TeamClass = TeamClasses[Team];
+
+	// Spawn location is on navmesh, capsule has to be above it
+	const ANoxCharacter* DefaultCharacter = TeamClass->GetDefaultObject<ANoxCharacter>();
+	const float SpawnHeight = DefaultCharacter->GetCapsuleComponent() != NULL ? DefaultCharacter->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() : 0.f;
+
+	FRotator SpawnRotation = (ArenaCenter - TeamCenter).Rotation();
+	SpawnRotation.Pitch = 0.f;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 Index = 0; Index < TeamSizes[Team]; Index++)
+	{
+		FVector SpawnLocation = TeamCenter;
+
+		FNavLocation NavLocation;
+		if (NavigationSystem != NULL && NavigationSystem->GetRandomPointInNavigableRadius(TeamCenter, GetDefault<UNoxSimulationSettings>()->TeamSpawnRadius, NavLocation))
+		{
+			SpawnLocation = NavLocation.Location;
+		}
+
+		ANoxCharacter* Character = GetWorld()->SpawnActor<ANoxCharacter>(TeamClass, SpawnLocation + FVector(0.f, 0.f, SpawnHeight), SpawnRotation, SpawnParameters);
+		if (Character == NULL)
+		{
+			continue;
+		}
+
+		if (Character->GetController() == NULL)
+		{
+			Character->SpawnDefaultController();
+		}
+
+		// Passed on to the AI controller
+		Character->SetGenericTeamId(FGenericTeamId((uint8)Team));
+
+		Character->OnTakeAnyDamage.AddDynamic(this, &UNoxSimulationSubsystem::OnFighterDamaged);
+
+		// Nobody looks at health bars
+		if (UWidgetComponent* InformationBar = Character->GetInformationBar())
+		{
+			InformationBar->SetVisibility(false);
+			InformationBar->SetComponentTickEnabled(false);
+		}
+
+		FSimFighter& Fighter = Fighters.AddDefaulted_GetRef();
+		Fighter.Character = Character;
+		Fighter.Team = Team;
+		Fighter.ClassName = TeamClass->GetFName();
+	}
+}
+
+void UNoxSimulationSubsystem::EndMatch(const int32 WinnerTeam)
+{
+	bIsMatchRunning = false;
+
+	if (WinnerTeam != INDEX_NONE)
+	{
+		WinsByTeam[WinnerTeam]++;
+	}
+	else
+	{
+		NumDraws++;
+	}
+
+	TArray<int32> SurvivorsByTeam;
+	SurvivorsByTeam.SetNumZeroed(TeamClasses.Num());
+	for (const FSimFighter& Fighter : Fighters)
+	{
+		if (Fighter.DeathTime < 0.f)
+		{
+			SurvivorsByTeam[Fighter.Team]++;
+		}
+	}
+
+	FString Survivors;
+	for (const int32 NumSurvivors : SurvivorsByTeam)
+	{
+		Survivors += Survivors.IsEmpty() ? FString::FromInt(NumSurvivors) : FString::Printf(TEXT(";%d"), NumSurvivors);
+	}
+
+	MatchRows += FString::Printf(TEXT("%d,%d,%d,%.2f,%s\n"), Seed, MatchIndex, WinnerTeam, MatchTime, *Survivors);
+
+	UE_LOG(LogTemp, Log, TEXT("Simulation match %d of %d ended after %.1f s, winner team %d, survivors %s"), MatchIndex + 1, NumMatches, MatchTime, WinnerTeam, *Survivors);
+
+	WriteRows();
+	ClearMatch();
+
+	MatchIndex++;
+	if (MatchIndex >= NumMatches)
+	{
+		LogSummary();
+		bIsRunning = false;
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UNoxSimulationSubsystem::ClearMatch()
+{
+	for (const FSimFighter& Fighter : Fighters)
+	{
+		if (Fighter.Character.IsValid())
+		{
+			AController* Controller = Fighter.Character->GetController();
+			Fighter.Character->Destroy();
+
+			if (Controller != NULL)
+			{
+				Controller->Destroy();
+			}
+		}
+	}
+	Fighters.Reset();
+
+	if (UNoxProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UNoxProjectileSubsystem>())
+	{
+		ProjectileSubsystem->ClearProjectiles();
+	}
+}
+
+int32 UNoxSimulationSubsystem::FindWinnerTeam(int32& OutNumTeamsAlive) const
+{
+	TArray<int32, TInlineAllocator<8>> AliveByTeam;
+	AliveByTeam.SetNumZeroed(TeamClasses.Num());
+
+	for (const FSimFighter& Fighter : Fighters)
+	{
+		if (Fighter.DeathTime < 0.f)
+		{
+			AliveByTeam[Fighter.Team]++;
+		}
+	}
+
+	int32 WinnerTeam = INDEX_NONE;
+	OutNumTeamsAlive = 0;
+
+	for (int32 Team = 0; Team < AliveByTeam.Num(); Team++)
+	{
+		if (AliveByTeam[Team] > 0)
+		{
+			OutNumTeamsAlive++;
+			WinnerTeam = Team;
+		}
+	}
+
+	return OutNumTeamsAlive == 1 ? WinnerTeam : INDEX_NONE;
+}
+
+UNoxSimulationSubsystem::FSimFighter* UNoxSimulationSubsystem::FindFighter(const AActor* Actor)
+{
+	if (Actor == NULL)
+	{
+		return NULL;
+	}
+
+	return Fighters.FindByPredicate([Actor](const FSimFighter& Fighter) { return Fighter.Character.Get() == Actor; });
+}
+
+void UNoxSimulationSubsystem::OnFighterDamaged(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
+{
+	FSimFighter* Victim = FindFighter(DamagedActor);
+	if (Victim == NULL || Victim->DeathTime >= 0.f)
+	{
+		return;
+	}
+
+	if (Victim->FirstHitTime < 0.f)
+	{
+		Victim->FirstHitTime = MatchTime;
+	}
+	Victim->HitsTaken++;
+
+	// Attacker is found by its pawn, team of a dead attacker is already cleared. Damage causer is the attacker or its weapon.
+	const FSimFighter* Attacker = FindFighter(InstigatedBy != NULL ? InstigatedBy->GetPawn() : NULL);
+	if (Attacker == NULL && DamageCauser != NULL)
+	{
+		Attacker = FindFighter(DamageCauser);
+		if (Attacker == NULL)
+		{
+			Attacker = FindFighter(DamageCauser->GetOwner());
+		}
+	}
+
+	const FName AttackerClassName = Attacker != NULL ? Attacker->ClassName : NAME_None;
+	HitDamageByClass.FindOrAdd(AttackerClassName).Add(Damage);
+
+	HitRows += FString::Printf(TEXT("%d,%d,%.2f,%d,%s,%d,%.2f\n"), Seed, MatchIndex, MatchTime, Attacker != NULL ? Attacker->Team : INDEX_NONE, *AttackerClassName.ToString(), Victim->Team, Damage);
+}
+
+void UNoxSimulationSubsystem::WriteRows()
+{
+	FFileHelper::SaveStringToFile(MatchRows, *(OutputPrefix + TEXT("-Matches.csv")), FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	FFileHelper::SaveStringToFile(KillRows, *(OutputPrefix + TEXT("-Kills.csv")), FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	FFileHelper::SaveStringToFile(HitRows, *(OutputPrefix + TEXT("-Hits.csv")), FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	MatchRows.Reset();
+	KillRows.Reset();
+	HitRows.Reset();
+}
+
+void UNoxSimulationSubsystem::LogSummary() const
+{
+	const double WallSeconds = FMath::Max(FPlatformTime::Seconds() - WallStartTime, 0.001);
+
+	UE_LOG(LogTemp, Log, TEXT("Simulation summary (seed %d): %d matches, %.1f simulated s in %.1f wall s, %.1f simulated seconds per wall second"),
+		Seed, MatchIndex, SimulatedSeconds, WallSeconds, SimulatedSeconds / WallSeconds);
+
+	const int32 NumPlayedMatches = FMath::Max(MatchIndex, 1);
+	for (int32 Team = 0; Team < WinsByTeam.Num(); Team++)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  Team %d (%s): %d wins, win rate %.1f%%"), Team, *TeamClasses[Team]->GetName(), WinsByTeam[Team], 100.f * WinsByTeam[Team] / NumPlayedMatches);
+	}
+	UE_LOG(LogTemp, Log, TEXT("  Draws: %d"), NumDraws);
+
+	if (TimesToKill.Num() > 0)
+	{
+		TArray<float> SortedTimesToKill = TimesToKill;
+		SortedTimesToKill.Sort();
+
+		float Sum = 0.f;
+		for (const float TimeToKill : SortedTimesToKill)
+		{
+			Sum += TimeToKill;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("  Time to kill: %d kills, mean %.2f s, median %.2f s, 90th percentile %.2f s"),
+			SortedTimesToKill.Num(), Sum / SortedTimesToKill.Num(), SortedTimesToKill[SortedTimesToKill.Num() / 2], SortedTimesToKill[(SortedTimesToKill.Num() * 9) / 10]);
+	}
+
+	// Damage of single hits per attacker class, bucketed
+	const float BucketSize = GetDefault<UNoxSimulationSettings>()->DamageBucketSize;
+	for (const auto& ClassDamage : HitDamageByClass)
+	{
+		const TArray<float>& Hits = ClassDamage.Value;
+
+		float Sum = 0.f;
+		float MinDamage = BIG_NUMBER;
+		float MaxDamage = 0.f;
+		TMap<int32, int32> Buckets;
+
+		for (const float Damage : Hits)
+		{
+			Sum += Damage;
+			MinDamage = FMath::Min(MinDamage, Damage);
+			MaxDamage = FMath::Max(MaxDamage, Damage);
+			Buckets.FindOrAdd(FMath::FloorToInt(Damage / BucketSize))++;
+		}
+
+		Buckets.KeySort(TLess<int32>());
+
+		FString Histogram;
+		for (const auto& Bucket : Buckets)
+		{
+			Histogram += FString::Printf(TEXT(" [%.0f-%.0f):%d"), Bucket.Key * BucketSize, (Bucket.Key + 1) * BucketSize, Bucket.Value);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("  Damage by %s: %d hits, mean %.1f, min %.1f, max %.1f,%s"),
+			*ClassDamage.Key.ToString(), Hits.Num(), Hits.Num() > 0 ? Sum / Hits.Num() : 0.f, MinDamage, MaxDamage, *Histogram);
+	}
+}
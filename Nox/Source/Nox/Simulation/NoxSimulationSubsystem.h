@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/DeveloperSettings.h"
+#include "NoxSimulationSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FNoxSimulationTeam
+{
+	GENERATED_BODY()
+
+	// Character spawned for every member of the team. Empty - class of the first NPC placed in the map.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config)
+		TSoftClassPtr<class ANoxCharacter> CharacterClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, config, meta = (ClampMin = "1"))
+		int32 Size = 5;
+};
+
+/**
+ * Headless AI vs AI battles used to balance damage and AI. Values are set in DefaultGame.ini.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Nox Simulation"))
+class NOX_API UNoxSimulationSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNoxSimulationSettings();
+
+	// Every team gets its own FGenericTeamId, starting at 0
+	UPROPERTY(config, EditAnywhere, Category = "Match")
+		TArray<FNoxSimulationTeam> Teams;
+
+	// Matches run by one process, can be changed with -NoxSimMatches=
+	UPROPERTY(config, EditAnywhere, Category = "Match", meta = (ClampMin = "1"))
+		int32 NumMatches;
+
+	// Match with survivors in more than one team after this time ends in a draw
+	UPROPERTY(config, EditAnywhere, Category = "Match")
+		float MaxMatchTime;
+
+	// Distance between spawn centers of neighbouring teams
+	UPROPERTY(config, EditAnywhere, Category = "Match")
+		float TeamSeparation;
+
+	// Members of a team are spawned at random navigable points within this radius of the team center
+	UPROPERTY(config, EditAnywhere, Category = "Match")
+		float TeamSpawnRadius;
+
+	// Fixed simulation step in frames per simulated second
+	UPROPERTY(config, EditAnywhere, Category = "Time", meta = (ClampMin = "1"))
+		float TickRate;
+
+	// Width of one bucket of the damage histogram in the summary
+	UPROPERTY(config, EditAnywhere, Category = "Results", meta = (ClampMin = "1"))
+		float DamageBucketSize;
+};
+
+/**
+ * Fast-forward battles between teams of AI characters.
+ * Enabled by -NoxSim, e.g. Nox Map -game -nullrhi -nosound -unattended -NoxSim -NoxSimSeed=7 -NoxSimMatches=20
+ * Runs with fixed time step and no frame rate limit, so simulated time goes as fast as game thread allows. Independent seeds can run in parallel processes.
+ * Every match is written to Saved/Profiling/NoxSim/Seed-*-Matches.csv, deaths to *-Kills.csv and hits to *-Hits.csv. Summary of the process is logged at the end.
+ */
+UCLASS()
+class NOX_API UNoxSimulationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	// Process was started with -NoxSim. Systems that depend on the camera (significance, UI) stay off.
+	static bool IsSimulationRun();
+
+private:
+	struct FSimFighter
+	{
+		TWeakObjectPtr<class ANoxCharacter> Character;
+		int32 Team = 0;
+		FName ClassName;
+		float FirstHitTime = -1.f;
+		float DeathTime = -1.f;
+		int32 HitsTaken = 0;
+	};
+
+	bool bIsRunning;
+
+	int32 Seed;
+	int32 NumMatches;
+	int32 MatchIndex;
+
+	bool bIsMatchRunning;
+	float MatchTime;
+
+	// Simulated and wall time of all matches, used for throughput
+	double SimulatedSeconds;
+	double WallStartTime;
+
+	// Team classes resolved at the first match
+	UPROPERTY()
+		TArray<UClass*> TeamClasses;
+
+	TArray<int32> TeamSizes;
+
+	// Spawn centers are placed around this point
+	FVector ArenaCenter;
+
+	TArray<FSimFighter> Fighters;
+
+	// Results of the whole process, logged by LogSummary()
+	TArray<int32> WinsByTeam;
+	int32 NumDraws;
+	TArray<float> TimesToKill;
+	TMap<FName, TArray<float>> HitDamageByClass;
+
+	// Rows of the current match, written to disk once the match ends
+	FString MatchRows;
+	FString KillRows;
+	FString HitRows;
+
+	FString OutputPrefix;
+
+	// Resolve team classes and remove characters placed in the map
+	bool PrepareArena();
+
+	void StartMatch();
+
+	void EndMatch(const int32 WinnerTeam);
+
+	// Destroy characters of the last match together with their controllers and projectiles
+	void ClearMatch();
+
+	void SpawnTeam(const int32 Team, const FVector& TeamCenter);
+
+	// @return - Team with survivors or INDEX_NONE if there is none or more than one
+	int32 FindWinnerTeam(int32& OutNumTeamsAlive) const;
+
+	FSimFighter* FindFighter(const AActor* Actor);
+
+	UFUNCTION()
+		void OnFighterDamaged(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
+
+	void WriteRows();
+
+	void LogSummary() const;
+};
@@ -6,21 +6,34 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Engine/Engine.h"
+#include "Nox/Combat/NoxAttackCatalog.h"
+#include "Nox/Nox.h"
 
 // Sets default values
 ABaseWeapon::ABaseWeapon()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+ 	// Weapon ticks only inside attack windows. Tick is turned on by OnWeaponAttackBegin() and off by OnWeaponAttackEnd().
 	PrimaryActorTick.bCanEverTick = true;		
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	// Can be damaged should be true only for characters and things that can be destroyed.
 	SetCanBeDamaged(false);		
 
+	// Spawned by server. Hidden state, collision and attachment to the owner are replicated, owner decides relevancy.
+	bReplicates = true;
+	SetReplicatingMovement(true);
+	bNetUseOwnerRelevancy = true;
+
 	// Create Weapon mesh component
 	WeaponMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("WeaponMesh"));
 	SetRootComponent(WeaponMesh);
 	WeaponMesh->SetCollisionProfileName(TEXT("OverlapAllDynamic")); // Change default collision profile for OverlapAllDynamic to avoiding collision with Owner 		
-	WeaponMesh->SetGenerateOverlapEvents(true);		
+
+	// Collision and overlaps are on only inside attack windows, see SetAttackCollisionEnabled().
+	// Physics state is kept while collision is off, so switching only updates filter data.
+	WeaponMesh->bAlwaysCreatePhysicsState = true;
+	WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	WeaponMesh->SetGenerateOverlapEvents(false);
 		
 	// Set default value for variable, weapon can't deal damage only when attacking 
 	bCanDealDamage = false;
@@ -30,6 +43,12 @@ ABaseWeapon::ABaseWeapon()
 
 	// Set default value indicating if function for melee attack is active
 	bIsMeleeAttackActive = false;
+
+	bIsWeaponActive = true;
+
+	ActiveAttackIndex = INDEX_NONE;
+	OwnerMesh = NULL;
+	OwnerCollisionSockets = NULL;
 }
 
 // Called when the game starts or when spawned
@@ -37,6 +56,10 @@ void ABaseWeapon::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// BP children can override collision of the mesh, weapon still starts without it
+	WeaponMesh->bAlwaysCreatePhysicsState = true;
+	SetAttackCollisionEnabled(false);
+
 	// Its here insted of in the constructor, because this class dont know anything about children BP classes made in Engine.
 	//      WeaponMesh->OnComponentBeginOverlap.AddDynamic(this, &ABaseWeapon::OnOverlap); // set up a notification for when this component statrs overlaping with something 	
 	//      WeaponMesh->OnComponentHit.AddDynamic(this, &ABaseWeapon::OnHit); // set up a notification for when this component hits something blocking		
@@ -51,10 +74,6 @@ void ABaseWeapon::Tick(float DeltaTime)
 	{
 		MeleeAttackBegin();
 	}	
-	else
-	{
-		MeleeAttackEnd();
-	}
 }
 
 float ABaseWeapon::CalculateFinalDamage(const float BaseDamage, const FAttackDamageParams& AttackDamageParams)
@@ -72,7 +91,7 @@ float ABaseWeapon::CalculateFinalDamage(const float BaseDamage, const FAttackDam
 }
 
 template <typename UObjectTemplate>
-void ABaseWeapon::CreateCollisionByPointLocation(UObjectTemplate* InEventInstigator, TArray<FHitResult>& OutHits, const FMeleeCollisionParams& InCollisionParams, const TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToCollideWith, const TArray<AActor*> ActorsToIgnore, const TArray<FVector> InPointLocations)
+void ABaseWeapon::CreateCollisionByPointLocation(UObjectTemplate* InEventInstigator, TArray<FHitResult>& OutHits, const FMeleeCollisionParams& InCollisionParams, const TArray<TEnumAsByte<EObjectTypeQuery>>& ObjectTypesToCollideWith, const TArray<AActor*>& ActorsToIgnore, const TArray<FVector>& InPointLocations, const float InExtraAttackRange)
 {
 	FVector StartLocation;
 	FVector EndLocation;
@@ -101,7 +120,7 @@ void ABaseWeapon::CreateCollisionByPointLocation(UObjectTemplate* InEventInstiga
 					FVector ForwardVector = UKismetMathLibrary::GetDirectionUnitVector(StartLocation, EndLocation);
 
 					// Change location of a last point in array to extend range  
-					EndLocation += ForwardVector * InCollisionParams.AdditionalAttackRange;						
+					EndLocation += ForwardVector * (InCollisionParams.AdditionalAttackRange + InExtraAttackRange);						
 				}
 
 				if (InCollisionParams.bUseUniversalHight)
@@ -120,7 +139,11 @@ void ABaseWeapon::CreateCollisionByPointLocation(UObjectTemplate* InEventInstiga
 				ObjectTypesToCollideWith,
 				false,
 				ActorsToIgnore,
+#if NOX_DRAW_DEBUG
 				InCollisionParams.DrawDebugTrace,
+#else
+				EDrawDebugTrace::None,
+#endif
 				OUT HitResults,
 				true
 			);			
@@ -136,23 +159,33 @@ void ABaseWeapon::CreateCollisionByPointLocation(UObjectTemplate* InEventInstiga
 
 void ABaseWeapon::MeleeAttackBegin()
 {
-	if (MeleeWeaponCollision.MeleeCollisionType == EMeleeCollisionType::MCT_CollisionByObject)
+	const FNoxAttackDefinition* ActiveAttack = GetActiveAttack();
+	if (ActiveAttack == NULL)
+	{
+		return;
+	}
+
+	const EMeleeCollisionType MeleeCollisionType = GetActiveMeleeCollisionType();
+	if (MeleeCollisionType == EMeleeCollisionType::MCT_CollisionByObject)
 	{
 		bCanDealDamage = true;
 	}
-	else if (MeleeWeaponCollision.MeleeCollisionType == EMeleeCollisionType::MCT_CollisionBySocketsLocations)
+	else if (MeleeCollisionType == EMeleeCollisionType::MCT_CollisionBySocketsLocations)
 	{
 		// Create array that contain sockets location. If attack does't use hands socket for collision HandCollisionSocketsLocation will be empty;
 		TArray<FVector> CollisionSocketsLocations;		
 		
-		for (const auto& HandCollisionSocket : MeleeCollisionParams.CollisionSockets)
+		if (OwnerMesh != NULL && OwnerCollisionSockets != NULL)
 		{
-			if (MeleeCollisionParams.OwnerMesh->DoesSocketExist(HandCollisionSocket))
+			for (const auto& HandCollisionSocket : *OwnerCollisionSockets)
 			{
-				FVector SocketLocation = MeleeCollisionParams.OwnerMesh->GetSocketLocation(HandCollisionSocket);
-				CollisionSocketsLocations.AddUnique(SocketLocation);
-			}
-		}			
+				if (OwnerMesh->DoesSocketExist(HandCollisionSocket))
+				{
+					FVector SocketLocation = OwnerMesh->GetSocketLocation(HandCollisionSocket);
+					CollisionSocketsLocations.AddUnique(SocketLocation);
+				}
+			}			
+		}
 
 		// Add to array locations of a weapon sockets
 		for (const auto& WeaponCollisionSocket : WeaponCollisionSockets)
@@ -164,14 +197,12 @@ void ABaseWeapon::MeleeAttackBegin()
 			}
 		}
 
-		// Include additional weapon range in attack collision params.	
-		MeleeCollisionParams.AdditionalAttackRange += MeleeWeaponCollision.AdditionalWeaponRange;
-
 		TArray<FHitResult> HitResults;
 
-		CreateCollisionByPointLocation<AActor>(GetInstigator(), OUT HitResults, MeleeCollisionParams, ObjectTypesToCollideWithWeapon, AttackedActorsWithWeapon, CollisionSocketsLocations);
+		// Include additional weapon range in attack collision.	
+		CreateCollisionByPointLocation<AActor>(GetInstigator(), OUT HitResults, ActiveAttack->MeleeCollisionParams, ObjectTypesToCollideWithWeapon, AttackedActorsWithWeapon, CollisionSocketsLocations, GetActiveAdditionalWeaponRange());
 
-		float FinalDamage = CalculateFinalDamage(WeaponDamage, AttackDamageParams);
+		float FinalDamage = CalculateFinalDamage(WeaponDamage, ActiveAttack->AttackDamageParams);
 
 		FDamageEvent DamageEvent;
 		
@@ -191,7 +222,61 @@ void ABaseWeapon::MeleeAttackEnd()
 {
 	AttackedActorsWithWeapon.Empty();
 	bCanDealDamage = false;
-	MeleeCollisionParams.CollisionSockets.Empty();
+	OwnerCollisionSockets = NULL;
+}
+
+void ABaseWeapon::SetActiveAttack(UNoxAttackCatalog* AttackCatalog, const int32 AttackIndex)
+{
+	ActiveAttackCatalog = AttackCatalog;
+	ActiveAttackIndex = AttackIndex;
+}
+
+const FNoxAttackDefinition* ABaseWeapon::GetActiveAttack() const
+{
+	if (ActiveAttackCatalog != NULL && ActiveAttackCatalog->IsValidAttackIndex(ActiveAttackIndex))
+	{
+		return &ActiveAttackCatalog->GetAttack(ActiveAttackIndex);
+	}
+
+	return NULL;
+}
+
+EMeleeCollisionType ABaseWeapon::GetActiveMeleeCollisionType() const
+{
+	const FNoxAttackDefinition* ActiveAttack = GetActiveAttack();
+	if (ActiveAttack != NULL && ActiveAttack->bOverrideMeleeCollisionParams && MeleeWeaponCollision.MeleeCollisionType == EMeleeCollisionType::MCT_CollisionByObject)
+	{
+		return EMeleeCollisionType::MCT_CollisionBySocketsLocations;
+	}
+
+	return MeleeWeaponCollision.MeleeCollisionType;
+}
+
+float ABaseWeapon::GetActiveAdditionalWeaponRange() const
+{
+	// Object collision has no range of its own
+	const FNoxAttackDefinition* ActiveAttack = GetActiveAttack();
+	if (ActiveAttack != NULL && ActiveAttack->bOverrideMeleeCollisionParams && MeleeWeaponCollision.MeleeCollisionType == EMeleeCollisionType::MCT_CollisionByObject)
+	{
+		return 0.f;
+	}
+
+	return MeleeWeaponCollision.AdditionalWeaponRange;
+}
+
+void ABaseWeapon::SetOwnerCollisionSockets(USkeletalMeshComponent* InOwnerMesh, const TArray<FName>* InOwnerCollisionSockets)
+{
+	OwnerMesh = InOwnerMesh;
+	OwnerCollisionSockets = InOwnerCollisionSockets;
+}
+
+void ABaseWeapon::SetAttackCollisionEnabled(const bool bEnabled)
+{
+	WeaponMesh->SetCollisionEnabled(bEnabled ? ECollisionEnabled::QueryOnly : ECollisionEnabled::NoCollision);
+	WeaponMesh->SetGenerateOverlapEvents(bEnabled);
+
+	// Begin overlap with actors that weapon is already inside of when window opens, or clear overlaps when it closes
+	WeaponMesh->UpdateOverlaps();
 }
 
 void ABaseWeapon::OnWeaponAttackBegin()
@@ -202,6 +287,27 @@ void ABaseWeapon::OnWeaponAttackEnd()
 {
 }
 
+void ABaseWeapon::ActivateWeapon()
+{
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	bIsWeaponActive = true;
+}
+
+void ABaseWeapon::DeactivateWeapon()
+{
+	// Weapon can be parked in the middle of an attack window, so close it first
+	OnWeaponAttackEnd();
+	MeleeAttackEnd();
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	bIsWeaponActive = false;
+}
+
 void ABaseWeapon::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalIMpulse, const FHitResult& Hit)
 {
 }
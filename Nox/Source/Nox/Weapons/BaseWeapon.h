@@ -64,11 +64,6 @@ struct FMeleeCollisionParams
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (DisplayAfter = "DrawDebugTrace"))
 		float ColisionLineWidth = 0.05f;
-
-	// Mesh that contain those sockets
-	USkeletalMeshComponent* OwnerMesh;
-
-	TArray<FName> CollisionSockets;
 };
 
 USTRUCT(BlueprintType)
@@ -108,6 +103,9 @@ protected:
 
 	bool bIsMeleeAttackActive;
 
+	// False while weapon is parked in the owner's weapon pool
+	bool bIsWeaponActive;
+
 	// Array with Actors that had been damaged during time in one attack when damage could be dealt (CanDealDamage)
 	TArray<AActor*> AttackedActorsWithWeapon;
 
@@ -130,9 +128,35 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Melee Collision Sockets", AdvancedDisplay)
 		TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToCollideWithWeapon;	
 
-public:	
-	FAttackDamageParams AttackDamageParams;
-	FMeleeCollisionParams MeleeCollisionParams;	
+private:
+	// Catalog and index of the attack done with this weapon. Attack params are read from the catalog, never copied.
+	UPROPERTY()
+		class UNoxAttackCatalog* ActiveAttackCatalog;
+
+	int32 ActiveAttackIndex;
+
+protected:
+	// Mesh that contain owner collision sockets
+	USkeletalMeshComponent* OwnerMesh;
+
+	// Sockets of the owner (e.g. hands) used together with weapon sockets. Points to array owned by the character.
+	const TArray<FName>* OwnerCollisionSockets;
+
+public:
+	// Set attack that will be done with this weapon
+	void SetActiveAttack(class UNoxAttackCatalog* AttackCatalog, const int32 AttackIndex);
+
+	/** @return - Attack done with this weapon or NULL if there is none */
+	const struct FNoxAttackDefinition* GetActiveAttack() const;
+
+	/** Collision of the active attack. Attack that overrides collision params of weapon colliding by object collides by sockets locations, without weapon range.
+	*@note MeleeWeaponCollision itself is never changed, pooled weapon keeps designer values for the next attack
+	*/
+	EMeleeCollisionType GetActiveMeleeCollisionType() const;
+	float GetActiveAdditionalWeaponRange() const;
+
+	// Set owner sockets used to create collision line together with weapon sockets
+	void SetOwnerCollisionSockets(USkeletalMeshComponent* InOwnerMesh, const TArray<FName>* InOwnerCollisionSockets);
 
 public:	
 	// Called every frame
@@ -143,9 +167,9 @@ public:
 	
 	// TODO Fix Function
 	// Use sockets locations to create line trace collision (SphereTraceMultiForObjects)
-	
+	// InExtraAttackRange - Added to AdditionalAttackRange of InCollisionParams (e.g. range of a weapon)
 	template <typename UObjectTemplate>
-	static void CreateCollisionByPointLocation(UObjectTemplate* InEventInstigator, TArray<FHitResult>& OutHits, const FMeleeCollisionParams& InCollisionParams, const TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToCollideWith, const TArray<AActor*> ActorsToIgnore, const TArray<FVector> InPointLocations);
+	static void CreateCollisionByPointLocation(UObjectTemplate* InEventInstigator, TArray<FHitResult>& OutHits, const FMeleeCollisionParams& InCollisionParams, const TArray<TEnumAsByte<EObjectTypeQuery>>& ObjectTypesToCollideWith, const TArray<AActor*>& ActorsToIgnore, const TArray<FVector>& InPointLocations, const float InExtraAttackRange = 0.f);
 
 	UFUNCTION()
 	virtual void MeleeAttackBegin();
@@ -159,6 +183,19 @@ public:
 	UFUNCTION()
 	virtual void OnWeaponAttackEnd();
 
+	/** Turn on query collision and overlap events of the weapon mesh for an attack window, or turn them off.
+	*@note Only weapons that deal damage by overlaps need it, idle weapons do no overlap tests
+	*/
+	void SetAttackCollisionEnabled(const bool bEnabled);
+
+	// Take weapon out of the owner's pool: show it and turn its collision back on. Tick stays off until an attack window begins.
+	virtual void ActivateWeapon();
+
+	// Return weapon to the owner's pool: hide it, turn off collision and tick and stop any attack in progress
+	virtual void DeactivateWeapon();
+
+	FORCEINLINE bool IsWeaponActive() const { return bIsWeaponActive; }
+
 	/** called when weapon hits something */
 	UFUNCTION()
 	virtual void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalIMpulse, const FHitResult& Hit);
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxHitscanSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/DamageEvents.h"
+#include "GameFramework/Controller.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Rays Submitted"), STAT_NoxHitscanRaysSubmitted, STATGROUP_Nox);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Shots In Flight"), STAT_NoxHitscanShotsInFlight, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Hitscan Submit Rays"), STAT_NoxHitscanSubmitRays, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Hitscan Handle Hit"), STAT_NoxHitscanHandleHit, STATGROUP_Nox);
+
+void UNoxHitscanSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	NextShotId = 0;
+	TraceDelegate.BindUObject(this, &UNoxHitscanSubsystem::OnTraceCompleted);
+}
+
+void UNoxHitscanSubsystem::Deinitialize()
+{
+	PendingRays.Empty();
+	Shots.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UNoxHitscanSubsystem::IsTickable() const
+{
+	// Results are delivered by the trace delegate, tick is needed only to submit new rays
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && PendingRays.Num() > 0;
+}
+
+TStatId UNoxHitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxHitscanSubsystem, STATGROUP_Nox);
+}
+
+void UNoxHitscanSubsystem::Tick(float DeltaTime)
+{
+	NOX_HITCH_SCOPE(HS_Hitscan);
+
+	SubmitPendingRays();
+}
+
+void UNoxHitscanSubsystem::QueueShot(const FNoxHitscanParams& Params, const FVector& Start, const FVector& Direction, const float DamagePerRay, AActor* DamageCauser, AController* InstigatorController)
+{
+	const uint32 ShotId = NextShotId++;
+	const int32 NumRays = FMath::Max(Params.NumRays, 1);
+
+	FHitscanShot& Shot = Shots.Add(ShotId);
+	Shot.DamagePerRay = DamagePerRay;
+	Shot.DamageCauser = DamageCauser;
+	Shot.Instigator = InstigatorController;
+	Shot.RaysInFlight = NumRays;
+
+	for (const auto& ObjectType : Params.ObjectTypesToHit)
+	{
+		Shot.ObjectQueryParams.AddObjectTypesToQuery(UEngineTypes::ConvertToCollisionChannel(ObjectType));
+	}
+
+	const FVector ShotDirection = Direction.GetSafeNormal();
+	const float SpreadHalfAngle = FMath::DegreesToRadians(Params.SpreadAngle);
+
+	for (int32 RayIndex = 0; RayIndex < NumRays; RayIndex++)
+	{
+		const FVector RayDirection = SpreadHalfAngle > 0.f ? FMath::VRandCone(ShotDirection, SpreadHalfAngle) : ShotDirection;
+
+		FPendingRay& Ray = PendingRays.AddDefaulted_GetRef();
+		Ray.Start = Start;
+		Ray.End = Start + RayDirection * Params.Range;
+		Ray.ShotId = ShotId;
+	}
+}
+
+void UNoxHitscanSubsystem::SubmitPendingRays()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxHitscanSubmitRays);
+
+	UWorld* World = GetWorld();
+
+	// Async trace requests only go to the world's trace buffer. All rays of the frame run together as batched trace tasks.
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(NoxHitscanTrace), false);
+	const FHitscanShot* Shot = NULL;
+	uint32 ShotId = 0;
+
+	for (const FPendingRay& Ray : PendingRays)
+	{
+		// Rays of one shot are queued next to each other and share query params
+		if (Shot == NULL || Ray.ShotId != ShotId)
+		{
+			ShotId = Ray.ShotId;
+			Shot = &Shots.FindChecked(ShotId);
+
+			QueryParams.ClearIgnoredActors();
+
+			// Ray should not hit weapon that fired it or its owner
+			if (AActor* DamageCauser = Shot->DamageCauser.Get())
+			{
+				QueryParams.AddIgnoredActor(DamageCauser);
+
+				if (DamageCauser->GetInstigator() != NULL)
+				{
+					QueryParams.AddIgnoredActor(DamageCauser->GetInstigator());
+				}
+			}
+		}
+
+		World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Ray.Start, Ray.End, Shot->ObjectQueryParams, QueryParams, &TraceDelegate, Ray.ShotId);
+	}
+
+	SET_DWORD_STAT(STAT_NoxHitscanRaysSubmitted, PendingRays.Num());
+	SET_DWORD_STAT(STAT_NoxHitscanShotsInFlight, Shots.Num());
+
+	PendingRays.Reset();
+}
+
+void UNoxHitscanSubsystem::OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	FHitscanShot* Shot = Shots.Find(TraceDatum.UserData);
+	if (Shot == NULL)
+	{
+		return;
+	}
+
+	if (TraceDatum.OutHits.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NoxHitscanHandleHit);
+		NOX_HITCH_SCOPE(HS_Hitscan);
+
+		const FHitResult& Hit = TraceDatum.OutHits[0];
+		AActor* HitActor = Hit.GetActor();
+
+		if (HitActor != NULL && HitActor->CanBeDamaged() && Shot->DamagePerRay > 0.f)
+		{
+			const FVector ShotDirection = (TraceDatum.End - TraceDatum.Start).GetSafeNormal();
+			FPointDamageEvent DamageEvent(Shot->DamagePerRay, Hit, ShotDirection, nullptr);
+
+			HitActor->TakeDamage(Shot->DamagePerRay, DamageEvent, Shot->Instigator.Get(), Shot->DamageCauser.Get());
+		}
+	}
+
+	// TakeDamage() could queue new shots, so shot is searched again before it is removed
+	Shot = Shots.Find(TraceDatum.UserData);
+	if (Shot != NULL && --Shot->RaysInFlight <= 0)
+	{
+		Shots.Remove(TraceDatum.UserData);
+	}
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "NoxHitscanSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FNoxHitscanParams
+{
+	GENERATED_BODY()
+
+	// Max length of a ray
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		float Range = 3000.f;
+
+	// Rays fired by one shot (e.g. more than 1 for shotgun-like spread)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (ClampMin = "1"))
+		int32 NumRays = 1;
+
+	// Half angle of the spread cone in degrees (0 - every ray goes straight)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Meta = (ClampMin = "0", ClampMax = "90"))
+		float SpreadAngle = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, AdvancedDisplay)
+		TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToHit;
+};
+
+/**
+ * Resolves hitscan shots of all shooters with async line traces.
+ * Rays queued during a frame are submitted together in one pass, results come back next frame and hits are sent to TakeDamage() of the hit actor.
+ * Game thread never waits for a trace.
+ */
+UCLASS()
+class NOX_API UNoxHitscanSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	/** Queue shot, all its rays are traced with other rays queued this frame
+	*@param DamagePerRay - Damage dealt by every ray that hits
+	*@param DamageCauser - Actor passed to TakeDamage() as damage causer (e.g. weapon), ignored by the rays together with its instigator
+	*/
+	void QueueShot(const FNoxHitscanParams& Params, const FVector& Start, const FVector& Direction, const float DamagePerRay, AActor* DamageCauser, AController* InstigatorController);
+
+	FORCEINLINE int32 GetNumShotsInFlight() const { return Shots.Num(); }
+
+private:
+	struct FHitscanShot
+	{
+		FCollisionObjectQueryParams ObjectQueryParams;
+		float DamagePerRay;
+		TWeakObjectPtr<AActor> DamageCauser;
+		TWeakObjectPtr<AController> Instigator;
+
+		// Shot is forgotten when results of all its rays came back
+		int32 RaysInFlight;
+	};
+
+	struct FPendingRay
+	{
+		FVector Start;
+		FVector End;
+		uint32 ShotId;
+	};
+
+	TMap<uint32, FHitscanShot> Shots;
+
+	// Rays queued this frame, submitted in Tick()
+	TArray<FPendingRay> PendingRays;
+
+	uint32 NextShotId;
+
+	FTraceDelegate TraceDelegate;
+
+	void SubmitPendingRays();
+
+	void OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+};
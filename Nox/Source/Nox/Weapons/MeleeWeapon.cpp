@@ -4,6 +4,7 @@
 #include "MeleeWeapon.h"
 #include "Engine/Engine.h"
 #include "Components/StaticMeshComponent.h"
+#include "Nox/Combat/NoxAttackCatalog.h"
 
 AMeleeWeapon::AMeleeWeapon()
 {
@@ -32,19 +33,40 @@ void AMeleeWeapon::OnWeaponAttackBegin()
 {		
 	// Activate function MeleeAttackBegins (function is used in with tick)
 	bIsMeleeAttackActive = true;
+
+	// Overlaps that begin as soon as collision is turned on must already deal damage
+	if (GetActiveMeleeCollisionType() == EMeleeCollisionType::MCT_CollisionByObject)
+	{
+		bCanDealDamage = GetActiveAttack() != NULL;
+		SetAttackCollisionEnabled(true);
+	}
+
+	// Tick only for duration of the hit window
+	SetActorTickEnabled(true);
 }
 
 void AMeleeWeapon::OnWeaponAttackEnd()
 {
-	// Activate function MeleeAttackEnd (function is used in with tick)
 	bIsMeleeAttackActive = false;
+
+	if (GetWeaponMesh()->GetGenerateOverlapEvents())
+	{
+		SetAttackCollisionEnabled(false);
+	}
+
+	// Clean up after attack once, instead of every frame while weapon is idle
+	MeleeAttackEnd();
+
+	SetActorTickEnabled(false);
 }
 
 void AMeleeWeapon::OnOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
-	if (OtherActor != GetInstigator() && bCanDealDamage)
+	const FNoxAttackDefinition* ActiveAttack = GetActiveAttack();
+
+	if (OtherActor != GetInstigator() && bCanDealDamage && ActiveAttack != NULL)
 	{		
-		float FinalDamage = CalculateFinalDamage(WeaponDamage, AttackDamageParams);		
+		float FinalDamage = CalculateFinalDamage(WeaponDamage, ActiveAttack->AttackDamageParams);		
 
 		FDamageEvent DamageEvent;
 	
@@ -0,0 +1,437 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoxProjectileSubsystem.h"
+#include "Nox/Nox.h"
+#include "Nox/Diagnostics/NoxHitchWatchdogSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/DamageEvents.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Projectiles"), STAT_NoxLiveProjectiles, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Integrate"), STAT_NoxProjectilesIntegrate, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Submit Sweeps"), STAT_NoxProjectilesSubmitSweeps, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Update Instances"), STAT_NoxProjectilesUpdateInstances, STATGROUP_Nox);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Handle Hit"), STAT_NoxProjectilesHandleHit, STATGROUP_Nox);
+
+//////////////////////////////////////////////////////////////////////////
+// FProjectileBatch
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxProjectileSubsystem::FProjectileBatch::Add(const uint32 Id, const FVector& Location, const FVector& Velocity, const float InDamage, AActor* DamageCauser, AController* InstigatorController)
+{
+	IndexById.Add(Id, Ids.Num());
+
+	PositionX.Add(Location.X);
+	PositionY.Add(Location.Y);
+	PositionZ.Add(Location.Z);
+	PreviousPositionX.Add(Location.X);
+	PreviousPositionY.Add(Location.Y);
+	PreviousPositionZ.Add(Location.Z);
+	VelocityX.Add(Velocity.X);
+	VelocityY.Add(Velocity.Y);
+	VelocityZ.Add(Velocity.Z);
+	Lifetime.Add(0.f);
+	Damage.Add(InDamage);
+	Ids.Add(Id);
+	DamageCausers.Add(DamageCauser);
+	Instigators.Add(InstigatorController);
+}
+
+void UNoxProjectileSubsystem::FProjectileBatch::RemoveAtSwap(const int32 Index)
+{
+	IndexById.Remove(Ids[Index]);
+
+	// Last projectile is moved into removed slot
+	if (Index != Ids.Num() - 1)
+	{
+		IndexById.Add(Ids.Last(), Index);
+	}
+
+	PositionX.RemoveAtSwap(Index, 1, false);
+	PositionY.RemoveAtSwap(Index, 1, false);
+	PositionZ.RemoveAtSwap(Index, 1, false);
+	PreviousPositionX.RemoveAtSwap(Index, 1, false);
+	PreviousPositionY.RemoveAtSwap(Index, 1, false);
+	PreviousPositionZ.RemoveAtSwap(Index, 1, false);
+	VelocityX.RemoveAtSwap(Index, 1, false);
+	VelocityY.RemoveAtSwap(Index, 1, false);
+	VelocityZ.RemoveAtSwap(Index, 1, false);
+	Lifetime.RemoveAtSwap(Index, 1, false);
+	Damage.RemoveAtSwap(Index, 1, false);
+	Ids.RemoveAtSwap(Index, 1, false);
+	DamageCausers.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+}
+
+void UNoxProjectileSubsystem::FProjectileBatch::Reset()
+{
+	PositionX.Reset();
+	PositionY.Reset();
+	PositionZ.Reset();
+	PreviousPositionX.Reset();
+	PreviousPositionY.Reset();
+	PreviousPositionZ.Reset();
+	VelocityX.Reset();
+	VelocityY.Reset();
+	VelocityZ.Reset();
+	Lifetime.Reset();
+	Damage.Reset();
+	Ids.Reset();
+	DamageCausers.Reset();
+	Instigators.Reset();
+	IndexById.Reset();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UNoxProjectileSubsystem
+//////////////////////////////////////////////////////////////////////////
+
+void UNoxProjectileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	NextProjectileSerial = 0;
+	SweepDelegate.BindUObject(this, &UNoxProjectileSubsystem::OnSweepCompleted);
+}
+
+void UNoxProjectileSubsystem::Deinitialize()
+{
+	ClearProjectiles();
+	Batches.Empty();
+	RenderActor = NULL;
+
+	Super::Deinitialize();
+}
+
+bool UNoxProjectileSubsystem::IsTickable() const
+{
+	// Nothing to do without projectiles
+	return !IsTemplate() && GetWorld() != NULL && GetWorld()->IsGameWorld() && GetNumProjectiles() > 0;
+}
+
+TStatId UNoxProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoxProjectileSubsystem, STATGROUP_Nox);
+}
+
+void UNoxProjectileSubsystem::Tick(float DeltaTime)
+{
+	NOX_HITCH_SCOPE(HS_Projectiles);
+
+	const float GravityZ = GetWorld()->GetGravityZ();
+
+	for (FProjectileBatch& Batch : Batches)
+	{
+		if (Batch.Num() > 0)
+		{
+			Integrate(Batch, DeltaTime, GravityZ);
+			SubmitSweeps(Batch);
+		}
+
+		UpdateInstances(Batch);
+	}
+
+	SET_DWORD_STAT(STAT_NoxLiveProjectiles, GetNumProjectiles());
+}
+
+int32 UNoxProjectileSubsystem::RegisterProjectileType(const FNoxProjectileParams& Params)
+{
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); BatchIndex++)
+	{
+		const FNoxProjectileParams& BatchParams = Batches[BatchIndex].Params;
+
+		// Speed is used only when projectile is spawned, so it does not make a new type
+		if (BatchParams.Mesh == Params.Mesh && BatchParams.GravityScale == Params.GravityScale && BatchParams.CollisionRadius == Params.CollisionRadius
+			&& BatchParams.MaxLifetime == Params.MaxLifetime && BatchParams.ObjectTypesToHit == Params.ObjectTypesToHit)
+		{
+			return BatchIndex;
+		}
+	}
+
+	// Batch index has to fit in the highest byte of projectile id
+	if (Batches.Num() > 0xFF)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Too many projectile types registered"));
+		return INDEX_NONE;
+	}
+
+	FProjectileBatch& Batch = Batches.AddDefaulted_GetRef();
+	Batch.Params = Params;
+
+	for (const auto& ObjectType : Params.ObjectTypesToHit)
+	{
+		Batch.ObjectQueryParams.AddObjectTypesToQuery(UEngineTypes::ConvertToCollisionChannel(ObjectType));
+	}
+
+	// Dedicated server only simulates projectiles, nobody sees them
+	if (Params.Mesh != NULL && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		if (RenderActor == NULL)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.ObjectFlags |= RF_Transient;
+			RenderActor = GetWorld()->SpawnActor<AActor>(SpawnParams);
+
+			USceneComponent* RenderRoot = NewObject<USceneComponent>(RenderActor, TEXT("ProjectilesRoot"));
+			RenderActor->SetRootComponent(RenderRoot);
+			RenderRoot->RegisterComponent();
+		}
+
+		// Instances are in world space and never collide, collision is done by sweeps
+		Batch.Instances = NewObject<UInstancedStaticMeshComponent>(RenderActor);
+		Batch.Instances->SetStaticMesh(Params.Mesh);
+		Batch.Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Batch.Instances->SetGenerateOverlapEvents(false);
+		Batch.Instances->SetCastShadow(false);
+		Batch.Instances->SetupAttachment(RenderActor->GetRootComponent());
+		Batch.Instances->RegisterComponent();
+	}
+
+	return Batches.Num() - 1;
+}
+
+void UNoxProjectileSubsystem::SpawnProjectile(const int32 ProjectileType, const FVector& Location, const FVector& Direction, const float Damage, AActor* DamageCauser, AController* InstigatorController)
+{
+	if (!Batches.IsValidIndex(ProjectileType))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Projectile type %d is not registered"), ProjectileType);
+		return;
+	}
+
+	FProjectileBatch& Batch = Batches[ProjectileType];
+
+	const uint32 ProjectileId = MakeProjectileId(ProjectileType, NextProjectileSerial++);
+	Batch.Add(ProjectileId, Location, Direction.GetSafeNormal() * Batch.Params.Speed, Damage, DamageCauser, InstigatorController);
+}
+
+int32 UNoxProjectileSubsystem::GetNumProjectiles() const
+{
+	int32 NumProjectiles = 0;
+	for (const FProjectileBatch& Batch : Batches)
+	{
+		NumProjectiles += Batch.Num();
+	}
+	return NumProjectiles;
+}
+
+void UNoxProjectileSubsystem::ClearProjectiles()
+{
+	for (FProjectileBatch& Batch : Batches)
+	{
+		Batch.Reset();
+		UpdateInstances(Batch);
+	}
+}
+
+void UNoxProjectileSubsystem::Integrate(FProjectileBatch& Batch, const float DeltaTime, const float GravityZ)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxProjectilesIntegrate);
+
+	const int32 NumProjectiles = Batch.Num();
+	const float VelocityChangeZ = GravityZ * Batch.Params.GravityScale * DeltaTime;
+
+	float* RESTRICT PositionX = Batch.PositionX.GetData();
+	float* RESTRICT PositionY = Batch.PositionY.GetData();
+	float* RESTRICT PositionZ = Batch.PositionZ.GetData();
+	const float* RESTRICT VelocityX = Batch.VelocityX.GetData();
+	const float* RESTRICT VelocityY = Batch.VelocityY.GetData();
+	float* RESTRICT VelocityZ = Batch.VelocityZ.GetData();
+	float* RESTRICT Lifetime = Batch.Lifetime.GetData();
+
+	// Current positions become start of the segment swept this frame
+	FMemory::Memcpy(Batch.PreviousPositionX.GetData(), PositionX, NumProjectiles * sizeof(float));
+	FMemory::Memcpy(Batch.PreviousPositionY.GetData(), PositionY, NumProjectiles * sizeof(float));
+	FMemory::Memcpy(Batch.PreviousPositionZ.GetData(), PositionZ, NumProjectiles * sizeof(float));
+
+	// Plain loops over contiguous floats, so compiler can vectorize them
+	for (int32 Index = 0; Index < NumProjectiles; Index++)
+	{
+		VelocityZ[Index] += VelocityChangeZ;
+	}
+
+	for (int32 Index = 0; Index < NumProjectiles; Index++)
+	{
+		PositionX[Index] += VelocityX[Index] * DeltaTime;
+		PositionY[Index] += VelocityY[Index] * DeltaTime;
+		PositionZ[Index] += VelocityZ[Index] * DeltaTime;
+	}
+
+	for (int32 Index = 0; Index < NumProjectiles; Index++)
+	{
+		Lifetime[Index] += DeltaTime;
+	}
+
+	// Remove projectiles that lived too long. Going backwards, so swapped in projectile is already checked.
+	for (int32 Index = NumProjectiles - 1; Index >= 0; Index--)
+	{
+		if (Batch.Lifetime[Index] > Batch.Params.MaxLifetime)
+		{
+			Batch.RemoveAtSwap(Index);
+		}
+	}
+}
+
+void UNoxProjectileSubsystem::SubmitSweeps(FProjectileBatch& Batch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxProjectilesSubmitSweeps);
+
+	UWorld* World = GetWorld();
+	const FCollisionShape CollisionShape = FCollisionShape::MakeSphere(Batch.Params.CollisionRadius);
+
+	// Built once per batch, only ignored actors differ between projectiles
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(NoxProjectileSweep), false);
+
+	for (int32 Index = 0; Index < Batch.Num(); Index++)
+	{
+		QueryParams.ClearIgnoredActors();
+
+		// Projectile should not hit weapon that fired it or its owner
+		if (AActor* DamageCauser = Batch.DamageCausers[Index].Get())
+		{
+			QueryParams.AddIgnoredActor(DamageCauser);
+
+			if (DamageCauser->GetInstigator() != NULL)
+			{
+				QueryParams.AddIgnoredActor(DamageCauser->GetInstigator());
+			}
+		}
+
+		const FVector Start(Batch.PreviousPositionX[Index], Batch.PreviousPositionY[Index], Batch.PreviousPositionZ[Index]);
+		const FVector End(Batch.PositionX[Index], Batch.PositionY[Index], Batch.PositionZ[Index]);
+
+		World->AsyncSweepByObjectType(EAsyncTraceType::Single, Start, End, FQuat::Identity, Batch.ObjectQueryParams, CollisionShape, QueryParams, &SweepDelegate, Batch.Ids[Index]);
+	}
+}
+
+void UNoxProjectileSubsystem::UpdateInstances(FProjectileBatch& Batch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoxProjectilesUpdateInstances);
+
+	if (Batch.Instances == NULL)
+	{
+		return;
+	}
+
+	const int32 NumProjectiles = Batch.Num();
+
+	// Instance index is the same as projectile index, only number of instances has to follow number of projectiles
+	for (int32 InstanceIndex = Batch.Instances->GetInstanceCount() - 1; InstanceIndex >= NumProjectiles; InstanceIndex--)
+	{
+		Batch.Instances->RemoveInstance(InstanceIndex);
+	}
+
+	if (NumProjectiles == 0)
+	{
+		return;
+	}
+
+	InstanceTransforms.SetNum(NumProjectiles, false);
+	for (int32 Index = 0; Index < NumProjectiles; Index++)
+	{
+		const FVector Velocity(Batch.VelocityX[Index], Batch.VelocityY[Index], Batch.VelocityZ[Index]);
+		InstanceTransforms[Index] = FTransform(Velocity.Rotation(), FVector(Batch.PositionX[Index], Batch.PositionY[Index], Batch.PositionZ[Index]));
+	}
+
+	for (int32 InstanceIndex = Batch.Instances->GetInstanceCount(); InstanceIndex < NumProjectiles; InstanceIndex++)
+	{
+		Batch.Instances->AddInstanceWorldSpace(InstanceTransforms[InstanceIndex]);
+	}
+
+	Batch.Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+}
+
+void UNoxProjectileSubsystem::OnSweepCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (TraceDatum.OutHits.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NoxProjectilesHandleHit);
+	NOX_HITCH_SCOPE(HS_Projectiles);
+
+	const uint32 ProjectileId = TraceDatum.UserData;
+	if (!Batches.IsValidIndex(GetBatchIndex(ProjectileId)))
+	{
+		return;
+	}
+
+	FProjectileBatch& Batch = Batches[GetBatchIndex(ProjectileId)];
+
+	// Projectile could expire or be cleared before result came back
+	const int32* FoundIndex = Batch.IndexById.Find(ProjectileId);
+	if (FoundIndex == NULL)
+	{
+		return;
+	}
+	const int32 Index = *FoundIndex;
+
+	const FHitResult& Hit = TraceDatum.OutHits[0];
+	AActor* HitActor = Hit.GetActor();
+	const float Damage = Batch.Damage[Index];
+
+	if (HitActor != NULL && HitActor->CanBeDamaged() && Damage > 0.f)
+	{
+		const FVector ShotDirection = FVector(Batch.VelocityX[Index], Batch.VelocityY[Index], Batch.VelocityZ[Index]).GetSafeNormal();
+		FPointDamageEvent DamageEvent(Damage, Hit, ShotDirection, nullptr);
+
+		HitActor->TakeDamage(Damage, DamageEvent, Batch.Instigators[Index].Get(), Batch.DamageCausers[Index].Get());
+	}
+
+	Batch.RemoveAtSwap(Index);
+
+	// Subsystem stops ticking without projectiles, instance of the last one would stay on screen
+	if (Batch.Num() == 0)
+	{
+		UpdateInstances(Batch);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Stress test
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	// Nox.Projectiles.Stress [Count] - spawn projectiles around first player in random directions. Use together with 'stat Nox'.
+	void SpawnStressTestProjectiles(const TArray<FString>& Args, UWorld* World)
+	{
+		UNoxProjectileSubsystem* ProjectileSubsystem = World != NULL ? World->GetSubsystem<UNoxProjectileSubsystem>() : NULL;
+		APlayerController* PlayerController = World != NULL ? World->GetFirstPlayerController() : NULL;
+		if (ProjectileSubsystem == NULL || PlayerController == NULL || PlayerController->GetPawn() == NULL)
+		{
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+
+		FNoxProjectileParams Params;
+		Params.Mesh = LoadObject<UStaticMesh>(NULL, TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+		Params.MaxLifetime = 10.f;
+		Params.GravityScale = 0.1f;
+		Params.ObjectTypesToHit.Add(UEngineTypes::ConvertToObjectType(ECC_WorldStatic));
+
+		const int32 ProjectileType = ProjectileSubsystem->RegisterProjectileType(Params);
+		const FVector Origin = PlayerController->GetPawn()->GetActorLocation() + FVector(0.f, 0.f, 200.f);
+
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			FVector Direction = FMath::VRand();
+			Direction.Z = FMath::Abs(Direction.Z);
+
+			ProjectileSubsystem->SpawnProjectile(ProjectileType, Origin, Direction, 0.f, NULL, NULL);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Spawned %d stress test projectiles, %d live"), Count, ProjectileSubsystem->GetNumProjectiles());
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs StressTestCommand(
+		TEXT("Nox.Projectiles.Stress"),
+		TEXT("Spawn projectiles around the player to stress test projectile simulation. Usage: Nox.Projectiles.Stress [Count=10000]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SpawnStressTestProjectiles));
+}
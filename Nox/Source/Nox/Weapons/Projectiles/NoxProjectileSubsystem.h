@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "NoxProjectileSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FNoxProjectileParams
+{
+	GENERATED_BODY()
+
+	// Mesh drawn for every projectile of this type (instanced)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		class UStaticMesh* Mesh = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		float Speed = 3000.f;
+
+	// 1 - projectile falls with world gravity, 0 - flies straight
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		float GravityScale = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		float CollisionRadius = 5.f;
+
+	// Projectile is removed after this time even if it did not hit anything
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+		float MaxLifetime = 5.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, AdvancedDisplay)
+		TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToHit;
+};
+
+/**
+ * Simulates all live projectiles of a world without spawning actors.
+ * Projectiles of the same type are stored in struct-of-arrays buffers, moved in one pass per frame and swept with batched async traces.
+ * Sweep results arrive next frame and hits are sent to TakeDamage() of the hit actor.
+ */
+UCLASS()
+class NOX_API UNoxProjectileSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	/** Projectiles with the same params share buffers and instanced mesh.
+	*@return - Type index passed to SpawnProjectile()
+	*/
+	int32 RegisterProjectileType(const FNoxProjectileParams& Params);
+
+	/** Add new projectile to the simulation
+	*@param DamageCauser - Actor passed to TakeDamage() as damage causer (e.g. weapon), ignored by the projectile sweeps together with its instigator
+	*/
+	void SpawnProjectile(const int32 ProjectileType, const FVector& Location, const FVector& Direction, const float Damage, AActor* DamageCauser, AController* InstigatorController);
+
+	int32 GetNumProjectiles() const;
+
+	// Remove all live projectiles
+	void ClearProjectiles();
+
+private:
+	struct FProjectileBatch
+	{
+		FNoxProjectileParams Params;
+		FCollisionObjectQueryParams ObjectQueryParams;
+		class UInstancedStaticMeshComponent* Instances = nullptr;
+
+		// Struct of arrays, index is the same in every array
+		TArray<float> PositionX, PositionY, PositionZ;
+		TArray<float> PreviousPositionX, PreviousPositionY, PreviousPositionZ;
+		TArray<float> VelocityX, VelocityY, VelocityZ;
+		TArray<float> Lifetime;
+		TArray<float> Damage;
+		TArray<uint32> Ids;
+		TArray<TWeakObjectPtr<AActor>> DamageCausers;
+		TArray<TWeakObjectPtr<AController>> Instigators;
+
+		// Dense index of projectile by its id, needed when sweep result comes back
+		TMap<uint32, int32> IndexById;
+
+		int32 Num() const { return Ids.Num(); }
+		void Add(const uint32 Id, const FVector& Location, const FVector& Velocity, const float InDamage, AActor* DamageCauser, AController* InstigatorController);
+		void RemoveAtSwap(const int32 Index);
+		void Reset();
+	};
+
+	TArray<FProjectileBatch> Batches;
+
+	// Actor owning instanced mesh components of all batches
+	UPROPERTY()
+		AActor* RenderActor;
+
+	uint32 NextProjectileSerial;
+
+	FTraceDelegate SweepDelegate;
+
+	// Reused every frame to upload instance transforms
+	TArray<FTransform> InstanceTransforms;
+
+	// Move every projectile of the batch in one pass over contiguous buffers
+	void Integrate(FProjectileBatch& Batch, const float DeltaTime, const float GravityZ);
+
+	// Queue async sweep from previous to current location of every projectile, results are handled in OnSweepCompleted() next frame
+	void SubmitSweeps(FProjectileBatch& Batch);
+
+	void UpdateInstances(FProjectileBatch& Batch);
+
+	void OnSweepCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	// Batch index is stored in the highest byte of projectile id
+	static uint32 MakeProjectileId(const int32 BatchIndex, const uint32 Serial) { return ((uint32)BatchIndex << 24) | (Serial & 0x00FFFFFF); }
+	static int32 GetBatchIndex(const uint32 ProjectileId) { return (int32)(ProjectileId >> 24); }
+};
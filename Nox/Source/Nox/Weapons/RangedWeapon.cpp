@@ -2,4 +2,70 @@
 
 
 #include "RangedWeapon.h"
+#include "Engine/World.h"
+#include "Components/StaticMeshComponent.h"
+#include "Nox/Combat/NoxAttackCatalog.h"
 
+ARangedWeapon::ARangedWeapon()
+{
+	MuzzleSocket = FName("Muzzle");
+
+	ProjectileParams.ObjectTypesToHit.Add(UEngineTypes::ConvertToObjectType(ECC_Pawn));
+	ProjectileParams.ObjectTypesToHit.Add(UEngineTypes::ConvertToObjectType(ECC_WorldStatic));
+
+	FireMode = ERangedFireMode::RFM_Projectile;
+
+	HitscanParams.ObjectTypesToHit = ProjectileParams.ObjectTypesToHit;
+
+	ProjectileType = INDEX_NONE;
+}
+
+void ARangedWeapon::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Weapons with the same params share one projectile type
+	UNoxProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UNoxProjectileSubsystem>();
+	if (FireMode == ERangedFireMode::RFM_Projectile && ProjectileSubsystem != NULL)
+	{
+		ProjectileType = ProjectileSubsystem->RegisterProjectileType(ProjectileParams);
+	}
+}
+
+void ARangedWeapon::OnWeaponAttackBegin()
+{
+	Fire();
+}
+
+void ARangedWeapon::Fire()
+{
+	// Simulated shots apply damage, so only server fires. Attack window begins on clients too.
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	const FNoxAttackDefinition* ActiveAttack = GetActiveAttack();
+	const float FinalDamage = ActiveAttack != NULL ? CalculateFinalDamage(WeaponDamage, ActiveAttack->AttackDamageParams) : WeaponDamage;
+
+	// Location of the mesh is used when muzzle socket does not exist
+	const FVector MuzzleLocation = GetWeaponMesh()->GetSocketLocation(MuzzleSocket);
+	const FVector Direction = GetInstigator() != NULL ? GetInstigator()->GetActorForwardVector() : GetActorForwardVector();
+
+	if (FireMode == ERangedFireMode::RFM_Hitscan)
+	{
+		// Rays are traced together with rays of all other shooters, result comes next frame
+		if (UNoxHitscanSubsystem* HitscanSubsystem = GetWorld()->GetSubsystem<UNoxHitscanSubsystem>())
+		{
+			HitscanSubsystem->QueueShot(HitscanParams, MuzzleLocation, Direction, FinalDamage, this, GetInstigatorController());
+		}
+	}
+	else
+	{
+		UNoxProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UNoxProjectileSubsystem>();
+		if (ProjectileSubsystem != NULL && ProjectileType != INDEX_NONE)
+		{
+			ProjectileSubsystem->SpawnProjectile(ProjectileType, MuzzleLocation, Direction, FinalDamage, this, GetInstigatorController());
+		}
+	}
+}
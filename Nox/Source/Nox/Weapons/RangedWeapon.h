@@ -4,14 +4,57 @@
 
 #include "CoreMinimal.h"
 #include "BaseWeapon.h"
+#include "Nox/Weapons/Projectiles/NoxProjectileSubsystem.h"
+#include "Nox/Weapons/Hitscan/NoxHitscanSubsystem.h"
 #include "RangedWeapon.generated.h"
 
+UENUM(BlueprintType)
+enum class ERangedFireMode : uint8
+{
+	// Fire projectile simulated by UNoxProjectileSubsystem
+	RFM_Projectile	UMETA(DisplayName = "Projectile"),
+	// Hit instantly with rays traced by UNoxHitscanSubsystem
+	RFM_Hitscan		UMETA(DisplayName = "Hitscan")
+};
+
 /**
- * 
+ * Weapon that fires projectiles or hitscan rays. No actor is spawned per shot.
  */
 UCLASS()
 class NOX_API ARangedWeapon : public ABaseWeapon
 {
 	GENERATED_BODY()
-	
+
+public:
+	ARangedWeapon();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	//
+
+	// Type of fired projectiles in projectile subsystem
+	int32 ProjectileType;
+
+public:
+	// Socket of weapon mesh where projectiles are spawned
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranged Weapon")
+		FName MuzzleSocket;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranged Weapon")
+		ERangedFireMode FireMode;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranged Weapon", Meta = (EditCondition = "FireMode == ERangedFireMode::RFM_Projectile"))
+		FNoxProjectileParams ProjectileParams;
+
+	// Damage of the attack is dealt by every ray that hits
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranged Weapon", Meta = (EditCondition = "FireMode == ERangedFireMode::RFM_Hitscan"))
+		FNoxHitscanParams HitscanParams;
+
+	// Fire once when attack window begins
+	virtual void OnWeaponAttackBegin() override;
+
+	// Fire from muzzle in the direction owner is facing. Does nothing without authority.
+	UFUNCTION(BlueprintCallable, Category = "Ranged Weapon")
+		void Fire();
 };